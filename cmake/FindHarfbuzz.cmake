@@ -7,5 +7,14 @@ FIND_LIBRARY(HARFBUZZ_LIBRARIES NAMES harfbuzz
   HINTS ${PC_HARFBUZZ_LIBRARY_DIRS} ${PC_HARFBUZZ_LIBDIR}
 )
 
+# hb-subset is optional, used for font subsetting when saving packages.
+FIND_PATH(HARFBUZZ_SUBSET_INCLUDE_DIRS NAMES hb-subset.h
+  HINTS ${PC_HARFBUZZ_INCLUDE_DIRS} ${PC_HARFBUZZ_INCLUDEDIR}
+)
+
+FIND_LIBRARY(HARFBUZZ_SUBSET_LIBRARIES NAMES harfbuzz-subset
+  HINTS ${PC_HARFBUZZ_LIBRARY_DIRS} ${PC_HARFBUZZ_LIBDIR}
+)
+
 INCLUDE(FindPackageHandleStandardArgs)
 FIND_PACKAGE_HANDLE_STANDARD_ARGS(HarfBuzz DEFAULT_MSG HARFBUZZ_INCLUDE_DIRS HARFBUZZ_LIBRARIES)
@@ -4,6 +4,7 @@
 #include <memory>
 #include <cairo/cairo.h>
 #include "ofd/Render.h"
+#include "ofd/ImageEncoder.h"
 
 class Stream;
 class GfxImageColorMap;
@@ -19,18 +20,26 @@ namespace ofd{
     public:
         //CairoRender();
         CairoRender(double pixelWidth, double pixelHeight, double resolutionX, double resolutionY);
-        //CairoRender(cairo_surface_t *surface);
+        // 绘制到调用者提供的表面（图像表面或PDF、SVG、PS等矢量表面），增加其引用计数。
+        // resolution为表面每英寸的设备单位数，PDF、SVG、PS表面取72。
+        CairoRender(cairo_surface_t *surface, double resolutionX, double resolutionY);
         virtual ~CairoRender();
 
         void Paint(cairo_surface_t *surface);
         bool WriteToPNG(const std::string &filename);
+        // 按params指定的格式写出图像表面。
+        bool WriteImage(const std::string &filename, const EncodeParams &params);
 
+        // 改变表面尺寸，表面借自SurfacePool，尺寸不变时等同于Reset()。
         void Rebuild(double pixelWidth, double pixelHeight, double resolutionX, double resolutionY);
+        // 为绘制下一页重置上下文（CTM、裁剪、pattern）并清为白色，保留表面和缓存。
+        void Reset();
         //void SetCairoSurface(cairo_surface_t *surface);
         cairo_surface_t *GetCairoSurface() const;
         cairo_t *GetCairoContext() const;
 
         virtual void DrawPage(PagePtr page, VisibleParams visibleParams) override;
+        virtual bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl) override;
         void DrawObject(ObjectPtr object);
 
         void SetLineWidth(double lineWidth);
@@ -0,0 +1,39 @@
+#ifndef __OFD_CAIROVECTORRENDER_H__
+#define __OFD_CAIROVECTORRENDER_H__
+
+#include <memory>
+#include <string>
+#include "ofd/Render.h"
+
+namespace ofd{
+
+    // ======== class CairoVectorRender ========
+    // 基于cairo PDF、SVG、PS表面的矢量输出。
+    //
+    // 每次DrawPage()输出一页，页面大小取页面区域乘以缩放比例（单位为点），
+    // 页面区域以毫米为单位，按实际大小输出时缩放比例取72.0 / 25.4。
+    // PDF、PS输出为单个文件，逐页写出，字体子集和图像在文件中只嵌入一次；
+    // SVG每页一个文件，第N页（N>0）的文件名在扩展名前加"_N"。
+    // 绘制完全部页面后调用Finish()，析构时未调用则自动调用。
+    class CairoVectorRender : public Render {
+    public:
+        CairoVectorRender(RenderType renderType, const std::string &filename);
+        virtual ~CairoVectorRender();
+
+        virtual void DrawPage(PagePtr page, VisibleParams visibleParams) override;
+        virtual bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl) override;
+
+        // 结束输出，写入字体等共享资源并关闭文件。
+        bool Finish();
+        size_t GetNumPages() const;
+
+    private:
+        class ImplCls;
+        std::unique_ptr<ImplCls> m_impl;
+
+    }; // class CairoVectorRender
+    typedef std::shared_ptr<CairoVectorRender> CairoVectorRenderPtr;
+
+}; // namespace ofd
+
+#endif // __OFD_CAIROVECTORRENDER_H__
@@ -0,0 +1,62 @@
+#ifndef __OFD_CODETOGIDMAP_H__
+#define __OFD_CODETOGIDMAP_H__
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ofd{
+
+    class CodeToGIDMap;
+    typedef std::shared_ptr<const CodeToGIDMap> CodeToGIDMapPtr;
+
+    // ======== class CodeToGIDMap ========
+    // 字符编码到字形编号的两级映射表。
+    // 编码按高位分页，每页PageSize项，全为0的页不分配，
+    // CJK字体稀疏的编码区间只占用实际用到的页。
+    // 编码不小于GetSize()时映射为编码本身，与原先的定长数组语义一致。
+    // 创建后只读，各线程可共享。
+    class CodeToGIDMap {
+        public:
+            static const int PageBits = 8;
+            static const uint32_t PageSize = 1 << PageBits;
+            // 编码为16位，超出的Size来自损坏或恶意的文档。
+            static const size_t MaxSize = 0x10000;
+
+            CodeToGIDMap();
+            ~CodeToGIDMap();
+
+            // 由定长数组创建，codeToGID[code]为字形编号。
+            static CodeToGIDMapPtr FromArray(const int *codeToGID, size_t size);
+
+            // 按"起始编码 起始字形编号 个数"三元组序列化，连续的编码到字形区间只占一组。
+            std::string ToString() const;
+            // size超过MaxSize或数据无效时返回nullptr。
+            static CodeToGIDMapPtr FromString(const std::string &str, size_t size);
+
+            uint32_t Lookup(uint32_t code) const{
+                if ( code >= m_size ) return code;
+                uint32_t pageIndex = code >> PageBits;
+                const uint16_t *page = m_pages[pageIndex];
+                return page != nullptr ? page[code & (PageSize - 1)] : 0;
+            }
+
+            size_t GetSize() const {return m_size;};
+            size_t GetNumPages() const;
+
+        private:
+            void resize(size_t size);
+            void set(uint32_t code, uint16_t gid);
+
+            size_t m_size;
+            std::vector<uint16_t*> m_pages;
+
+            CodeToGIDMap(const CodeToGIDMap&) = delete;
+            CodeToGIDMap& operator=(const CodeToGIDMap&) = delete;
+
+    }; // class CodeToGIDMap
+
+}; // namespace ofd
+
+#endif // __OFD_CODETOGIDMAP_H__
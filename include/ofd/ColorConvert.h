@@ -0,0 +1,85 @@
+#ifndef __OFD_COLORCONVERT_H__
+#define __OFD_COLORCONVERT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include "ofd/Color.h"
+
+namespace ofd{
+
+    // 绘制表面的像素为按平台字节序的32位整数，alpha在最高字节，R在最低字节、B在bits 16-23，
+    // 即小端内存中依次为R、G、B、A（与SDL的rmask 0x000000ff一致）。cairo按ARGB32解释时
+    // R、B互换，因此光栅绘制时颜色以(b, g, r)传给cairo。读写像素通道统一使用以下函数。
+    static inline uint32_t packSurfacePixel(uint32_t a, uint32_t r, uint32_t g, uint32_t b){
+        return (a << 24) | (b << 16) | (g << 8) | r;
+    }
+
+    static inline void unpackSurfacePixel(uint32_t pixel, uint32_t &r, uint32_t &g, uint32_t &b){
+        r = pixel & 0xff;
+        g = (pixel >> 8) & 0xff;
+        b = (pixel >> 16) & 0xff;
+    }
+
+    // 批量颜色转换，输出绘制表面的像素（通道顺序同packSurfacePixel()，预乘alpha）。
+    // 源数据每通道8位。支持SSE2时灰度和CMYK按4像素一组并行计算。
+
+    // CMYK转RGB：R = (255 - C) * (255 - K) / 255，G、B同理。
+    static inline uint8_t cmykChannelToRGB(uint32_t c, uint32_t k){
+        uint32_t x = (255 - c) * (255 - k) + 128;
+        return (uint8_t)((x + (x >> 8)) >> 8);
+    }
+
+    void ConvertGrayToARGB32(const uint8_t *src, uint32_t *dst, size_t n);
+    void ConvertRGBToARGB32(const uint8_t *src, uint32_t *dst, size_t n);
+    // premultiply为false时忽略alpha，用于RGB24表面。
+    void ConvertRGBAToARGB32(const uint8_t *src, uint32_t *dst, size_t n, bool premultiply = true);
+    void ConvertCMYKToARGB32(const uint8_t *src, uint32_t *dst, size_t n);
+    // 就地预乘alpha，alpha在最高字节，其余三个通道的顺序不限。
+    void PremultiplyARGB32(uint32_t *pixels, size_t n);
+    // 每像素nBits（1、2、4、8）位的调色板索引，高位在前，越界索引取palette[0]。
+    void ConvertIndexedToARGB32(const uint8_t *src, int nBits, const uint32_t *palette, size_t paletteSize,
+            uint32_t *dst, size_t n);
+
+    // 是否使用SIMD实现，用于与标量实现对比测试。
+    bool IsColorConvertSIMDEnabled();
+    void SetColorConvertSIMD(bool enable);
+
+    class ColorConverter;
+    typedef std::shared_ptr<ColorConverter> ColorConverterPtr;
+
+    // ======== class ColorConverter ========
+    // 颜色空间到绘制表面像素的转换器，调色板预先转换为像素查找表。
+    // 按颜色空间缓存，颜色空间的类型或调色板变化后需调用Invalidate()。
+    class ColorConverter {
+        public:
+            ColorConverter(const ColorSpace &colorSpace);
+
+            // 返回colorSpace的转换器，同一颜色空间只创建一次。线程安全。
+            static ColorConverterPtr GetInstance(ColorSpacePtr colorSpace);
+            static void Invalidate(ColorSpacePtr colorSpace);
+
+            ColorSpaceType GetType() const {return m_type;};
+            int GetNumComps() const;
+
+            // 转换一行颜色空间下的像素，每像素GetNumComps()个8位通道。
+            void ConvertRow(const uint8_t *src, uint32_t *dst, size_t n) const;
+            // 转换一行调色板索引。
+            void ConvertIndexedRow(const uint8_t *src, int nBits, uint32_t *dst, size_t n) const;
+
+            // 单个颜色值转换为0-1的RGB分量。
+            static void ValueToRGB(ColorSpaceType type, const ColorValue &value, double &r, double &g, double &b);
+            // 调色板颜色，index越界时返回false。
+            bool GetPaletteRGB(uint32_t index, double &r, double &g, double &b) const;
+
+        private:
+            ColorSpaceType m_type;
+            std::vector<uint32_t> m_palette;    // 预先转换的调色板（预乘alpha的像素）
+            std::vector<uint32_t> m_paletteRGB; // 调色板未预乘的像素，alpha为0
+
+    }; // class ColorConverter
+
+}; // namespace ofd
+
+#endif // __OFD_COLORCONVERT_H__
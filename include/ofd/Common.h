@@ -47,6 +47,9 @@ namespace ofd{
     typedef std::vector<ImagePtr> ImageArray;
     typedef std::map<uint64_t, ImagePtr> ImageMap;
 
+    class ImageCache;
+    typedef std::shared_ptr<ImageCache> ImageCachePtr;
+
     class Font;
     typedef std::shared_ptr<Font> FontPtr;
     typedef std::vector<FontPtr> FontArray;
@@ -2,10 +2,12 @@
 #define __OFD_DOCUMENT_H__
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include "ofd/Common.h"
+#include "ofd/Layer.h"
 
 namespace ofd{
 
@@ -23,6 +25,21 @@ namespace ofd{
             // =============== Public Attributes ================
         public:
 
+            // ======== struct CT_TemplatePage ========
+            // 模板页定义，模板页内容结构和普通页相同。
+            // OFD (section 7.5) P10. Document.xsd
+            typedef struct CT_TemplatePage{
+                uint64_t    ID;      // 模板页标识。必选。
+                std::string Name;    // 模板页名称。可选。
+                LayerType   ZOrder;  // 模板页的默认图层类型，Background或Foreground，默认为Background。
+                ST_Loc      BaseLoc; // 指向模板页内容描述文件。必选。
+                PagePtr     Page;    // 模板页内容。首次使用时解析，由引用它的页面共享。
+
+                CT_TemplatePage() : ID(0), ZOrder(LayerType::BACKGROUND){};
+
+            } CT_TemplatePage_t;
+            typedef std::vector<CT_TemplatePage> TemplatePageArray;
+
             // ======== struct CommonData ========
             // 文档公共数据，定义了页面区域、公共资源等数据。
             typedef struct CommonData{
@@ -45,7 +62,7 @@ namespace ofd{
                     ResourcePtr DocumentRes;
 
                     // 模板页序列，为一系列模板页的集合，模板页内容结构和普通页相同。
-                    //CT_TemplatePage TemplatePage;
+                    TemplatePageArray TemplatePages;
 
                     // 引用在资源文件中定义的颜色空间标识。如果此项不存在，采用RGB作为默认颜色空间。
                     //uint64_t DefaultCS;
@@ -117,6 +134,18 @@ namespace ofd{
             PagePtr GetPage(size_t idx);
             PagePtr AddNewPage();
 
+            size_t GetNumTemplatePages() const {return m_commonData.TemplatePages.size();};
+            // 新建模板页，返回模板页内容页面。
+            PagePtr AddNewTemplatePage(LayerType zorder = LayerType::BACKGROUND);
+            // 返回模板页内容，首次调用时解析，之后所有引用该模板的页面共享同一对象。
+            // 引用模板的页面在Page::Open()中调用，可在多个线程中同时调用。
+            PagePtr GetTemplatePage(uint64_t templateID);
+            const CT_TemplatePage *GetTemplatePageInfo(uint64_t templateID) const;
+
+            // 将连续多页正文层开头（结尾）完全相同、且不少于minObjects个的对象
+            // 提取为背景（前景）模板页，各页改为引用模板。返回新建的模板页数。
+            size_t FactorTemplatePages(size_t minObjects);
+
             // Called by ofd::Package::Save().
             std::string GenerateDocumentXML() const;
             // Called by Package::generateOFDXML()
@@ -141,6 +170,7 @@ namespace ofd{
             ResourcePtr GetDocumentRes() {return GetCommonData().DocumentRes;};
             const DocBody& GetDocBody() const {return m_docBody;};
             DocBody& GetDocBody() {return m_docBody;};
+            ImageCachePtr GetImageCache() const {return m_imageCache;};
 
         private:
             std::weak_ptr<Package> m_package;
@@ -148,6 +178,8 @@ namespace ofd{
             PageArray         m_pages;
             CommonData        m_commonData;
             DocBody           m_docBody;
+            ImageCachePtr     m_imageCache; // 已解码图像缓存，供绘制时复用。
+            std::recursive_mutex m_templateMutex; // 保护模板页的首次解析，模板页打开时可能再次进入
 
             void generateCommonDataXML(utils::XMLWriter &writer) const;
             void generatePagesXML(utils::XMLWriter &writer) const;
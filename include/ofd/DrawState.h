@@ -3,6 +3,12 @@
 
 namespace ofd{
 
+    // 绘制质量。Draft用于缩略图、搜索结果预览等小尺寸快速绘制。
+    enum class RenderQuality{
+        Normal = 0,
+        Draft,
+    };
+
     typedef struct DrawState{
 
         struct DebugParams{
@@ -10,16 +16,45 @@ namespace ofd{
             size_t PageDrawing;
             size_t PathObjectID;
             size_t ImageObjectID;
+            bool DumpImages; // 将解码后的图像写入/tmp/Image_draw_<ID>.png
 
             DebugParams():
                 Enabled(false), 
                 PageDrawing(0), 
                 PathObjectID(0), 
-                ImageObjectID(0){
+                ImageObjectID(0),
+                DumpImages(false){
             }
         };
         DebugParams Debug;
 
+        // Draft质量下的绘制参数，像素值均为设备空间像素。
+        struct DraftParams{
+            double MinTextPixels;   // 字号小于此值的文字不做字形绘制。
+            bool GreekText;         // true: 小文字以横条代替；false: 直接跳过。
+            double MinStrokePixels; // 线宽小于此值的勾边不绘制。
+            double ImageScale;      // 图像按目标尺寸乘以此系数选取低分辨率级别。
+
+            DraftParams():
+                MinTextPixels(4.0),
+                GreekText(true),
+                MinStrokePixels(0.5),
+                ImageScale(0.5){
+            }
+        };
+        RenderQuality Quality;
+        DraftParams Draft;
+
+        // 纯色的轴对齐矩形填充和水平、垂直直线直接写入ARGB32像素，不经过cairo光栅化。
+        bool FastRectFill;
+
+        // 设备空间字号不超过GlyphAtlasMaxPixels的文字从GlyphAtlas取字形位图绘制。
+        bool UseGlyphAtlas;
+        double GlyphAtlasMaxPixels;
+
+        DrawState() : Quality(RenderQuality::Normal), FastRectFill(true),
+            UseGlyphAtlas(true), GlyphAtlasMaxPixels(16.0){
+        }
 
     } DrawSate_t;
 
@@ -4,6 +4,8 @@
 #include <string>
 #include <memory>
 #include "ofd/Common.h"
+#include "ofd/FontSubset.h"
+#include "ofd/CodeToGIDMap.h"
 
 struct _cairo_font_face;
 
@@ -49,12 +51,15 @@ namespace ofd{
             // =============== Public Methods ================
         public:
             bool IsLoaded() const {return m_bLoaded;};
+            // 接管fontData（new[]分配）。
             bool CreateFromData(char *fontData, size_t fontDataSize);
             _cairo_font_face* GetCairoFontFace() const {return m_fontFace;};
             void GenerateXML(utils::XMLWriter &writer) const;
             bool FromXML(utils::XMLElementPtr fontElement);
             bool Load(PackagePtr package, bool reload = false);
-            unsigned long GetGlyph(unsigned int code, unsigned int *u, int uLen) const;
+            unsigned long GetGlyph(unsigned int code, unsigned int *u, int uLen) const{
+                return m_codeToGID != nullptr ? m_codeToGID->Lookup(code) : code;
+            }
             std::string GenerateFontFileName();
 
         public:
@@ -63,19 +68,37 @@ namespace ofd{
             void SetFontFilePath(const std::string &fontFilePath){m_fontFilePath = fontFilePath;};
             std::string GetFontFilePath() const {return m_fontFilePath;};
             bool IsSubstitute() const {return m_substitute;};
+
+            // -------- 字形使用情况，保存时据此生成字体子集 --------
+            // text为UTF-8编码的文本。
+            void AddUsedText(const std::string &text);
+            void AddUsedGlyph(uint32_t glyphID){m_usedGlyphs.insert(glyphID);};
+            bool HasGlyphUsage() const {return !m_usedUnicodes.empty() || !m_usedGlyphs.empty();};
+            void ClearGlyphUsage();
+            // 只包含已使用字形的字体数据（new[]分配）。未记录使用情况或不能子集化时返回false，
+            // 应保存完整字体。
+            std::tuple<char*, size_t, bool> CreateSubsetData() const;
+
         private:
+            void releaseFontData();
+
             bool              m_bLoaded;
-            char*             m_fontData;
+            const char*       m_fontData;        // 成功创建字体后指向FontCache中的共享数据
             size_t            m_fontDataSize;
             _cairo_font_face* m_fontFace;
             std::string       m_fontFilePath;
             bool              m_substitute;
+            CodeSet           m_usedUnicodes;
+            CodeSet           m_usedGlyphs;
 
         public:
-            // FIXME
-            // Set in OFDOutputDev_UpdateFont
-            int*              m_codeToGID;
-            size_t            m_codeToGIDLen;
+            // 编码到字形编号映射，由pdf2ofd转换时设置，随字体资源保存。
+            // 没有映射时编码即字形编号。
+            CodeToGIDMapPtr GetCodeToGID() const {return m_codeToGID;};
+            void SetCodeToGID(CodeToGIDMapPtr codeToGID){m_codeToGID = codeToGID;};
+
+        private:
+            CodeToGIDMapPtr   m_codeToGID;
 
     }; // class Font;
 
@@ -0,0 +1,52 @@
+#ifndef __OFD_FONTCACHE_H__
+#define __OFD_FONTCACHE_H__
+
+#include <memory>
+#include <tuple>
+#include "ofd/Common.h"
+
+struct _cairo_font_face;
+
+namespace ofd{
+
+    // ======== class FontCache ========
+    // 进程共享的字体缓存，以字体程序内容的哈希为键。
+    // 不同文档嵌入的相同字体共用一个FT_Face和cairo字体，cairo的字形缓存也随之共用。
+    // 字体按使用者计数，不再使用的字体保留在空闲队列中，
+    // 空闲字体数据总量超出上限时淘汰最久未用的。线程安全。
+    class FontCache {
+        public:
+            static const size_t DefaultMaxIdleBytes = 64 * 1024 * 1024;
+
+            FontCache(size_t maxIdleBytes = DefaultMaxIdleBytes);
+            ~FontCache();
+
+            static FontCache& GlobalInstance();
+
+            // 返回字体数据对应的cairo字体（调用者持有一个引用）及缓存中的字体数据，使用者计数加1。
+            // 成功时接管fontData（new[]分配），命中缓存时fontData被立即释放，
+            // 返回的字体数据在调用Release()之前有效。失败时返回nullptr，fontData仍归调用者。
+            std::tuple<_cairo_font_face*, const char*> Acquire(char *fontData, size_t fontDataSize);
+
+            // 归还Acquire()得到的字体并释放调用者的引用，使用者计数减1。
+            void Release(_cairo_font_face *fontFace);
+
+            // 释放所有空闲字体。
+            void Clear();
+
+            size_t GetMaxIdleBytes() const;
+            void SetMaxIdleBytes(size_t maxIdleBytes);
+
+            size_t GetNumFonts() const;
+            size_t GetIdleBytes() const;
+            std::tuple<uint64_t, uint64_t> GetHitsMisses() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class FontCache
+
+}; // namespace ofd
+
+#endif // __OFD_FONTCACHE_H__
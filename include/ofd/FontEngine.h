@@ -0,0 +1,30 @@
+#ifndef __OFD_FONTENGINE_H__
+#define __OFD_FONTENGINE_H__
+
+#include <stddef.h>
+
+struct _cairo_font_face;
+
+namespace ofd{
+
+    // ======== class FontEngine ========
+    // 进程唯一的FreeType库。
+    // FT_Library本身不是线程安全的，创建和释放FT_Face在库锁内进行；
+    // 不同FT_Face可以并发加载字形，同一FT_Face的访问由cairo的字体锁串行化，
+    // libofd绘制时只通过cairo使用FT_Face。
+    // 库在Initialize()或首次创建字体时初始化，不依赖静态对象的构造顺序。
+    // 进程退出时不释放库，cairo的全局字体缓存可能在静态析构之后才释放字体。
+    class FontEngine {
+        public:
+            // 初始化FreeType，可重复调用。多线程绘制前在主线程调用一次可以尽早发现初始化失败。
+            static bool Initialize();
+
+            // 由内存中的字体程序创建cairo字体，调用者持有返回的引用。
+            // fontData在字体销毁前必须保持有效，可用cairo用户数据随字体释放。失败时返回nullptr。
+            static _cairo_font_face *CreateCairoFontFace(const char *fontData, size_t fontDataSize);
+
+    }; // class FontEngine
+
+}; // namespace ofd
+
+#endif // __OFD_FONTENGINE_H__
@@ -0,0 +1,23 @@
+#ifndef __OFD_FONTSUBSET_H__
+#define __OFD_FONTSUBSET_H__
+
+#include <stdint.h>
+#include <set>
+#include <tuple>
+
+namespace ofd{
+
+    typedef std::set<uint32_t> CodeSet;
+
+    // 是否支持字体子集化（编译时找到HarfBuzz的hb-subset）。
+    bool IsFontSubsetSupported();
+
+    // 生成只包含unicodes中字符及glyphIDs中字形的TrueType/OpenType字体，
+    // cmap随之重写。retainGIDs为true时保持原字形编号，原有的编码到字形编号映射仍然有效，
+    // 否则字形重新连续编号。返回new[]分配的字体数据，失败或子集不比原字体小时返回false。
+    std::tuple<char*, size_t, bool> SubsetFontData(const char *fontData, size_t fontDataSize,
+            const CodeSet &unicodes, const CodeSet &glyphIDs, bool retainGIDs);
+
+}; // namespace ofd
+
+#endif // __OFD_FONTSUBSET_H__
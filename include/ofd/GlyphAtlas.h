@@ -0,0 +1,51 @@
+#ifndef __OFD_GLYPHATLAS_H__
+#define __OFD_GLYPHATLAS_H__
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <cairo/cairo.h>
+#include "ofd/Common.h"
+
+namespace ofd{
+
+    // ======== class GlyphAtlas ========
+    // 小字号文字的字形位图缓存。
+    //
+    // 以(字体, 设备空间字号, 字形, 水平亚像素位置)为键缓存字形的A8覆盖率位图，
+    // 绘制时以位图为蒙版直接合成到目标表面，同一字形在各页、各次绘制中只光栅化一次。
+    // 水平位置量化为1/SubpixelPositions像素，基线对齐到整像素。
+    // 只用于未旋转、未错切的纯色文字，其它情况由调用者按常规路径绘制。
+    // 总占用内存超出上限时按LRU淘汰。线程安全，并行绘制的页面共用。
+    class GlyphAtlas {
+        public:
+            static const size_t DefaultMaxBytes = 16 * 1024 * 1024;
+            static const int SubpixelPositions = 4;
+
+            GlyphAtlas(size_t maxBytes = DefaultMaxBytes);
+            ~GlyphAtlas();
+
+            static GlyphAtlas& GlobalInstance();
+
+            // 以cr的当前源绘制UTF-8文字，(x, y)为用户空间中的基线起点，
+            // fontMatrix为用户空间字体矩阵。目标不是图像表面等不适用时不绘制并返回false。
+            bool ShowText(cairo_t *cr, cairo_font_face_t *fontFace, const cairo_matrix_t &fontMatrix,
+                    const cairo_font_options_t *fontOptions, double x, double y, const std::string &text);
+
+            void Clear();
+
+            size_t GetMaxBytes() const;
+            void SetMaxBytes(size_t maxBytes);
+            size_t GetUsedBytes() const;
+            size_t GetNumGlyphs() const;
+            std::tuple<uint64_t, uint64_t> GetHitsMisses() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class GlyphAtlas
+
+}; // namespace ofd
+
+#endif // __OFD_GLYPHATLAS_H__
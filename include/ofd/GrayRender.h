@@ -0,0 +1,64 @@
+#ifndef __OFD_GRAYRENDER_H__
+#define __OFD_GRAYRENDER_H__
+
+#include <memory>
+#include <string>
+#include <cairo/cairo.h>
+#include "ofd/Common.h"
+#include "ofd/Render.h"
+#include "ofd/ImageEncoder.h"
+
+namespace ofd{
+
+    // 灰度、黑白目标表面格式。
+    enum class GrayFormat{
+        Gray8, // CAIRO_FORMAT_A8表面，每像素1字节，0为黑，255为白。
+        Mono1, // CAIRO_FORMAT_A1表面，1为白，位序与cairo一致。
+    };
+
+    // 黑白二值化方式。
+    enum class MonoMethod{
+        Threshold,
+        Dither,    // Floyd-Steinberg误差扩散
+    };
+
+    // ======== class GrayRender ========
+    // 将页面绘制为8位灰度或1位黑白图像，用于归档、传真等场景。
+    // cairo不能直接在灰度表面上绘制彩色内容，页面按水平条带绘制到
+    // 一个条带高的ARGB32表面，每条绘制后随即转换写入目标表面，
+    // ARGB32只占一个条带的内存。条带越矮内存越少，但每条都要遍历一次页面对象。
+    class GrayRender {
+        public:
+            static const int DefaultBandHeight = 256;
+
+            GrayRender(int pixelWidth, int pixelHeight, double resolutionX, double resolutionY,
+                    GrayFormat format, int bandHeight = DefaultBandHeight);
+            ~GrayRender();
+
+            // visibleParams与CairoRender::DrawPage()含义相同。被取消或超时返回false。
+            bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl = DrawControl());
+
+            cairo_surface_t *GetCairoSurface() const;
+            GrayFormat GetFormat() const;
+
+            MonoMethod GetMonoMethod() const;
+            void SetMonoMethod(MonoMethod monoMethod);
+            uint8_t GetMonoThreshold() const;
+            void SetMonoThreshold(uint8_t threshold);
+
+            const DrawState& GetDrawState() const;
+            DrawState& GetDrawState();
+            void SetRenderQuality(RenderQuality quality);
+
+            bool WriteImage(const std::string &filename, const EncodeParams &params);
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class GrayRender
+    typedef std::shared_ptr<GrayRender> GrayRenderPtr;
+
+}; // namespace ofd
+
+#endif // __OFD_GRAYRENDER_H__
@@ -4,6 +4,7 @@
 #include <string>
 #include <cairo/cairo.h>
 #include "ofd/Common.h"
+#include "ofd/ImageEncoder.h"
 
 namespace ofd{
 
@@ -49,7 +50,8 @@ namespace ofd{
         }
     } ImageDataHead_t;
 
-    std::string generateImageFileName(uint64_t imageID);
+    // 按图像文件格式取扩展名，Image_N.png、Image_N.jpg或Image_N.tif。
+    std::string generateImageFileName(uint64_t imageID, ImageFormat format = ImageFormat::PNG);
 
     class Image {
         public:
@@ -69,6 +71,7 @@ namespace ofd{
             uint8_t *inputLine; // input line buffer
             uint8_t *imgLine;   // line buffer
             int imgIdx;	        // current index in imgLine
+            ImageFormat Format; // 图像文件格式，PNG、JPEG（原样保存的DCT数据）或TIFF（原样封装的CCITT G4数据）
 
             //std::string ImageFile;
             // =============== Public Methods ================
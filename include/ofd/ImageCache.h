@@ -0,0 +1,45 @@
+#ifndef __OFD_IMAGECACHE_H__
+#define __OFD_IMAGECACHE_H__
+
+#include <memory>
+#include <functional>
+#include <cairo/cairo.h>
+#include "ofd/Common.h"
+
+namespace ofd{
+
+    // 按照指定尺寸解码图像，返回cairo图像表面（RGB24、ARGB32，黑白图像为A1）。
+    typedef std::function<cairo_surface_t*(ImagePtr image, int scaledWidth, int scaledHeight)> ImageDecodeFunc;
+
+    // ======== class ImageCache ========
+    // 文档级已解码图像缓存。
+    // 以(图像ID, mip级别)为键保存预乘后的cairo图像表面，级别0为原始分辨率，
+    // 每升一级宽高减半。缩小显示时取不小于目标尺寸的最小一级，
+    // 总占用内存超出预算时按LRU淘汰。
+    class ImageCache {
+        public:
+            static const size_t DefaultMaxBytes = 256 * 1024 * 1024;
+
+            ImageCache(size_t maxBytes = DefaultMaxBytes);
+            ~ImageCache();
+
+            // 返回适合以scaledWidth x scaledHeight像素绘制的图像表面。
+            // 返回值已增加引用计数，调用者需cairo_surface_destroy()。
+            cairo_surface_t *GetSurface(ImagePtr image, int scaledWidth, int scaledHeight, ImageDecodeFunc decodeFunc);
+
+            void RemoveImage(uint64_t imageID);
+            void Clear();
+
+            size_t GetMaxBytes() const;
+            void SetMaxBytes(size_t maxBytes);
+            size_t GetUsedBytes() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class ImageCache
+
+}; // namespace ofd
+
+#endif // __OFD_IMAGECACHE_H__
@@ -0,0 +1,36 @@
+#ifndef __OFD_IMAGEDECODER_H__
+#define __OFD_IMAGEDECODER_H__
+
+#include <stddef.h>
+#include <cairo/cairo.h>
+#include "ofd/ImageEncoder.h"
+
+namespace ofd{
+
+    // ======== struct ImageHeader ========
+    typedef struct ImageHeader{
+        ImageFormat Format;
+        int         Width;
+        int         Height;
+        bool        HasAlpha;
+        bool        Bilevel;  // 1位黑白图像
+
+        ImageHeader() :
+            Format(ImageFormat::PNG), Width(0), Height(0), HasAlpha(false), Bilevel(false){
+        }
+    } ImageHeader_t;
+
+    // 由文件头识别图像格式并读取尺寸，不解码像素。支持PNG、JPEG和1位黑白的TIFF。
+    bool ReadImageHeader(const char *data, size_t dataSize, ImageHeader &header);
+
+    // 将图像文件逐行解码到cairo图像表面，不生成中间的整幅图像。
+    // scaledWidth x scaledHeight小于原尺寸时边解码边缩小，否则按原尺寸解码；
+    // JPEG先按DCT缩放解码，只对缩放后的数据做剩余的缩小。
+    // 有透明度时为预乘的ARGB32表面，否则为RGB24。
+    // 1位黑白图像按原尺寸解码为A1表面，1为黑色，绘制时作为蒙版使用。
+    // 与绘制颜色一致，像素的R、B分量交换存放（R在低字节）。失败时返回nullptr。
+    cairo_surface_t *DecodeImage(const char *data, size_t dataSize, int scaledWidth, int scaledHeight);
+
+}; // namespace ofd
+
+#endif // __OFD_IMAGEDECODER_H__
@@ -0,0 +1,107 @@
+#ifndef __OFD_IMAGEENCODER_H__
+#define __OFD_IMAGEENCODER_H__
+
+#include <memory>
+#include <string>
+#include <functional>
+#include <stdint.h>
+#include <cairo/cairo.h>
+
+namespace ofd{
+
+    enum class ImageFormat{
+        PNG,
+        JPEG,
+        TIFF,
+        PNM,  // PPM/PGM/PBM
+    };
+
+    // 输出像素格式。
+    enum class ImageColorMode{
+        RGB,
+        RGBA, // 非预乘，仅PNG、TIFF支持
+        Gray, // 8位灰度
+        Mono, // 1位黑白
+    };
+
+    // PNG行过滤方式，Adaptive逐行选取绝对值和最小的过滤方式。
+    enum class PNGFilter{
+        None = 0,
+        Sub,
+        Up,
+        Average,
+        Paeth,
+        Adaptive,
+    };
+
+    std::string ImageFormatToString(ImageFormat format);
+    bool ImageFormatFromString(const std::string &strFormat, ImageFormat &format);
+    std::string ImageColorModeToString(ImageColorMode colorMode);
+    bool ImageColorModeFromString(const std::string &strColorMode, ImageColorMode &colorMode);
+
+    // ======== struct EncodeParams ========
+    typedef struct EncodeParams{
+        ImageFormat    Format;
+        ImageColorMode ColorMode;
+        int            PNGLevel;       // zlib压缩级别0~9，同时用于TIFF的Deflate压缩。
+        PNGFilter      Filter;
+        int            JPEGQuality;    // 1~100
+        uint8_t        MonoThreshold;  // 灰度值不小于此值的像素为白色。
+        size_t         Threads;        // PNG并行压缩的线程数，0表示CPU核数。
+        double         ResolutionX;    // 写入文件头的DPI，0表示不写。
+        double         ResolutionY;
+
+        EncodeParams() :
+            Format(ImageFormat::PNG), ColorMode(ImageColorMode::RGB),
+            PNGLevel(3), Filter(PNGFilter::Up), JPEGQuality(85),
+            MonoThreshold(128), Threads(1),
+            ResolutionX(0.0), ResolutionY(0.0){
+        }
+    } EncodeParams_t;
+
+    // 编码数据输出回调，失败返回false。
+    typedef std::function<bool(const uint8_t *data, size_t length)> ImageWriteFunc;
+
+    // ======== class ImageEncoder ========
+    // 将ARGB32/RGB24图像表面编码为图像文件。
+    // 逐行从表面缓冲区转换到目标像素格式后直接送入编码器，不复制整幅图像。
+    class ImageEncoder {
+    public:
+        virtual ~ImageEncoder();
+
+        virtual bool Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc) = 0;
+
+        bool EncodeToFile(cairo_surface_t *surface, const std::string &filename);
+        bool EncodeToBuffer(cairo_surface_t *surface, std::string &buffer);
+
+        const EncodeParams& GetParams() const {return m_params;};
+
+    protected:
+        ImageEncoder(const EncodeParams &params);
+
+        EncodeParams m_params;
+
+    }; // class ImageEncoder
+    typedef std::shared_ptr<ImageEncoder> ImageEncoderPtr;
+
+    // ======== class ImageEncoderFactory ========
+    class ImageEncoderFactory{
+    public:
+        static ImageEncoderPtr CreateEncoder(const EncodeParams &params);
+    }; // class ImageEncoderFactory
+
+    // 将表面的一行转换为colorMode格式。Mono每字节8个像素，高位在前，1为白色。
+    // 支持ARGB32、RGB24以及GrayRender输出的A8（灰度）、A1（1为白色）表面。
+    void ConvertSurfaceRow(const uint8_t *src, cairo_format_t format, int width,
+            ImageColorMode colorMode, uint8_t monoThreshold, uint8_t *dst);
+
+    // colorMode格式一行的字节数。
+    size_t GetRowBytes(ImageColorMode colorMode, int width);
+
+    // 将CCITT G4（T.6）压缩数据原样封装为TIFF文件，不解码重新压缩。
+    // 编码的黑色游程显示为黑色，invert为true时黑白互换。
+    bool WriteCCITTG4TIFF(const uint8_t *data, size_t dataSize, int width, int height, bool invert, ImageWriteFunc writeFunc);
+
+}; // namespace ofd
+
+#endif // __OFD_IMAGEENCODER_H__
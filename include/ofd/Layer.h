@@ -15,6 +15,10 @@ namespace ofd{
         CUSTOM,
     };
 
+    // OFD (section 7.7) P20. Layer Type属性取值：Body、Background、Foreground、Custom。
+    std::string LayerTypeToString(LayerType layerType);
+    LayerType LayerTypeFromString(const std::string &strLayerType);
+
     class Layer : public std::enable_shared_from_this<Layer>{
         public:
             Layer(PagePtr page);
@@ -56,6 +56,8 @@ namespace ofd{
         public:
             const LayerPtr GetLayer() const;
             LayerPtr GetLayer();
+            // 对象移入其它图层（如提取模板页）时调用。
+            void SetLayer(LayerPtr layer) {m_layer = layer;};
             const PagePtr GetPage() const;
             PagePtr GetPage();
             const DocumentPtr GetDocument() const;
@@ -3,11 +3,24 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include "ofd/Common.h"
 #include "ofd/Layer.h"
 
 namespace ofd{
 
+    // ======== struct CT_Template ========
+    // 页面引用的模板页。OFD (section 7.7) P19. Page.xsd
+    typedef struct CT_Template{
+        uint64_t  TemplateID; // 引用的模板页标识。
+        LayerType ZOrder;     // 模板页在页面中的图层次序，Background或Foreground。
+
+        CT_Template() : TemplateID(0), ZOrder(LayerType::BACKGROUND){};
+        CT_Template(uint64_t templateID, LayerType zorder) : TemplateID(templateID), ZOrder(zorder){};
+
+    } CT_Template_t;
+    typedef std::vector<CT_Template> TemplateArray;
+
     class Page : public std::enable_shared_from_this<Page> {
         private:
             Page(DocumentPtr document);
@@ -22,6 +35,7 @@ namespace ofd{
             uint64_t ID;
             std::string BaseLoc;
             CT_PageArea Area;
+            TemplateArray Templates;
 
             // =============== Public Methods ================
         public:
@@ -34,6 +48,14 @@ namespace ofd{
             LayerPtr AddNewLayer(LayerType layerType);
             const LayerPtr GetBodyLayer() const;
             LayerPtr GetBodyLayer();
+            size_t GetNumLayers() const {return m_layers.size();};
+            const LayerPtr GetLayer(size_t idx) const {return m_layers[idx];};
+            LayerPtr GetLayer(size_t idx) {return m_layers[idx];};
+            // 按绘制次序返回全部图层：背景模板、背景层、正文层与自定义层（文档顺序）、
+            // 前景层、前景模板。模板页的图层由引用它的页面共享。
+            LayerArray GetDrawingLayers() const;
+            // 图层是否属于本页引用的模板页。
+            bool IsTemplateLayer(const LayerPtr layer) const;
             void AddObject(ObjectPtr object) {GetBodyLayer()->AddObject(object);};
 
             // Called by Package::Save()
@@ -55,6 +77,7 @@ namespace ofd{
 
             // Called by Page::Open()
             bool fromPageXML(const std::string &strPageXML);
+            bool fromTemplateXML(utils::XMLElementPtr templateElement);
             bool fromContentXML(utils::XMLElementPtr contentElement);
             LayerPtr fromLayerXML(utils::XMLElementPtr layerElement);
 
@@ -38,6 +38,11 @@ namespace ofd{
             char GetFlag(size_t idx) const;
             Boundary CalculateBoundary() const;
 
+            // 是否为轴对齐矩形：4个顶点（闭合时末点与首点重合）且各边水平或垂直。
+            bool GetAxisAlignedRect(Boundary &rect) const;
+            // 是否为一条水平或垂直线段。
+            bool GetAxisAlignedLine(Point_t &p0, Point_t &p1) const;
+
         private:
             std::vector<Point_t> m_points;
             std::vector<char> m_flags;
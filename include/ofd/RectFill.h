@@ -0,0 +1,20 @@
+#ifndef __OFD_RECTFILL_H__
+#define __OFD_RECTFILL_H__
+
+#include <stdint.h>
+
+namespace ofd{
+
+    // 以OVER运算将预乘后的颜色color（0xAARRGGBB）填充到ARGB32像素缓冲区中
+    // 设备坐标为[x0, x1) x [y0, y1)的矩形内，坐标可为小数。
+    // 边缘像素按被矩形覆盖的面积计算透明度，与cairo对轴对齐矩形的抗锯齿结果一致。
+    // 矩形超出缓冲区的部分被裁掉。
+    void FillRectARGB32(uint8_t *data, int stride, int width, int height,
+            double x0, double y0, double x1, double y1, uint32_t color);
+
+    // 将0~1的非预乘RGBA转换为预乘后的ARGB32像素值。
+    uint32_t PremultiplyARGB32(double r, double g, double b, double a);
+
+}; // namespace ofd
+
+#endif // __OFD_RECTFILL_H__
@@ -2,7 +2,11 @@
 #define __OFD_RENDER_H__
 
 #include <memory>
+#include <string>
 #include <tuple>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include "ofd/Common.h"
 #include "ofd/DrawState.h"
 
@@ -10,6 +14,59 @@ namespace ofd{
 
     typedef std::tuple<double, double, double> VisibleParams;
 
+    // 绘制优先级分组：先绘制矢量图形和文字，再绘制图像，最后绘制渐变、复合对象等效果。
+    enum class DrawPass{
+        Vector = 0,
+        Image,
+        Effect,
+    };
+
+    // ======== class DrawCancelToken ========
+    // 绘制取消标志，可在其它线程中调用Cancel()。
+    class DrawCancelToken {
+    public:
+        DrawCancelToken() : m_cancelled(false){};
+
+        void Cancel(){m_cancelled = true;};
+        void Reset(){m_cancelled = false;};
+        bool IsCancelled() const {return m_cancelled;};
+
+    private:
+        std::atomic<bool> m_cancelled;
+
+    }; // class DrawCancelToken
+    typedef std::shared_ptr<DrawCancelToken> DrawCancelTokenPtr;
+
+    // 绘制进度回调：当前绘制组、已绘制对象数、对象总数。
+    typedef std::function<void(DrawPass pass, size_t numDrawn, size_t numTotal)> DrawProgressFunc;
+
+    // ======== struct DrawControl ========
+    // 渐进式绘制的控制参数，在对象之间检查取消标志和截止时间。
+    // 默认按文档顺序绘制；Progressive为true时按DrawPass分组绘制，每组完成后更新表面。
+    typedef struct DrawControl{
+        typedef std::chrono::steady_clock Clock;
+
+        DrawCancelTokenPtr CancelToken;
+        bool               HasDeadline;
+        Clock::time_point  Deadline;
+        DrawProgressFunc   ProgressFunc;
+        bool               Progressive;
+
+        DrawControl() : HasDeadline(false), Progressive(false){
+        }
+
+        void SetTimeout(std::chrono::milliseconds timeout){
+            HasDeadline = true;
+            Deadline = Clock::now() + timeout;
+        }
+
+        bool IsAborted() const{
+            if ( CancelToken != nullptr && CancelToken->IsCancelled() ) return true;
+            if ( HasDeadline && Clock::now() >= Deadline ) return true;
+            return false;
+        }
+    } DrawControl_t;
+
     // ======== class Render ========
     class Render {
     public:
@@ -17,12 +74,16 @@ namespace ofd{
         virtual ~Render();
 
         virtual void DrawPage(PagePtr page, VisibleParams visibleParams);
+        // 渐进式绘制，被取消或超时返回false，此时表面上为部分结果。
+        virtual bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl);
         VisibleParams GetVisibleParams() const;
         void SetVisibleParams(VisibleParams visibleParams);
 
         const DrawState& GetDrawState() const {return m_drawState;};
         DrawState& GetDrawState() {return m_drawState;};
         void SetDrawState(const DrawState &drawState){m_drawState = drawState;};
+        RenderQuality GetRenderQuality() const {return m_drawState.Quality;};
+        void SetRenderQuality(RenderQuality quality){m_drawState.Quality = quality;};
 
     private:
         VisibleParams m_visibleParams;
@@ -33,12 +94,19 @@ namespace ofd{
     typedef std::shared_ptr<Render> RenderPtr;
 
     enum class RenderType{
-        Cairo,
+        Cairo, // ARGB32图像表面
+        PDF,
+        SVG,
+        PS,
     };
 
+    // ======== class RenderFactory ========
     class RenderFactory{
     public:
-        //static RenderPtr CreateRenderInstance(RenderType renderType); 
+        // 光栅绘制，返回pixelWidth x pixelHeight像素的CairoRender。
+        static RenderPtr CreateRenderInstance(RenderType renderType, double pixelWidth, double pixelHeight, double resolutionX, double resolutionY); 
+        // 矢量输出到filename，返回CairoVectorRender。
+        static RenderPtr CreateRenderInstance(RenderType renderType, const std::string &filename); 
     }; // class RenderFactory
 
 }; // namespace ofd
@@ -2,6 +2,8 @@
 #define __OFD__SHADING_H__
 
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <cairo/cairo.h>
 #include "ofd/Common.h"
 #include "ofd/Color.h"
@@ -18,10 +20,12 @@ namespace ofd{
     // ======== class BaseShading ========
     // OFD (section 8.3.4) P35，Page.xsd。
     // 基础渐变类
+    // 填充pattern创建后缓存在Shading实例中，同一渐变重复绘制时不再重建。
+    // 直接修改公开属性后需调用InvalidateCache()。
     class Shading {
         public:
-            Shading() : Extend(0) {};
-            virtual ~Shading(){};
+            Shading();
+            virtual ~Shading();
 
             // =============== Public Attributes ================
         public:
@@ -40,6 +44,26 @@ namespace ofd{
             virtual void SetColorStops(const ColorStopArray &colorStops){};
             virtual ColorPtr GetColor(double offset) const {return nullptr;};
 
+            // 返回缓存的填充pattern，cr的缩放或目标表面类型与缓存时不同才重建。
+            // 返回值已增加引用计数，调用者需cairo_pattern_destroy()。线程安全。
+            cairo_pattern_t *GetFillPattern(cairo_t *cr);
+            virtual void InvalidateCache();
+
+        protected:
+            // pattern与cr相关时返回区分缓存的键，默认与cr无关。
+            virtual double getPatternKey(cairo_t *cr) const {return 0.0;};
+            // 光栅表面的像素R、B互换存放，颜色需互换后交给cairo；矢量表面按原顺序。
+            static bool isRasterTarget(cairo_t *cr);
+
+        private:
+            Shading(const Shading&) = delete;
+            Shading& operator=(const Shading&) = delete;
+
+            std::mutex       m_patternMutex;
+            cairo_pattern_t *m_fillPattern;
+            double           m_fillPatternKey;
+            bool             m_fillPatternRaster;
+
     }; // Shading
 
     // ======== class AxialShading ========
@@ -67,8 +91,20 @@ namespace ofd{
             virtual cairo_pattern_t *CreateFillPattern(cairo_t *cr) override;
             virtual void WriteShadingXML(utils::XMLWriter &writer) const override;
             virtual bool ReadShadingXML(utils::XMLElementPtr shadingElement) override;
-            virtual void SetColorStops(const ColorStopArray &colorStops) override {ColorSegments = colorStops;};
+            virtual void SetColorStops(const ColorStopArray &colorStops) override;
+            // 由预先插值的颜色表查得offset处的颜色。
             virtual ColorPtr GetColor(double offset) const override;
+            virtual void InvalidateCache() override;
+
+        protected:
+            void addColorStops(cairo_pattern_t *pattern, bool swapRB) const;
+
+        private:
+            static const int RampSize = 256;
+            // ColorSegments在[0, 1]上按RampSize级线性插值的结果。
+            ColorArray m_colorRamp;
+
+            void buildColorRamp();
     }; // class AxialShading
 
     // ======== class RadialShading ========
@@ -95,6 +131,9 @@ namespace ofd{
             virtual void WriteShadingXML(utils::XMLWriter &writer) const override;
             virtual bool ReadShadingXML(utils::XMLElementPtr shadingElement) override;
 
+        protected:
+            virtual double getPatternKey(cairo_t *cr) const override;
+
     }; // class RadialShading
 
 
@@ -0,0 +1,47 @@
+#ifndef __OFD_SURFACEPOOL_H__
+#define __OFD_SURFACEPOOL_H__
+
+#include <memory>
+#include <cairo/cairo.h>
+#include "ofd/Common.h"
+
+namespace ofd{
+
+    // ======== class SurfacePool ========
+    // cairo图像表面池，以(格式, 宽, 高)为键保存空闲表面。
+    // 批量绘制时各页的表面尺寸大多相同，归还的表面供下一页复用，
+    // 避免反复分配数MB的页面缓冲区及随之而来的缺页。
+    // 空闲表面总内存超出上限时淘汰最久未用的。线程安全。
+    class SurfacePool {
+        public:
+            static const size_t DefaultMaxBytes = 128 * 1024 * 1024;
+
+            SurfacePool(size_t maxBytes = DefaultMaxBytes);
+            ~SurfacePool();
+
+            // 进程共享的表面池，CairoRender、TileCache等默认从中借用表面。
+            static SurfacePool& GlobalInstance();
+
+            // 返回指定格式和尺寸的图像表面，内容未定义。
+            // 调用者用完后调用Release()归还，或直接cairo_surface_destroy()。
+            cairo_surface_t *Acquire(cairo_format_t format, int width, int height);
+
+            // 归还Acquire()或cairo_image_surface_create()得到的表面，接管调用者的引用。
+            // 表面仍被其它对象引用时只释放这一引用，不放入池中。
+            void Release(cairo_surface_t *surface);
+
+            void Clear();
+
+            size_t GetMaxBytes() const;
+            void SetMaxBytes(size_t maxBytes);
+            size_t GetIdleBytes() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class SurfacePool
+
+}; // namespace ofd
+
+#endif // __OFD_SURFACEPOOL_H__
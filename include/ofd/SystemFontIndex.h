@@ -0,0 +1,48 @@
+#ifndef __OFD_SYSTEMFONTINDEX_H__
+#define __OFD_SYSTEMFONTINDEX_H__
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ofd{
+
+    // ======== class SystemFontIndex ========
+    // 系统字体索引，用于定位External、Resident字体及替代字体。
+    //
+    // 扫描字体目录，以字体name表中的各种名称（含中文等本地化名称）为键建立索引，
+    // 查找只需一次散列表访问。索引保存为磁盘缓存，并记录各目录的修改时间，
+    // 目录未变化时新进程直接读取缓存，不再重新扫描字体文件。
+    // 字体集合（.ttc）只索引第一个字体，与Font::CreateFromData()一致。线程安全。
+    class SystemFontIndex {
+        public:
+            SystemFontIndex(const std::vector<std::string> &fontDirs, const std::string &cacheFile);
+            ~SystemFontIndex();
+
+            // 使用DefaultFontDirs()和DefaultCacheFile()的进程共享索引。
+            static SystemFontIndex& GlobalInstance();
+
+            static std::vector<std::string> DefaultFontDirs();
+            // 环境变量OFD_FONT_INDEX指定的文件，否则为$XDG_CACHE_HOME或~/.cache下的libofd/fontindex。
+            static std::string DefaultCacheFile();
+
+            // 按名称、粗体、斜体和OFD字符集（prc、big5、shift-jis、wansung、johab、unicode等）查找字体文件。
+            // 名称找不到或不支持字符集时返回支持该字符集的替代字体，substitute为true。
+            // 返回(字体文件路径, substitute, ok)。
+            std::tuple<std::string, bool, bool> FindFont(const std::string &name, bool bold, bool italic,
+                    const std::string &charset = "") const;
+
+            // 重新扫描字体目录并更新磁盘缓存。
+            bool Rebuild();
+            size_t GetNumFaces() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class SystemFontIndex
+
+}; // namespace ofd
+
+#endif // __OFD_SYSTEMFONTINDEX_H__
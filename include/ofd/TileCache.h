@@ -0,0 +1,57 @@
+#ifndef __OFD_TILECACHE_H__
+#define __OFD_TILECACHE_H__
+
+#include <memory>
+#include <cairo/cairo.h>
+#include "ofd/Common.h"
+#include "ofd/Render.h"
+
+namespace ofd{
+
+    // ======== class TileCache ========
+    // 页面绘制结果的分块缓存，与具体窗口系统无关。
+    //
+    // 以(页面, 绘制质量, 缩放比例, 块坐标)为键缓存TileSize x TileSize像素的绘制结果。
+    // 块坐标在设备空间中划分，设备坐标 = resolution/72 * (scaling * 页面坐标 - pixel)，
+    // 与CairoRender::DrawPage()的VisibleParams含义一致。
+    // 平移时只需绘制新露出的块；缩放时未绘制的块先用其它缩放比例下
+    // 已缓存的块拉伸代替，待后续调用补绘清晰结果。
+    // 总占用内存超出预算时按LRU淘汰。非线程安全。
+    class TileCache {
+        public:
+            static const int DefaultTileSize = 256;
+            static const size_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+            TileCache(double resolutionX, double resolutionY, int tileSize = DefaultTileSize, size_t maxBytes = DefaultMaxBytes);
+            ~TileCache();
+
+            // 将页面的可见区域合成到cr（设备空间左上角为视口原点）。
+            // 每次调用最多绘制maxRenderTiles个缺失块，其余以近似结果代替。
+            // drawControl被取消或超时后不再绘制新块，未完成的块不进入缓存。
+            // 返回仍缺失（未清晰绘制）的块数，为0表示视口已完整。
+            size_t DrawViewport(cairo_t *cr, PagePtr page, VisibleParams visibleParams,
+                    int viewWidth, int viewHeight, size_t maxRenderTiles = (size_t)-1,
+                    const DrawControl &drawControl = DrawControl());
+
+            // 页面内容改变后需使其缓存失效。
+            void InvalidatePage(PagePtr page);
+            void Clear();
+
+            const DrawState& GetDrawState() const;
+            DrawState& GetDrawState();
+
+            int GetTileSize() const;
+            size_t GetMaxBytes() const;
+            void SetMaxBytes(size_t maxBytes);
+            size_t GetUsedBytes() const;
+
+        private:
+            class ImplCls;
+            std::unique_ptr<ImplCls> m_impl;
+
+    }; // class TileCache
+    typedef std::shared_ptr<TileCache> TileCachePtr;
+
+}; // namespace ofd
+
+#endif // __OFD_TILECACHE_H__
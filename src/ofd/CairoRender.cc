@@ -1,12 +1,16 @@
 #include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <list>
+#include <unordered_map>
 
-// Poppler MemStream
-#include <Object.h>
-#include <Stream.h>
+// Poppler GBool
+#include <goo/gtypes.h>
 
 #include <cairo.h>
 #include <cairo-ft.h>
 #include "ofd/CairoRender.h"
+#include "ofd/Package.h"
 #include "ofd/Document.h"
 #include "ofd/Page.h"
 #include "ofd/Layer.h"
@@ -22,7 +26,13 @@
 #include "ofd/CompositeObject.h"
 #include "ofd/Path.h"
 #include "ofd/Image.h"
+#include "ofd/ImageCache.h"
+#include "ofd/ImageDecoder.h"
+#include "ofd/ColorConvert.h"
 #include "ofd/DrawState.h"
+#include "ofd/RectFill.h"
+#include "ofd/SurfacePool.h"
+#include "ofd/GlyphAtlas.h"
 #include "utils/logger.h"
 #include "utils/unicode.h"
 
@@ -34,21 +44,196 @@ void showCairoMatrix(cairo_t *cr, const std::string &title, const std::string &m
     //LOG(DEBUG) << "[" << title << "] " << msg << " ShowCairoMatrix() cairo_get_matrix()=(" << matrix.xx << "," << matrix.yx << "," << matrix.xy << "," << matrix.yy << "," << matrix.x0 << "," << matrix.y0 << ")";
 }
 
+// **************** class CairoStateTracker ****************
+
+// 记录cairo_t当前的CTM、线宽、填充规则和source，
+// 仅在目标状态与当前状态不同时才调用cairo接口，
+// 用于替代逐对象的cairo_save()/cairo_restore()。
+class CairoStateTracker {
+public:
+    CairoStateTracker() : m_cr(nullptr), m_lineWidth(0.0),
+        m_fillRule(CAIRO_FILL_RULE_WINDING), m_source(nullptr){
+    }
+
+    // 以cr的当前状态为基准开始跟踪，对象CTM相对于此时的矩阵。
+    void Begin(cairo_t *cr){
+        m_cr = cr;
+        cairo_get_matrix(cr, &m_baseMatrix);
+        m_matrix = m_baseMatrix;
+        m_lineWidth = cairo_get_line_width(cr);
+        m_fillRule = cairo_get_fill_rule(cr);
+        m_source = cairo_get_source(cr);
+    }
+
+    void End(){
+        m_cr = nullptr;
+        m_source = nullptr;
+    }
+
+    void SetCTM(const double *ctm){
+        cairo_matrix_t objMatrix;
+        cairo_matrix_init(&objMatrix, ctm[0], ctm[1], ctm[2], ctm[3], ctm[4], ctm[5]);
+        cairo_matrix_t matrix;
+        cairo_matrix_multiply(&matrix, &objMatrix, &m_baseMatrix);
+        if ( matrix.xx != m_matrix.xx || matrix.yx != m_matrix.yx ||
+                matrix.xy != m_matrix.xy || matrix.yy != m_matrix.yy ||
+                matrix.x0 != m_matrix.x0 || matrix.y0 != m_matrix.y0 ){
+            cairo_set_matrix(m_cr, &matrix);
+            m_matrix = matrix;
+        }
+    }
+
+    // 恢复为Begin()时的基准矩阵，非路径对象的CTM在此基础上变换。
+    void ResetCTM(){
+        if ( m_matrix.xx != m_baseMatrix.xx || m_matrix.yx != m_baseMatrix.yx ||
+                m_matrix.xy != m_baseMatrix.xy || m_matrix.yy != m_baseMatrix.yy ||
+                m_matrix.x0 != m_baseMatrix.x0 || m_matrix.y0 != m_baseMatrix.y0 ){
+            cairo_set_matrix(m_cr, &m_baseMatrix);
+            m_matrix = m_baseMatrix;
+        }
+    }
+
+    void SetLineWidth(double lineWidth){
+        if ( lineWidth != m_lineWidth ){
+            cairo_set_line_width(m_cr, lineWidth);
+            m_lineWidth = lineWidth;
+        }
+    }
+
+    void SetFillRule(cairo_fill_rule_t fillRule){
+        if ( fillRule != m_fillRule ){
+            cairo_set_fill_rule(m_cr, fillRule);
+            m_fillRule = fillRule;
+        }
+    }
+
+    void SetSource(cairo_pattern_t *source){
+        if ( source != m_source ){
+            cairo_set_source(m_cr, source);
+            m_source = source;
+        }
+    }
+
+private:
+    cairo_t *m_cr;
+    cairo_matrix_t m_baseMatrix;
+    cairo_matrix_t m_matrix;
+    double m_lineWidth;
+    cairo_fill_rule_t m_fillRule;
+    cairo_pattern_t *m_source;
+
+}; // class CairoStateTracker
+
+// **************** class StaticLayerCache ****************
+
+// 静态图层（背景层、前景层）栅格化结果的缓存。
+// 以(图层, 缩放比例, 绘制质量)为键保存整页大小的ARGB32表面，重绘时直接合成。
+// 引用同一模板的页面共享同一图层对象，因此也共享缓存结果。
+// 图层对象数改变或图层被释放后缓存项失效。总占用内存超出预算时按LRU淘汰。
+class StaticLayerCache {
+public:
+    static const size_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+    StaticLayerCache() : m_maxBytes(DefaultMaxBytes), m_usedBytes(0){
+    }
+
+    ~StaticLayerCache(){
+        Clear();
+    }
+
+    // 命中时返回缓存的表面（不增加引用计数），否则返回nullptr。
+    cairo_surface_t *Lookup(LayerPtr layer, double scaling, RenderQuality quality){
+        int64_t scaleKey = llround(scaling * 1e4);
+        for ( auto it = m_entries.begin() ; it != m_entries.end() ; it++ ){
+            if ( it->LayerRef.lock() != layer ) continue;
+            if ( it->ScaleKey != scaleKey || it->Quality != quality ) continue;
+            if ( it->NumObjects != layer->GetNumObjects() ){
+                erase(it);
+                return nullptr;
+            }
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return m_entries.front().Surface;
+        }
+        return nullptr;
+    }
+
+    // 接管surface的引用。
+    void Insert(LayerPtr layer, double scaling, RenderQuality quality, cairo_surface_t *surface){
+        Entry entry;
+        entry.LayerRef = layer;
+        entry.ScaleKey = llround(scaling * 1e4);
+        entry.Quality = quality;
+        entry.NumObjects = layer->GetNumObjects();
+        entry.Surface = surface;
+        entry.Bytes = (size_t)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+        m_entries.push_front(entry);
+        m_usedBytes += entry.Bytes;
+
+        // 至少保留最近插入的一项，同时清除已释放图层的缓存项。
+        auto it = std::next(m_entries.begin());
+        while ( it != m_entries.end() ){
+            if ( it->LayerRef.expired() ){
+                it = erase(it);
+            } else {
+                it++;
+            }
+        }
+        while ( m_usedBytes > m_maxBytes && m_entries.size() > 1 ){
+            erase(std::prev(m_entries.end()));
+        }
+    }
+
+    void Clear(){
+        for ( auto &entry : m_entries ){
+            cairo_surface_destroy(entry.Surface);
+        }
+        m_entries.clear();
+        m_usedBytes = 0;
+    }
+
+    size_t GetMaxBytes() const {return m_maxBytes;};
+
+private:
+    typedef struct Entry{
+        std::weak_ptr<Layer> LayerRef;
+        int64_t ScaleKey;
+        RenderQuality Quality;
+        size_t NumObjects;
+        cairo_surface_t *Surface;
+        size_t Bytes;
+    } Entry_t;
+    typedef std::list<Entry> EntryList;
+
+    EntryList::iterator erase(EntryList::iterator it){
+        m_usedBytes -= it->Bytes;
+        cairo_surface_destroy(it->Surface);
+        return m_entries.erase(it);
+    }
+
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+    EntryList m_entries; // 最近使用的在前
+
+}; // class StaticLayerCache
+
 // **************** class CairoRender::ImplCls ****************
 
 class CairoRender::ImplCls {
 public:
     //ImplCls(CairoRender *cairoRender, cairo_surface_t *surface);
     ImplCls(CairoRender *cairoRender, double pixelWidth, double pixelHeight, double resolutionX, double resolutionY);
+    ImplCls(CairoRender *cairoRender, cairo_surface_t *surface, double resolutionX, double resolutionY);
     ~ImplCls();
 
     void Rebuild(double pixelWidth, double pixelHeight, double resolutionX, double resolutionY);
+    void Reset();
     //void SetCairoSurface(cairo_surface_t *surface);
-    void DrawPage(PagePtr page, VisibleParams visibleParams);
+    bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl);
     void DrawObject(ObjectPtr object);
 
     void Paint(cairo_surface_t *surface);
     bool WriteToPNG(const std::string &filename);
+    bool WriteImage(const std::string &filename, const EncodeParams &params);
 
     void SetLineWidth(double lineWidth);
     void UpdateStrokePattern(double R, double G, double B, double opacity);
@@ -63,8 +248,29 @@ public:
 
 private:
     void Destroy();
+    void initContext();
+    bool isDraft() const {return m_cairoRender->GetRenderQuality() == RenderQuality::Draft;};
+    // 目标为PDF、SVG、PS等矢量表面时不做光栅化相关的优化。
+    bool isVectorTarget() const {return cairo_surface_get_type(m_surface) != CAIRO_SURFACE_TYPE_IMAGE;};
+    // 光栅表面的像素R在最低字节（见ColorConvert.h），颜色以R、B互换后的顺序交给cairo；
+    // 矢量表面由cairo按颜色值原样写出，不能互换。
+    void toTargetRGB(double &r, double &b) const { if ( !isVectorTarget() ) std::swap(r, b); };
+    cairo_surface_t *createVectorImageSurface(cairo_surface_t *imageSurface);
+    void setImageMimeData(cairo_surface_t *imageSurface, ImageObject *imageObject);
     void DrawTextObject(cairo_t *cr, TextObject *textObject);
+    void DrawGreekText(cairo_t *cr, TextObject *textObject);
     void DrawPathObject(cairo_t *cr, PathObject *pathObject);
+    bool drawLayer(cairo_t *cr, LayerPtr layer, const DrawControl &drawControl, size_t &numDrawn, size_t numTotal);
+    bool drawLayerProgressive(LayerPtr layer, const std::vector<DrawPass> &objectPasses,
+            const DrawControl &drawControl, size_t &numDrawn, size_t numTotal);
+    bool drawStaticLayer(PagePtr page, LayerPtr layer, double scaling,
+            const DrawControl &drawControl, size_t &numDrawn, size_t numTotal);
+    void drawTrackedObject(ObjectPtr object);
+    void drawTrackedPathObject(PathObject *pathObject);
+    void captureFastRectClip();
+    bool fillRectsFast(PathObject *pathObject, cairo_pattern_t *pattern, bool isStroke);
+    cairo_pattern_t *getSolidPattern(double r, double g, double b, double a);
+    void clearSolidPatterns();
     void DrawImageObject(cairo_t *cr, ImageObject *imageObject);
     void DrawVideoObject(cairo_t *cr, VideoObject *videoObject);
     void DrawCompositeObject(cairo_t *cr, CompositeObject *compositeObject);
@@ -72,6 +278,7 @@ private:
 public:
     CairoRender *m_cairoRender;
     cairo_surface_t *m_surface;
+    bool m_pooledSurface; // m_surface借自SurfacePool，释放时归还
     cairo_t *m_cr;
     double m_pixelWidth;
     double m_pixelHeight;
@@ -80,6 +287,13 @@ public:
     double m_lineWidth;
 
     cairo_pattern_t *m_fillPattern, *m_strokePattern;
+    std::unordered_map<uint32_t, cairo_pattern_t*> m_solidPatterns; // 按RGBA缓存的纯色pattern
+    CairoStateTracker m_stateTracker;
+    StaticLayerCache m_layerCache;
+    // drawLayer()期间矩形快速填充的目标表面及设备空间裁剪矩形，
+    // m_fastRectTarget为nullptr时不使用快速填充。
+    cairo_surface_t *m_fastRectTarget;
+    double m_fastRectClip[4];
     //ofd::OfdRGB m_strokeColor;
     //ofd::OfdRGB m_fillColor;
 
@@ -100,16 +314,32 @@ private:
 //}
 
 CairoRender::ImplCls::ImplCls(CairoRender *cairoRender, double pixelWidth, double pixelHeight, double resolutionX, double resolutionY) :
-    m_cairoRender(cairoRender), m_surface(nullptr), m_cr(nullptr),
+    m_cairoRender(cairoRender), m_surface(nullptr), m_pooledSurface(false), m_cr(nullptr),
     m_pixelWidth(pixelWidth), m_pixelHeight(pixelHeight), 
     m_resolutionX(resolutionX), m_resolutionY(resolutionY),
     m_lineWidth(1.0),
-    m_fillPattern(nullptr), m_strokePattern(nullptr){
+    m_fillPattern(nullptr), m_strokePattern(nullptr), m_fastRectTarget(nullptr){
 
     //LOG(INFO) << "New CairoRender with pixelWidth=" << pixelWidth << " pixelHeight=" << std::dec << pixelHeight << " resolutionX=" << resolutionX << " resolutionY=" << resolutionY;
     Rebuild(pixelWidth, pixelHeight, resolutionX, resolutionY);
 }
 
+CairoRender::ImplCls::ImplCls(CairoRender *cairoRender, cairo_surface_t *surface, double resolutionX, double resolutionY) :
+    m_cairoRender(cairoRender), m_surface(nullptr), m_pooledSurface(false), m_cr(nullptr),
+    m_pixelWidth(0), m_pixelHeight(0), 
+    m_resolutionX(resolutionX), m_resolutionY(resolutionY),
+    m_lineWidth(1.0),
+    m_fillPattern(nullptr), m_strokePattern(nullptr), m_fastRectTarget(nullptr){
+
+    assert(surface != nullptr);
+    m_surface = cairo_surface_reference(surface);
+    if ( cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_IMAGE ){
+        m_pixelWidth = cairo_image_surface_get_width(m_surface);
+        m_pixelHeight = cairo_image_surface_get_height(m_surface);
+    }
+    initContext();
+}
+
 void setDefaultCTM(cairo_t *cr){
     cairo_matrix_t matrix0;
     matrix0.xx = 1.0;
@@ -134,15 +364,63 @@ void clearCTM(cairo_t *cr){
     cairo_transform(cr, &matrix0);
 }
 
+// 尺寸不变时只重置上下文，否则归还原表面并从表面池借用新尺寸的表面。
 void CairoRender::ImplCls::Rebuild(double pixelWidth, double pixelHeight, double resolutionX, double resolutionY){
+    bool sameSize = m_pooledSurface && m_surface != nullptr &&
+        cairo_image_surface_get_width(m_surface) == (int)pixelWidth &&
+        cairo_image_surface_get_height(m_surface) == (int)pixelHeight;
+
+    bool sameResolution = resolutionX == m_resolutionX && resolutionY == m_resolutionY;
+
+    m_pixelWidth = pixelWidth;
+    m_pixelHeight = pixelHeight;
+    m_resolutionX = resolutionX;
+    m_resolutionY = resolutionY;
+
+    if ( sameSize ){
+        // 静态图层缓存的键不含分辨率，分辨率改变后缓存的栅格结果不再适用。
+        if ( !sameResolution ){
+            m_layerCache.Clear();
+        }
+        Reset();
+        return;
+    }
+
     Destroy();
 
-    m_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, m_pixelWidth, m_pixelHeight);
-    if ( m_surface == nullptr ){
+    m_surface = SurfacePool::GlobalInstance().Acquire(CAIRO_FORMAT_ARGB32, (int)m_pixelWidth, (int)m_pixelHeight);
+    m_pooledSurface = true;
+    if ( cairo_surface_status(m_surface) != CAIRO_STATUS_SUCCESS ){
         LOG(ERROR) << "create_image_surface() failed. ";
-        return;
     }
 
+    initContext();
+}
+
+// ======== CairoRender::ImplCls::Reset() ========
+// 为绘制下一页重建cairo上下文并清除背景，保留表面、纯色pattern和静态图层缓存。
+void CairoRender::ImplCls::Reset(){
+    if ( m_surface == nullptr ) return;
+
+    if ( m_cr != nullptr ){
+        cairo_destroy(m_cr);
+        m_cr = nullptr;
+    }
+    if ( m_strokePattern != nullptr ){
+        cairo_pattern_destroy(m_strokePattern);
+        m_strokePattern = nullptr;
+    }
+    if ( m_fillPattern != nullptr ){
+        cairo_pattern_destroy(m_fillPattern);
+        m_fillPattern = nullptr;
+    }
+    m_fastRectTarget = nullptr;
+    m_lineWidth = 1.0;
+
+    initContext();
+}
+
+void CairoRender::ImplCls::initContext(){
     m_cr = cairo_create(m_surface);
 
     m_fillPattern = cairo_pattern_create_rgb(0., 0., 0.);
@@ -151,8 +429,11 @@ void CairoRender::ImplCls::Rebuild(double pixelWidth, double pixelHeight, double
     cairo_scale(m_cr, m_resolutionX/ 72.0, m_resolutionY / 72.0);
 
     // Repaint background
-    cairo_set_source_rgb(m_cr, 1., 1., 1.);
-    cairo_paint(m_cr);
+    // 矢量输出的页面本身为白色，不必绘制背景。
+    if ( !isVectorTarget() ){
+        cairo_set_source_rgb(m_cr, 1., 1., 1.);
+        cairo_paint(m_cr);
+    }
 
     // FIXME
     //setDefaultCTM(m_cr);
@@ -161,7 +442,18 @@ void CairoRender::ImplCls::Rebuild(double pixelWidth, double pixelHeight, double
 }
 
 bool CairoRender::ImplCls::WriteToPNG(const std::string &filename){
-    return cairo_surface_write_to_png(m_surface, filename.c_str());
+    EncodeParams params;
+    params.Format = ImageFormat::PNG;
+    params.ResolutionX = m_resolutionX;
+    params.ResolutionY = m_resolutionY;
+    return WriteImage(filename, params);
+}
+
+bool CairoRender::ImplCls::WriteImage(const std::string &filename, const EncodeParams &params){
+    if ( m_surface == nullptr || isVectorTarget() ) return false;
+    ImageEncoderPtr encoder = ImageEncoderFactory::CreateEncoder(params);
+    if ( encoder == nullptr ) return false;
+    return encoder->EncodeToFile(m_surface, filename);
 }
 
 void CairoRender::ImplCls::Paint(cairo_surface_t *surface){
@@ -174,6 +466,7 @@ void CairoRender::ImplCls::Paint(cairo_surface_t *surface){
 void CairoRender::ImplCls::Destroy(){
     if ( m_cr != nullptr ){
         cairo_destroy(m_cr);
+        m_cr = nullptr;
     }
 
     if ( m_strokePattern != nullptr ){
@@ -186,9 +479,17 @@ void CairoRender::ImplCls::Destroy(){
         m_fillPattern = nullptr;
     }
 
+    clearSolidPatterns();
+    m_layerCache.Clear();
+
     if ( m_surface != nullptr ){
-        cairo_surface_destroy(m_surface);
+        if ( m_pooledSurface ){
+            SurfacePool::GlobalInstance().Release(m_surface);
+        } else {
+            cairo_surface_destroy(m_surface);
+        }
         m_surface = nullptr;
+        m_pooledSurface = false;
     }
 }
 
@@ -333,31 +634,59 @@ void DrawFreeTypeString(double X, double Y, const std::string &text, cairo_t *cr
     cairo_scaled_font_destroy(scaled_font);
 }
 
-// ======== CairoRender::ImplCls::Draw() ========
-void CairoRender::ImplCls::DrawPage(PagePtr page, VisibleParams visibleParams){
-    if ( page == nullptr ) return;
-    if ( m_surface == nullptr ) return;
+// 对象所属的绘制优先级分组。
+static DrawPass getObjectDrawPass(ObjectPtr object){
+    if ( object->Type == ofd::ObjectType::TEXT ){
+        return DrawPass::Vector;
+    } else if ( object->Type == ofd::ObjectType::PATH ){
+        const PathObject *pathObject = (const PathObject*)object.get();
+        return pathObject->FillShading != nullptr ? DrawPass::Effect : DrawPass::Vector;
+    } else if ( object->Type == ofd::ObjectType::IMAGE ){
+        return DrawPass::Image;
+    } else {
+        return DrawPass::Effect;
+    }
+}
+
+// ======== CairoRender::ImplCls::DrawPage() ========
+bool CairoRender::ImplCls::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    if ( page == nullptr ) return true;
+    if ( m_surface == nullptr ) return true;
     double pixelX;
     double pixelY;
     double scaling;
     std::tie(pixelX, pixelY, scaling) = m_cairoRender->GetVisibleParams();
 
-    const LayerPtr bodyLayer = page->GetBodyLayer(); 
-    if ( bodyLayer == nullptr ) {
-        LOG(WARNING) << "page->GetBodyLayer() return nullptr. Maybe NULL content.";
-        return;
+    const LayerArray layers = page->GetDrawingLayers();
+    if ( layers.size() == 0 ) {
+        LOG(WARNING) << "page->GetDrawingLayers() return no layer. Maybe NULL content.";
+        return true;
+    }
+    size_t numObjects = 0;
+    for ( auto layer : layers ){
+        numObjects += layer->GetNumObjects();
     }
-    size_t numObjects = bodyLayer->GetNumObjects();
     if ( numObjects == 0 ){
-        return;
+        return true;
     }
 
-    cairo_set_source_rgb(m_cr, 1.0, 1.0, 1.0);
-    cairo_paint(m_cr);
+    if ( !isVectorTarget() ){
+        cairo_set_source_rgb(m_cr, 1.0, 1.0, 1.0);
+        cairo_paint(m_cr);
+    }
 
     cairo_translate(m_cr, -pixelX, -pixelY);
     cairo_scale(m_cr, scaling, scaling);
 
+    // Draft质量下使用较粗的曲线逼近和较快的抗锯齿。
+    if ( isDraft() ){
+        cairo_set_antialias(m_cr, CAIRO_ANTIALIAS_FAST);
+        cairo_set_tolerance(m_cr, 0.5);
+    } else {
+        cairo_set_antialias(m_cr, CAIRO_ANTIALIAS_DEFAULT);
+        cairo_set_tolerance(m_cr, 0.1);
+    }
+
     //cairo_set_source_rgb(m_cr, 0.0, 0.0, 0.0);
     //cairo_rectangle(m_cr, 0, 0 + 0.5, 18.1944, 18.1944 + 0.5);
     //cairo_stroke(m_cr);
@@ -369,35 +698,461 @@ void CairoRender::ImplCls::DrawPage(PagePtr page, VisibleParams visibleParams){
     //FontPtr defaultFont = page->GetOFDDocument()->GetDocumentRes()->GetFont(0);
     //assert(defaultFont != nullptr);
 
+    // -------- 按背景层、正文层、前景层次序绘制 --------
+    // 背景层、前景层和模板页图层内容不随记录变化，栅格化后缓存复用。
+    size_t numDrawn = 0;
+    for ( auto layer : layers ){
+        if ( layer->GetNumObjects() == 0 ) continue;
+        bool completed = false;
+        bool isStatic = layer->Type == LayerType::BACKGROUND || layer->Type == LayerType::FOREGROUND ||
+                page->IsTemplateLayer(layer);
+        if ( isStatic && !isVectorTarget() ){
+            completed = drawStaticLayer(page, layer, scaling, drawControl, numDrawn, numObjects);
+        } else {
+            completed = drawLayer(m_cr, layer, drawControl, numDrawn, numObjects);
+        }
+        if ( !completed ) return false;
+    }
+
+    return true;
+}
+
+// ======== CairoRender::ImplCls::drawLayer() ========
+// 将图层绘制到cr，cr的CTM需已设置为页面坐标。被中断时返回false。
+bool CairoRender::ImplCls::drawLayer(cairo_t *cr, LayerPtr layer, const DrawControl &drawControl, size_t &numDrawn, size_t numTotal){
+    size_t numObjects = layer->GetNumObjects();
+
+    std::vector<DrawPass> objectPasses(numObjects);
+    for ( size_t i = 0 ; i < numObjects ; i++ ){
+        objectPasses[i] = getObjectDrawPass(layer->GetObject(i));
+    }
+
+    // 渐进式绘制只用于直接显示的页面表面，静态图层缓存的离屏绘制仍按文档顺序。
+    if ( drawControl.Progressive && cr == m_cr && !isVectorTarget() ){
+        return drawLayerProgressive(layer, objectPasses, drawControl, numDrawn, numTotal);
+    }
+
+    // 绘制期间各绘制函数作用于cr。
+    cairo_t *pageCr = m_cr;
+    m_cr = cr;
+
+    // 整个图层只保存一次状态，对象间的冗余状态设置由m_stateTracker消除。
+    cairo_save(m_cr);
+    captureFastRectClip();
+    m_stateTracker.Begin(m_cr);
+
+    bool completed = true;
     for ( size_t i = 0 ; i < numObjects ; i++ ){
-        const ObjectPtr object = bodyLayer->GetObject(i);
+        if ( drawControl.IsAborted() ){
+            completed = false;
+            break;
+        }
+
+        const ObjectPtr object = layer->GetObject(i);
         assert(object != nullptr);
+        drawTrackedObject(object);
 
-        // FIXME
-        //uint64_t id = object->ID;
-        //if ( id <= 5 ){
-            ////if ( id == 0 ){
-                ////continue;
-            ////} else if (id == 1 ){
-                ////continue;
-            ////} else if (id == 2 ){
-                ////continue;
-            ////} else if (id == 3 ){
-                ////continue;
-            ////} else if (id == 4 ){
-                ////continue;
-            ////} else { 
-                ////continue;
-            ////}
-
-        //} else if (id >= 38 && id <= 42 ){
-            //continue;
-        //} else {
-        //}
+        numDrawn++;
+        if ( drawControl.ProgressFunc ){
+            drawControl.ProgressFunc(objectPasses[i], numDrawn, numTotal);
+        }
+    }
+
+    m_stateTracker.End();
+    m_fastRectTarget = nullptr;
+    cairo_restore(m_cr);
+
+    m_cr = pageCr;
+
+    return completed;
+}
+
+// 渐进式绘制中同一DrawPass的连续对象[Begin, End)，绘制结果保存为离屏pattern。
+typedef struct LayerSegment{
+    size_t Begin;
+    size_t End;
+    DrawPass Pass;
+    cairo_pattern_t *Pattern;
+} LayerSegment_t;
+
+// 以图层绘制前的背景为底，按文档顺序合成已绘制的片段。
+static void compositeLayerSegments(cairo_t *cr, cairo_surface_t *background, const std::vector<LayerSegment> &segments){
+    cairo_save(cr);
+    cairo_identity_matrix(cr);
+    cairo_set_source_surface(cr, background, 0, 0);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    for ( auto &segment : segments ){
+        if ( segment.Pattern == nullptr ) continue;
+        cairo_set_source(cr, segment.Pattern);
+        cairo_paint(cr);
+    }
+}
+
+// ======== CairoRender::ImplCls::drawLayerProgressive() ========
+// 按DrawPass分组渐进绘制图层到m_cr。图层按文档顺序划分为同组对象的连续片段，
+// 每个片段只绘制一次到独立的离屏表面，每组完成后按文档顺序重新合成，
+// 因此中间结果缺少后续组的对象，最终结果与按文档顺序绘制一致。
+// 片段表面总大小超出静态图层缓存预算时不做渐进绘制。
+bool CairoRender::ImplCls::drawLayerProgressive(LayerPtr layer, const std::vector<DrawPass> &objectPasses,
+        const DrawControl &drawControl, size_t &numDrawn, size_t numTotal){
+    size_t numObjects = objectPasses.size();
+
+    std::vector<LayerSegment> segments;
+    for ( size_t i = 0 ; i < numObjects ; i++ ){
+        if ( segments.empty() || segments.back().Pass != objectPasses[i] ){
+            LayerSegment segment = {i, i + 1, objectPasses[i], nullptr};
+            segments.push_back(segment);
+        } else {
+            segments.back().End = i + 1;
+        }
+    }
+
+    cairo_surface_t *target = cairo_get_target(m_cr);
+    int width = cairo_image_surface_get_width(target);
+    int height = cairo_image_surface_get_height(target);
+    if ( segments.size() <= 1 ||
+            (size_t)width * height * 4 * (segments.size() + 1) > m_layerCache.GetMaxBytes() ){
+        DrawControl orderedControl = drawControl;
+        orderedControl.Progressive = false;
+        return drawLayer(m_cr, layer, orderedControl, numDrawn, numTotal);
+    }
+
+    cairo_surface_t *background = cairo_image_surface_create(cairo_image_surface_get_format(target), width, height);
+    cairo_t *backgroundCr = cairo_create(background);
+    cairo_set_source_surface(backgroundCr, target, 0, 0);
+    cairo_set_operator(backgroundCr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(backgroundCr);
+    cairo_destroy(backgroundCr);
+
+    const size_t numPasses = (size_t)DrawPass::Effect + 1;
+    bool completed = true;
+    for ( size_t p = 0 ; p < numPasses && completed ; p++ ){
+        DrawPass pass = (DrawPass)p;
+        bool passDrawn = false;
+        for ( auto &segment : segments ){
+            if ( segment.Pass != pass ) continue;
+
+            cairo_push_group(m_cr);
+            captureFastRectClip();
+            m_stateTracker.Begin(m_cr);
+            for ( size_t i = segment.Begin ; i < segment.End ; i++ ){
+                if ( drawControl.IsAborted() ){
+                    completed = false;
+                    break;
+                }
+
+                const ObjectPtr object = layer->GetObject(i);
+                assert(object != nullptr);
+                drawTrackedObject(object);
+
+                numDrawn++;
+                if ( drawControl.ProgressFunc ){
+                    drawControl.ProgressFunc(pass, numDrawn, numTotal);
+                }
+            }
+            m_stateTracker.End();
+            m_fastRectTarget = nullptr;
+            segment.Pattern = cairo_pop_group(m_cr);
+            passDrawn = true;
+
+            if ( !completed ) break;
+        }
+        if ( passDrawn ){
+            compositeLayerSegments(m_cr, background, segments);
+        }
+    }
+
+    for ( auto &segment : segments ){
+        if ( segment.Pattern != nullptr ){
+            cairo_pattern_destroy(segment.Pattern);
+        }
+    }
+    cairo_surface_destroy(background);
+
+    return completed;
+}
+
+// ======== CairoRender::ImplCls::drawStaticLayer() ========
+// 以整页大小栅格化图层并缓存，再按可见区域合成到m_cr。
+// 整页表面超出缓存预算的一半时（高倍缩放）直接绘制。
+// 缓存的表面按分辨率和scaling栅格化，只能平移合成。m_cr的CTM含旋转、斜切
+// 或其他缩放（调用者另行变换过）时直接绘制。
+bool CairoRender::ImplCls::drawStaticLayer(PagePtr page, LayerPtr layer, double scaling,
+        const DrawControl &drawControl, size_t &numDrawn, size_t numTotal){
+    cairo_matrix_t ctm;
+    cairo_get_matrix(m_cr, &ctm);
+    double scaleX = scaling * m_resolutionX / 72.0;
+    double scaleY = scaling * m_resolutionY / 72.0;
+    if ( fabs(ctm.xx - scaleX) > 1e-6 * scaleX || fabs(ctm.yy - scaleY) > 1e-6 * scaleY ||
+            ctm.xy != 0.0 || ctm.yx != 0.0 ){
+        return drawLayer(m_cr, layer, drawControl, numDrawn, numTotal);
+    }
+
+    RenderQuality quality = m_cairoRender->GetRenderQuality();
+
+    cairo_surface_t *surface = m_layerCache.Lookup(layer, scaling, quality);
+    if ( surface != nullptr ){
+        numDrawn += layer->GetNumObjects();
+        if ( drawControl.ProgressFunc ){
+            drawControl.ProgressFunc(DrawPass::Vector, numDrawn, numTotal);
+        }
+    } else {
+        ST_Box pageBox = page->Area.ApplicationBox;
+        if ( pageBox.Width <= 0.0 || pageBox.Height <= 0.0 ){
+            pageBox = page->Area.PhysicalBox;
+        }
+        int layerWidth = (int)ceil(pageBox.Width * scaling * m_resolutionX / 72.0);
+        int layerHeight = (int)ceil(pageBox.Height * scaling * m_resolutionY / 72.0);
+        if ( layerWidth <= 0 || layerHeight <= 0 ||
+                (size_t)layerWidth * layerHeight * 4 > m_layerCache.GetMaxBytes() / 2 ){
+            return drawLayer(m_cr, layer, drawControl, numDrawn, numTotal);
+        }
 
-        DrawObject(object);
+        surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, layerWidth, layerHeight);
+        if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+            cairo_surface_destroy(surface);
+            return drawLayer(m_cr, layer, drawControl, numDrawn, numTotal);
+        }
+
+        cairo_t *cr = cairo_create(surface);
+        cairo_scale(cr, m_resolutionX / 72.0, m_resolutionY / 72.0);
+        cairo_scale(cr, scaling, scaling);
+        cairo_set_antialias(cr, cairo_get_antialias(m_cr));
+        cairo_set_tolerance(cr, cairo_get_tolerance(m_cr));
+        bool completed = drawLayer(cr, layer, drawControl, numDrawn, numTotal);
+        cairo_destroy(cr);
+
+        // 未完成的图层不进入缓存。
+        if ( !completed ){
+            cairo_surface_destroy(surface);
+            return false;
+        }
+        m_layerCache.Insert(layer, scaling, quality, surface);
+    }
+
+    // 图层表面的原点为页面坐标原点，取其在设备空间中的位置。
+    double deviceX = 0.0, deviceY = 0.0;
+    cairo_user_to_device(m_cr, &deviceX, &deviceY);
+    cairo_save(m_cr);
+    cairo_identity_matrix(m_cr);
+    cairo_set_source_surface(m_cr, surface, deviceX, deviceY);
+    cairo_paint(m_cr);
+    cairo_restore(m_cr);
+
+    return true;
+}
+
+// ======== CairoRender::ImplCls::drawTrackedObject() ========
+// DrawPage()内部使用。纯色路径对象直接在跟踪的状态上绘制，
+// 其余对象仍经由DrawObject()的save/restore，恢复后的状态与跟踪状态一致。
+// 文字、图像等对象的CTM相对于图层的基准矩阵，绘制前先撤销上一个路径对象的CTM。
+void CairoRender::ImplCls::drawTrackedObject(ObjectPtr object){
+    if ( object->Type == ofd::ObjectType::PATH ){
+        PathObject *pathObject = (PathObject*)object.get();
+        if ( pathObject->FillShading == nullptr ){
+            drawTrackedPathObject(pathObject);
+            return;
+        }
+    }
+    m_stateTracker.ResetCTM();
+    DrawObject(object);
+}
+
+// ======== CairoRender::ImplCls::drawTrackedPathObject() ========
+// 与doDrawPathObject()的绘制结果相同，但不改变跟踪状态以外的图形状态。
+void CairoRender::ImplCls::drawTrackedPathObject(PathObject *pathObject){
+    const DrawState &drawState = m_cairoRender->GetDrawState();
+    if ( drawState.Debug.Enabled && drawState.Debug.PathObjectID != pathObject->ID){
+        return;
+    }
+
+    cairo_t *cr = m_cr;
+    m_stateTracker.SetCTM(&pathObject->CTM[0]);
+
+    ColorPtr strokeColor = pathObject->GetStrokeColor();
+
+    // Draft质量下不绘制设备空间中过细的线。
+    if ( strokeColor != nullptr && isDraft() ){
+        double dx = pathObject->LineWidth;
+        double dy = 0.0;
+        cairo_user_to_device_distance(cr, &dx, &dy);
+        if ( sqrt(dx * dx + dy * dy) < drawState.Draft.MinStrokePixels ){
+            return;
+        }
     }
 
+    if ( strokeColor != nullptr ){
+        double r, g, b, a;
+        std::tie(r, g, b, a) = strokeColor->GetRGBA();
+        UpdateStrokePattern(r, g, b, a);
+        if ( fillRectsFast(pathObject, m_strokePattern, true) ){
+            return;
+        }
+
+        cairo_new_path(cr);
+        DoCairoPath(cr, pathObject->GetPath());
+        m_stateTracker.SetLineWidth(pathObject->LineWidth);
+        m_stateTracker.SetSource(m_strokePattern);
+        cairo_stroke(cr);
+    } else {
+        ColorPtr fillColor = pathObject->GetFillColor();
+        if ( fillColor != nullptr ){
+            double r, g, b, a;
+            std::tie(r, g, b, a) = fillColor->GetRGBA();
+            UpdateFillPattern(r, g, b, a);
+        }
+        if ( fillRectsFast(pathObject, m_fillPattern, false) ){
+            return;
+        }
+
+        cairo_new_path(cr);
+        DoCairoPath(cr, pathObject->GetPath());
+        m_stateTracker.SetSource(m_fillPattern);
+        if ( pathObject->Rule == ofd::PathRule::EvenOdd ){
+            m_stateTracker.SetFillRule(CAIRO_FILL_RULE_EVEN_ODD);
+        } else {
+            m_stateTracker.SetFillRule(CAIRO_FILL_RULE_WINDING);
+        }
+        cairo_fill(cr);
+    }
+}
+
+// ======== CairoRender::ImplCls::captureFastRectClip() ========
+// drawLayer()开始时调用。目标为无设备偏移的ARGB32图像表面、
+// 且裁剪区域为单个像素对齐的矩形时，记录目标表面和裁剪矩形。
+void CairoRender::ImplCls::captureFastRectClip(){
+    m_fastRectTarget = nullptr;
+    if ( !m_cairoRender->GetDrawState().FastRectFill ) return;
+
+    cairo_surface_t *target = cairo_get_group_target(m_cr);
+    if ( cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE ||
+            cairo_image_surface_get_format(target) != CAIRO_FORMAT_ARGB32 ){
+        return;
+    }
+    double offsetX, offsetY;
+    cairo_surface_get_device_offset(target, &offsetX, &offsetY);
+    if ( offsetX != 0.0 || offsetY != 0.0 ) return;
+
+    // 未设置裁剪时cairo不返回矩形列表，以裁剪范围再裁剪一次，
+    // 使其成为等价的矩形裁剪；原有裁剪不是矩形时结果仍不是矩形。
+    cairo_matrix_t matrix;
+    cairo_get_matrix(m_cr, &matrix);
+    cairo_identity_matrix(m_cr);
+
+    double x0, y0, x1, y1;
+    cairo_clip_extents(m_cr, &x0, &y0, &x1, &y1);
+    cairo_rectangle_list_t *rectList = cairo_copy_clip_rectangle_list(m_cr);
+    if ( rectList->status == CAIRO_STATUS_CLIP_NOT_REPRESENTABLE ){
+        cairo_rectangle_list_destroy(rectList);
+        cairo_new_path(m_cr);
+        cairo_rectangle(m_cr, x0, y0, x1 - x0, y1 - y0);
+        cairo_clip(m_cr);
+        rectList = cairo_copy_clip_rectangle_list(m_cr);
+    }
+    if ( rectList->status == CAIRO_STATUS_SUCCESS && rectList->num_rectangles == 1 ){
+        const cairo_rectangle_t &rect = rectList->rectangles[0];
+        m_fastRectClip[0] = rect.x;
+        m_fastRectClip[1] = rect.y;
+        m_fastRectClip[2] = rect.x + rect.width;
+        m_fastRectClip[3] = rect.y + rect.height;
+        m_fastRectTarget = target;
+    }
+    cairo_rectangle_list_destroy(rectList);
+
+    cairo_set_matrix(m_cr, &matrix);
+}
+
+// ======== CairoRender::ImplCls::fillRectsFast() ========
+// 纯色路径的各子路径均为轴对齐矩形（填充）或水平、垂直线段（勾边，平头线帽），
+// 且CTM无旋转、切变时，直接写入目标表面像素，返回true。
+// 否则不做任何绘制，返回false，由cairo绘制。
+// 子路径在像素网格上互相重叠时cairo的合并覆盖率与逐个叠加不同，此时也返回false。
+#define FAST_RECT_MAX_SUBPATHS 64
+bool CairoRender::ImplCls::fillRectsFast(PathObject *pathObject, cairo_pattern_t *pattern, bool isStroke){
+    if ( m_fastRectTarget == nullptr ) return false;
+    if ( cairo_get_operator(m_cr) != CAIRO_OPERATOR_OVER ||
+            cairo_get_antialias(m_cr) == CAIRO_ANTIALIAS_NONE ){
+        return false;
+    }
+    double r, g, b, a;
+    if ( pattern == nullptr || cairo_pattern_get_rgba(pattern, &r, &g, &b, &a) != CAIRO_STATUS_SUCCESS ){
+        return false;
+    }
+
+    PathPtr path = pathObject->GetPath();
+    if ( path == nullptr ) return false;
+    size_t numSubpaths = path->GetNumSubpaths();
+    if ( numSubpaths == 0 || numSubpaths > FAST_RECT_MAX_SUBPATHS ) return false;
+
+    cairo_matrix_t matrix;
+    cairo_get_matrix(m_cr, &matrix);
+    if ( matrix.xy != 0.0 || matrix.yx != 0.0 ) return false;
+
+    // -------- 计算设备空间矩形 --------
+    double rects[FAST_RECT_MAX_SUBPATHS][4];
+    for ( size_t i = 0 ; i < numSubpaths ; i++ ){
+        SubpathPtr subpath = path->GetSubpath(i);
+        if ( subpath == nullptr ) return false;
+
+        double x0, y0, x1, y1;
+        if ( isStroke ){
+            Point_t p0, p1;
+            if ( !subpath->GetAxisAlignedLine(p0, p1) ) return false;
+            double halfWidth = pathObject->LineWidth / 2.0;
+            if ( p0.X == p1.X && p0.Y == p1.Y ){
+                return false;
+            } else if ( p0.Y == p1.Y ){
+                x0 = p0.X; x1 = p1.X;
+                y0 = p0.Y - halfWidth; y1 = p0.Y + halfWidth;
+            } else {
+                x0 = p0.X - halfWidth; x1 = p0.X + halfWidth;
+                y0 = p0.Y; y1 = p1.Y;
+            }
+        } else {
+            Boundary boundary;
+            if ( !subpath->GetAxisAlignedRect(boundary) ) return false;
+            x0 = boundary.XMin; y0 = boundary.YMin;
+            x1 = boundary.XMax; y1 = boundary.YMax;
+        }
+        cairo_matrix_transform_point(&matrix, &x0, &y0);
+        cairo_matrix_transform_point(&matrix, &x1, &y1);
+
+        double *rect = rects[i];
+        rect[0] = std::max(std::min(x0, x1), m_fastRectClip[0]);
+        rect[1] = std::max(std::min(y0, y1), m_fastRectClip[1]);
+        rect[2] = std::min(std::max(x0, x1), m_fastRectClip[2]);
+        rect[3] = std::min(std::max(y0, y1), m_fastRectClip[3]);
+
+        for ( size_t j = 0 ; j < i ; j++ ){
+            const double *other = rects[j];
+            if ( floor(rect[0]) < ceil(other[2]) && floor(other[0]) < ceil(rect[2]) &&
+                    floor(rect[1]) < ceil(other[3]) && floor(other[1]) < ceil(rect[3]) ){
+                return false;
+            }
+        }
+    }
+
+    // -------- 写入像素 --------
+    cairo_surface_flush(m_fastRectTarget);
+    uint8_t *data = cairo_image_surface_get_data(m_fastRectTarget);
+    int stride = cairo_image_surface_get_stride(m_fastRectTarget);
+    int width = cairo_image_surface_get_width(m_fastRectTarget);
+    int height = cairo_image_surface_get_height(m_fastRectTarget);
+    uint32_t color = PremultiplyARGB32(r, g, b, a);
+    for ( size_t i = 0 ; i < numSubpaths ; i++ ){
+        const double *rect = rects[i];
+        if ( rect[0] >= rect[2] || rect[1] >= rect[3] ) continue;
+        FillRectARGB32(data, stride, width, height, rect[0], rect[1], rect[2], rect[3], color);
+        int ix = (int)floor(rect[0]);
+        int iy = (int)floor(rect[1]);
+        cairo_surface_mark_dirty_rectangle(m_fastRectTarget, ix, iy,
+                (int)ceil(rect[2]) - ix, (int)ceil(rect[3]) - iy);
+    }
+
+    return true;
 }
 
 void CairoRender::ImplCls::DrawObject(ObjectPtr object){
@@ -457,6 +1212,22 @@ void CairoRender::ImplCls::DrawTextObject(cairo_t *cr, TextObject *textObject){
     // FIXME
     //cairo_select_font_face(cr, "Simsun", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
 
+    if ( textObject->GetNumTextCodes() == 0 ) return;
+
+    // Draft质量下，设备空间中过小的文字以横条代替或直接跳过。
+    if ( isDraft() ){
+        const DrawState::DraftParams &draft = m_cairoRender->GetDrawState().Draft;
+        double dx = 0.0;
+        double dy = textObject->GetFontSize();
+        cairo_user_to_device_distance(cr, &dx, &dy);
+        if ( sqrt(dx * dx + dy * dy) < draft.MinTextPixels ){
+            if ( draft.GreekText ){
+                DrawGreekText(cr, textObject);
+            }
+            return;
+        }
+    }
+
     FontPtr font = textObject->GetFont();
 
     // FIXME
@@ -535,26 +1306,44 @@ void CairoRender::ImplCls::DrawTextObject(cairo_t *cr, TextObject *textObject){
     cairo_matrix_t font_ctm = {1.0, 0.0, 0.0, 1.0, 0.0, 0.0}; 
     cairo_font_options_t *font_options = cairo_font_options_create();
     cairo_get_font_options(cr, font_options);
-    cairo_font_options_set_antialias(font_options, CAIRO_ANTIALIAS_DEFAULT);
+    if ( isDraft() ){
+        cairo_font_options_set_antialias(font_options, CAIRO_ANTIALIAS_FAST);
+        cairo_font_options_set_hint_metrics(font_options, CAIRO_HINT_METRICS_OFF);
+    } else {
+        cairo_font_options_set_antialias(font_options, CAIRO_ANTIALIAS_DEFAULT);
+    }
 
 
     ColorPtr fillColor = textObject->GetFillColor();
     if ( fillColor != nullptr ){
-        const ColorRGB &rgb = fillColor->Value.RGB;
-        double r = (double)rgb.Red / 255.0;
-        double g = (double)rgb.Green / 255.0;
-        double b = (double)rgb.Blue / 255.0;
+        double r, g, b;
+        std::tie(r, g, b, std::ignore) = fillColor->GetRGBA();
         double alpha = (double)textObject->Alpha / 255.0;
         //UpdateFillPattern(r, g, b, alpha);
         //LOG(DEBUG) << "textObject->FillColor=(" << r << "," << g << "," << b << "," << alpha << ")";
-        cairo_set_source_rgba(cr, b, g, r, alpha);
+        toTargetRGB(r, b);
+        cairo_set_source_rgba(cr, r, g, b, alpha);
+    }
+
+    // 小字号文字复用已光栅化的字形位图。矢量输出保留文字，不使用字形位图。
+    const DrawState &drawState = m_cairoRender->GetDrawState();
+    bool drawn = false;
+    if ( drawState.UseGlyphAtlas && !isVectorTarget() ){
+        double dx = 0.0;
+        double dy = fontPixels;
+        cairo_user_to_device_distance(cr, &dx, &dy);
+        if ( sqrt(dx * dx + dy * dy) <= drawState.GlyphAtlasMaxPixels ){
+            drawn = GlyphAtlas::GlobalInstance().ShowText(cr, font_face, font_matrix, font_options, X1, Y1, text);
+        }
     }
 
     //cairo_set_source (cr, m_fillPattern);
-    DrawFreeTypeString(X1, Y1, text, cr, font_face,
-            //DrawFreeTypeString(X1, Y1, text, cr, 
-            &font_matrix, &font_ctm, font_options, m_strokePattern);
-            cairo_font_options_destroy(font_options);
+    if ( !drawn ){
+        DrawFreeTypeString(X1, Y1, text, cr, font_face,
+                //DrawFreeTypeString(X1, Y1, text, cr, 
+                &font_matrix, &font_ctm, font_options, m_strokePattern);
+    }
+    cairo_font_options_destroy(font_options);
 
             //cairo_text_extents_t te;
             //cairo_text_extents(cr, text.c_str(), &te);
@@ -566,6 +1355,35 @@ void CairoRender::ImplCls::DrawTextObject(cairo_t *cr, TextObject *textObject){
     return;
 }
 
+// ======== CairoRender::ImplCls::DrawGreekText() ========
+// 以半透明横条近似文字所占区域，不做字形光栅化。
+// 宽度按ASCII字符半个字号、其余字符一个字号估算。
+void CairoRender::ImplCls::DrawGreekText(cairo_t *cr, TextObject *textObject){
+    double fontSize = textObject->GetFontSize();
+    const Text::TextCode &textCode = textObject->GetTextCode(0);
+
+    double width = 0.0;
+    for ( unsigned char c : textCode.Text ){
+        if ( c < 0x80 ){
+            width += fontSize * 0.5;
+        } else if ( (c & 0xC0) == 0xC0 ){
+            width += fontSize;
+        }
+    }
+    if ( width <= 0.0 ) return;
+
+    double r = 0.0, g = 0.0, b = 0.0;
+    ColorPtr fillColor = textObject->GetFillColor();
+    if ( fillColor != nullptr ){
+        std::tie(r, g, b, std::ignore) = fillColor->GetRGBA();
+    }
+    double alpha = (double)textObject->Alpha / 255.0;
+    toTargetRGB(r, b);
+    cairo_set_source_rgba(cr, r, g, b, alpha * 0.4);
+    cairo_rectangle(cr, textCode.X, textCode.Y - fontSize * 0.7, width, fontSize * 0.6);
+    cairo_fill(cr);
+}
+
 void DoCairoPath(cairo_t *cr, PathPtr path){
     if ( path == nullptr ) return;
 
@@ -708,95 +1526,88 @@ void CairoRender::ImplCls::DrawPathObject(cairo_t *cr, PathObject *pathObject){
 
 }
 
-//// Defined in CairoRender_Poppler.cc
-//cairo_surface_t *createImageSurface(Stream *str, int widthA, int heightA, int scaledWidth, int scaledHeight, int nComps, int nBits);
-
-namespace ofd{
-class MemStream : public Stream{
-    public:
-        MemStream(char *data, size_t startA, size_t dataSize): 
-            buf(data), length(dataSize), start(startA), bufPtr(data), bufEnd(data+startA+dataSize),
-            needFree(false){
-        }
-        virtual ~MemStream(){
-            if (needFree){
-                delete[] buf;
-            }
-        }
-
-        virtual StreamKind getKind(){return strWeird;} ;
-        virtual void reset(){
-            bufPtr = buf + start;
-        }
-        virtual void close(){
-        }
-        // Get next char from stream.
-        virtual int getChar(){
-            return (bufPtr < bufEnd) ? (*bufPtr++ & 0xff) : EOF; 
-        }
-
-        // Peek at next char in stream.
-        virtual int lookChar(){
-            return (bufPtr < bufEnd) ? (*bufPtr & 0xff) : EOF; 
-        }
-
-        virtual Goffset getPos() { return (int)(bufPtr - buf); }
-        virtual void setPos(Goffset pos, int dir = 0){
-            Guint i;
-
-            if (dir >= 0) {
-                i = pos;
-            } else {
-                i = start + length - pos;
-            }
-            if (i < start) {
-                i = start;
-            } else if (i > start + length) {
-                i = start + length;
-            }
-            bufPtr = buf + i;
-        }
-        virtual Goffset getStart() { return start; }
-        //virtual void moveStart(Goffset delta);
+// 解码图像数据，供ImageCache在未命中时调用。
+static cairo_surface_t *decodeImageSurface(ImagePtr image, int scaledWidth, int scaledHeight){
+    const char *imageData = image->GetImageData();
+    size_t imageDataSize = image->GetImageDataSize();
+    if ( imageData == nullptr || imageDataSize == 0 ) return nullptr;
 
-        //if needFree = true, the stream will delete buf when it is destroyed
-        //otherwise it will not touch it. Default value is false
-        virtual void setNeedFree (GBool val) { needFree = val; }
+    return DecodeImage(imageData, imageDataSize, scaledWidth, scaledHeight);
+}
 
-        virtual int getUnfilteredChar () { return getChar(); }
-        virtual void unfilteredReset () { reset (); } 
+// ======== CairoRender::ImplCls::createVectorImageSurface() ========
+// 解码得到的表面按光栅渲染的字节序存放（R在最低字节），且可能被图像缓存与光栅渲染共享。
+// 矢量输出需要cairo约定的ARGB32顺序，复制一份并互换R、B。
+cairo_surface_t *CairoRender::ImplCls::createVectorImageSurface(cairo_surface_t *imageSurface){
+    cairo_format_t format = cairo_image_surface_get_format(imageSurface);
+    if ( format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24 ){
+        return cairo_surface_reference(imageSurface);
+    }
 
-        virtual GBool hasGetChars() { return true; }
-        virtual int getChars(int nChars, Guchar *buffer) {
-            int n;
+    int width = cairo_image_surface_get_width(imageSurface);
+    int height = cairo_image_surface_get_height(imageSurface);
+    cairo_surface_t *vectorSurface = cairo_image_surface_create(format, width, height);
+    if ( cairo_surface_status(vectorSurface) != CAIRO_STATUS_SUCCESS ){
+        cairo_surface_destroy(vectorSurface);
+        return cairo_surface_reference(imageSurface);
+    }
 
-            if (nChars <= 0) {
-                return 0;
-            }
-            if (bufEnd - bufPtr < nChars) {
-                n = (int)(bufEnd - bufPtr);
-            } else {
-                n = nChars;
-            }
-            memcpy(buffer, bufPtr, n);
-            bufPtr += n;
-            return n;
+    cairo_surface_flush(imageSurface);
+    const uint8_t *srcData = cairo_image_surface_get_data(imageSurface);
+    int srcStride = cairo_image_surface_get_stride(imageSurface);
+    uint8_t *dstData = cairo_image_surface_get_data(vectorSurface);
+    int dstStride = cairo_image_surface_get_stride(vectorSurface);
+    for ( int y = 0 ; y < height ; y++ ){
+        const uint32_t *src = (const uint32_t*)(srcData + y * srcStride);
+        uint32_t *dst = (uint32_t*)(dstData + y * dstStride);
+        for ( int x = 0 ; x < width ; x++ ){
+            uint32_t r, g, b;
+            unpackSurfacePixel(src[x], r, g, b);
+            dst[x] = (src[x] & 0xff000000) | (r << 16) | (g << 8) | b;
         }
+    }
+    cairo_surface_mark_dirty(vectorSurface);
+    return vectorSurface;
+}
 
-
-        virtual GBool isBinary(GBool last = gTrue) { return last; }
-        virtual BaseStream *getBaseStream() { return nullptr; }
-        virtual Stream *getUndecodedStream() { return this; }
-        virtual Dict *getDict() { return nullptr; }
-    private:
-        char *buf;
-        size_t length;
-        size_t start;
-        char *bufPtr;
-        char *bufEnd;
-        bool needFree;
-
-}; // class MemStream
+// ======== CairoRender::ImplCls::setImageMimeData() ========
+// 矢量输出时为图像表面附加唯一标识，同一图像在输出文件中只嵌入一次；
+// 包内图像文件为JPEG时附加原始数据，PDF/PS输出直接引用而不重新编码。
+void CairoRender::ImplCls::setImageMimeData(cairo_surface_t *imageSurface, ImageObject *imageObject){
+    const unsigned char *mimeData = nullptr;
+    unsigned long mimeDataLength = 0;
+    cairo_surface_get_mime_data(imageSurface, CAIRO_MIME_TYPE_UNIQUE_ID, &mimeData, &mimeDataLength);
+    if ( mimeData != nullptr ) return;
+
+    ImagePtr image = imageObject->GetImage();
+    DocumentPtr document = imageObject->GetDocument();
+    if ( document == nullptr ) return;
+
+    std::string uniqueID = "ofd-" + document->GetDocBody().DocInfo.DocID + "-image-" + std::to_string(image->ID);
+    unsigned char *uniqueIDData = new unsigned char[uniqueID.length()];
+    memcpy(uniqueIDData, uniqueID.c_str(), uniqueID.length());
+    cairo_surface_set_mime_data(imageSurface, CAIRO_MIME_TYPE_UNIQUE_ID, uniqueIDData, uniqueID.length(),
+            [](void *data){delete[] (unsigned char*)data;}, uniqueIDData);
+
+    // 缩小后的表面与原始数据不一致，不能直接引用。
+    if ( cairo_image_surface_get_width(imageSurface) != image->width ||
+            cairo_image_surface_get_height(imageSurface) != image->height ){
+        return;
+    }
+    PackagePtr package = document->GetPackage();
+    if ( package == nullptr || image->GetImageFilePath().empty() ) return;
+
+    char *fileData = nullptr;
+    size_t fileDataSize = 0;
+    bool ok = false;
+    std::tie(fileData, fileDataSize, ok) = package->ReadZipFileRaw(image->GetImageFilePath());
+    if ( !ok ) return;
+    if ( fileDataSize > 2 && (uint8_t)fileData[0] == 0xFF && (uint8_t)fileData[1] == 0xD8 ){
+        cairo_surface_set_mime_data(imageSurface, CAIRO_MIME_TYPE_JPEG, (unsigned char*)fileData, fileDataSize,
+                [](void *data){delete[] (char*)data;}, fileData);
+    } else {
+        delete[] fileData;
+    }
 }
 
 void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject){
@@ -807,15 +1618,6 @@ void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject
     if ( image == nullptr ) return;
     int widthA = image->width;
     int heightA = image->height;
-    int nComps = image->nComps;
-    int nBits = image->nBits;
-
-    char *imageData = image->GetImageData();
-    size_t imageDataSize = image->GetImageDataSize();
-
-    //MemStream *memStream = new MemStream(imageData, 0, imageDataSize, nullptr);
-    ofd::MemStream *memStream = new ofd::MemStream(imageData, 0, imageDataSize);
-    //memStream->reset();
 
     cairo_surface_t *imageSurface = nullptr;
     cairo_matrix_t matrix;
@@ -837,30 +1639,61 @@ void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject
     cairo_get_matrix(cr, &matrix);
     getImageScaledSize (&matrix, widthA, heightA, &scaledWidth, &scaledHeight);
 
-    imageSurface = createImageSurface(memStream, widthA, heightA, scaledWidth, scaledHeight, nComps, nBits);
+    // 矢量输出保留原始分辨率，由阅读器按输出设备缩放。
+    if ( isVectorTarget() ){
+        scaledWidth = widthA;
+        scaledHeight = heightA;
+    } else if ( isDraft() ){
+        // Draft质量下取更低分辨率的级别。
+        double imageScale = m_cairoRender->GetDrawState().Draft.ImageScale;
+        scaledWidth = std::max(1, (int)(scaledWidth * imageScale));
+        scaledHeight = std::max(1, (int)(scaledHeight * imageScale));
+    }
+
+    // 优先从文档级缓存中取已解码的图像，避免翻页时重复解码。
+    DocumentPtr document = imageObject->GetDocument();
+    if ( document != nullptr && document->GetImageCache() != nullptr ){
+        imageSurface = document->GetImageCache()->GetSurface(image, scaledWidth, scaledHeight, decodeImageSurface);
+    } else {
+        imageSurface = decodeImageSurface(image, scaledWidth, scaledHeight);
+    }
     if ( imageSurface == nullptr ){
-        delete memStream;
         cairo_restore(cr);
         return;
     }
-    std::string pngFileName = "/tmp/Image_draw_" + std::to_string(image->ID) + ".png";
-    cairo_surface_write_to_png(imageSurface, pngFileName.c_str());
+
+    const DrawState &drawState = m_cairoRender->GetDrawState();
+    if ( drawState.Debug.DumpImages ){
+        std::string pngFileName = "/tmp/Image_draw_" + std::to_string(image->ID) + ".png";
+        cairo_surface_write_to_png(imageSurface, pngFileName.c_str());
+    }
 
     int width = cairo_image_surface_get_width (imageSurface);
     int height = cairo_image_surface_get_height (imageSurface);
+    bool bilevel = cairo_image_surface_get_format(imageSurface) == CAIRO_FORMAT_A1;
     cairo_filter_t filter = CAIRO_FILTER_BILINEAR;
-    if (width == widthA && height == heightA){
+    if ( isDraft() ){
+        filter = CAIRO_FILTER_FAST;
+    } else if (width == widthA && height == heightA){
         bool interpolate = false;
         filter = getFilterForSurface (imageSurface, cr, interpolate);
     }
 
     //if (!inlineImg) [> don't read stream twice if it is an inline image <]
         //setMimeData(state, str, ref, colorMap, imageSurface);
+    if ( isVectorTarget() ){
+        cairo_surface_t *vectorSurface = createVectorImageSurface(imageSurface);
+        cairo_surface_destroy(imageSurface);
+        imageSurface = vectorSurface;
+        setImageMimeData(imageSurface, imageObject);
+    }
 
     cairo_pattern_t *pattern = cairo_pattern_create_for_surface(imageSurface);
     cairo_surface_destroy (imageSurface);
-    if (cairo_pattern_status (pattern))
+    if (cairo_pattern_status (pattern)){
+        cairo_restore(cr);
         return;
+    }
 
     cairo_pattern_set_filter (pattern, filter);
 
@@ -872,6 +1705,7 @@ void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject
     cairo_pattern_set_matrix (pattern, &matrix);
     if (cairo_pattern_status (pattern)) {
         cairo_pattern_destroy (pattern);
+        cairo_restore(cr);
         return;
     }
 
@@ -883,6 +1717,19 @@ void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject
     //}
 
 
+    // 黑白图像：先以白色填充图像区域，再以A1表面为蒙版绘制黑色，不展开为ARGB32。
+    if ( bilevel ){
+        cairo_rectangle(cr, 0., 0., 1., 1.);
+        cairo_clip(cr);
+        cairo_set_source_rgb(cr, 1., 1., 1.);
+        cairo_paint(cr);
+        cairo_set_source_rgb(cr, 0., 0., 0.);
+        cairo_mask(cr, pattern);
+        cairo_restore(cr);
+        cairo_pattern_destroy(pattern);
+        return;
+    }
+
     cairo_set_source(cr, pattern);
     //if (!m_printing)
     cairo_rectangle(cr, 0., 0., 1., 1.);
@@ -916,8 +1763,6 @@ void CairoRender::ImplCls::DrawImageObject(cairo_t *cr, ImageObject *imageObject
     //}
 
     cairo_pattern_destroy (pattern);
-
-    delete memStream;
 }
 
 void CairoRender::ImplCls::DrawVideoObject(cairo_t *cr, VideoObject *videoObject){
@@ -933,21 +1778,56 @@ void CairoRender::ImplCls::SetLineWidth(double lineWidth){
     m_lineWidth = lineWidth;
 }
 
+// 纯色pattern缓存上限，超出后整体清空。
+#define SOLID_PATTERN_CACHE_SIZE 1024
+
+// ======== CairoRender::ImplCls::getSolidPattern() ========
+// 返回按8位RGBA量化后缓存的纯色pattern，引用归缓存所有。
+cairo_pattern_t *CairoRender::ImplCls::getSolidPattern(double r, double g, double b, double a){
+    uint32_t R = (uint32_t)(std::min(std::max(r, 0.0), 1.0) * 255.0 + 0.5);
+    uint32_t G = (uint32_t)(std::min(std::max(g, 0.0), 1.0) * 255.0 + 0.5);
+    uint32_t B = (uint32_t)(std::min(std::max(b, 0.0), 1.0) * 255.0 + 0.5);
+    uint32_t A = (uint32_t)(std::min(std::max(a, 0.0), 1.0) * 255.0 + 0.5);
+    uint32_t key = (A << 24) | (R << 16) | (G << 8) | B;
+
+    auto it = m_solidPatterns.find(key);
+    if ( it != m_solidPatterns.end() ){
+        return it->second;
+    }
+
+    if ( m_solidPatterns.size() >= SOLID_PATTERN_CACHE_SIZE ){
+        clearSolidPatterns();
+    }
+    cairo_pattern_t *pattern = cairo_pattern_create_rgba(R / 255.0, G / 255.0, B / 255.0, A / 255.0);
+    m_solidPatterns[key] = pattern;
+    return pattern;
+}
+
+void CairoRender::ImplCls::clearSolidPatterns(){
+    // cairo_t和m_fillPattern/m_strokePattern各自持有引用，这里只释放缓存的引用。
+    for ( auto &kv : m_solidPatterns ){
+        cairo_pattern_destroy(kv.second);
+    }
+    m_solidPatterns.clear();
+}
+
 void CairoRender::ImplCls::UpdateStrokePattern(double r, double g, double b, double a){
+    toTargetRGB(r, b);
+    cairo_pattern_t *pattern = cairo_pattern_reference(getSolidPattern(r, g, b, a));
     if ( m_strokePattern != nullptr ){
         cairo_pattern_destroy(m_strokePattern);
-        m_strokePattern = nullptr;
     }
     //LOG(DEBUG) << "UpdateStrokePattern() rgba = (" << r << "," << g << "," << b << "," << a << ")";
-    m_strokePattern = cairo_pattern_create_rgba(b, g, r, a);
+    m_strokePattern = pattern;
 }
 
 void CairoRender::ImplCls::UpdateFillPattern(double r, double g, double b, double a){
+    toTargetRGB(r, b);
+    cairo_pattern_t *pattern = cairo_pattern_reference(getSolidPattern(r, g, b, a));
     if ( m_fillPattern != nullptr ){
         cairo_pattern_destroy(m_fillPattern);
-        m_fillPattern = nullptr;
     }
-    m_fillPattern = cairo_pattern_create_rgba(b, g, r, a);
+    m_fillPattern = pattern;
 }
 
 void CairoRender::ImplCls::UpdateFillPattern(ShadingPtr fillShading){
@@ -955,7 +1835,7 @@ void CairoRender::ImplCls::UpdateFillPattern(ShadingPtr fillShading){
         cairo_pattern_destroy(m_fillPattern);
         m_fillPattern = nullptr;
     }
-    m_fillPattern = fillShading->CreateFillPattern(m_cr);
+    m_fillPattern = fillShading->GetFillPattern(m_cr);
 }
 
 void CairoRender::ImplCls::Transform(cairo_matrix_t *matrix){
@@ -995,9 +1875,9 @@ void CairoRender::ImplCls::EoClip(PathPtr clipPath){
 //}
 
 // ======== CairoRender::CairoRender() ========
-//CairoRender::CairoRender(cairo_surface_t *surface){
-    //m_impl = std::unique_ptr<CairoRender::ImplCls>(new CairoRender::ImplCls(this, surface));
-//}
+CairoRender::CairoRender(cairo_surface_t *surface, double resolutionX, double resolutionY){
+    m_impl = std::unique_ptr<CairoRender::ImplCls>(new CairoRender::ImplCls(this, surface, resolutionX, resolutionY));
+}
 
 CairoRender::CairoRender(double pixelWidth, double pixelHeight, double resolutionX, double resolutionY){
     m_impl = std::unique_ptr<CairoRender::ImplCls>(new CairoRender::ImplCls(this, pixelWidth, pixelHeight, resolutionX, resolutionY));
@@ -1015,6 +1895,10 @@ bool CairoRender::WriteToPNG(const std::string &filename){
     return m_impl->WriteToPNG(filename);
 }
 
+bool CairoRender::WriteImage(const std::string &filename, const EncodeParams &params){
+    return m_impl->WriteImage(filename, params);
+}
+
 //void CairoRender::SetCairoSurface(cairo_surface_t *surface){
     //m_impl->SetCairoSurface(surface);
 //}
@@ -1030,7 +1914,12 @@ cairo_t *CairoRender::GetCairoContext() const{
 // ======== CairoRender::DrawPage() ========
 void CairoRender::DrawPage(PagePtr page, VisibleParams visibleParams){
     Render::DrawPage(page, visibleParams);
-    m_impl->DrawPage(page, visibleParams);
+    m_impl->DrawPage(page, visibleParams, DrawControl());
+}
+
+bool CairoRender::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    Render::DrawPage(page, visibleParams, drawControl);
+    return m_impl->DrawPage(page, visibleParams, drawControl);
 }
 
 void CairoRender::DrawObject(ObjectPtr object){
@@ -1095,6 +1984,10 @@ void CairoRender::Rebuild(double pixelWidth, double pixelHeight, double resoluti
     m_impl->Rebuild(pixelWidth, pixelHeight, resolutionX, resolutionY);
 }
 
+void CairoRender::Reset(){
+    m_impl->Reset();
+}
+
 // Max number of splits along the t axis for an axial shading fill.
 #define axialMaxSplits 256
 
@@ -1150,6 +2043,17 @@ void CairoRender::ImplCls::doDrawPathObject(cairo_t *cr, PathObject *pathObject)
 
     showCairoMatrix(cr, "CairoRender", "DrawPathObject");
 
+    ColorPtr strokeColor = pathObject->GetStrokeColor();
+
+    // Draft质量下不绘制设备空间中过细的线。
+    if ( strokeColor != nullptr && isDraft() ){
+        double dx = pathObject->LineWidth;
+        double dy = 0.0;
+        cairo_user_to_device_distance(cr, &dx, &dy);
+        if ( sqrt(dx * dx + dy * dy) < m_cairoRender->GetDrawState().Draft.MinStrokePixels ){
+            return;
+        }
+    }
 
     PathPtr path = pathObject->GetPath();
     DoCairoPath(cr, path);
@@ -1157,7 +2061,6 @@ void CairoRender::ImplCls::doDrawPathObject(cairo_t *cr, PathObject *pathObject)
 
     cairo_set_line_width(cr, pathObject->LineWidth);
 
-    ColorPtr strokeColor = pathObject->GetStrokeColor();
     if ( strokeColor != nullptr ){
         double r, g, b, a;
         std::tie(r, g, b, a) = strokeColor->GetRGBA();
@@ -1168,8 +2071,9 @@ void CairoRender::ImplCls::doDrawPathObject(cairo_t *cr, PathObject *pathObject)
         cairo_stroke(cr);
     } else {
         if ( pathObject->FillShading != nullptr ){
-            //UpdateFillPattern(pathObject->FillShading);
-            return;
+            // 渐变pattern缓存在Shading中，重复绘制不再重建。
+            UpdateFillPattern(pathObject->FillShading);
+            if ( m_fillPattern == nullptr ) return;
         } else {
             ColorPtr fillColor = pathObject->GetFillColor();
             if ( fillColor != nullptr ){
@@ -1191,6 +2095,9 @@ void CairoRender::ImplCls::doDrawPathObject(cairo_t *cr, PathObject *pathObject)
 
     cairo_fill(cr);
 
+    // 草稿模式不做裁剪。
+    if ( isDraft() ) return;
+
     if ( pathObject->Rule == ofd::PathRule::EvenOdd ){
         EoClip(path);
     } else {
@@ -1,5 +1,6 @@
 
 #include <stdint.h>
+#include "ofd/ColorConvert.h"
 #include "CairoRescaleBox.h"
 #include <GfxState.h>
 #include <OutputDev.h>
@@ -168,6 +169,8 @@ public:
         // FIXME
         if ( colorMap != nullptr ){
             colorMap->getRGBLine (pix, row_data, width);
+        } else if ( nComps == 1 && nBits == 8 ){
+            ofd::ConvertGrayToARGB32(pix, row_data, width);
         } else {
             memcpy(row_data, pix, width * 4);
         }
@@ -0,0 +1,178 @@
+#include <assert.h>
+#include <math.h>
+#include <cairo.h>
+#include <cairo-pdf.h>
+#include <cairo-svg.h>
+#include <cairo-ps.h>
+#include "ofd/CairoVectorRender.h"
+#include "ofd/CairoRender.h"
+#include "ofd/Page.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// **************** class CairoVectorRender::ImplCls ****************
+
+class CairoVectorRender::ImplCls {
+public:
+    ImplCls(CairoVectorRender *vectorRender, RenderType renderType, const std::string &filename);
+    ~ImplCls();
+
+    bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl);
+    bool Finish();
+
+private:
+    bool beginPage(double pageWidth, double pageHeight);
+    void endPage();
+    std::string getPageFileName(size_t pageIndex) const;
+
+public:
+    CairoVectorRender *m_vectorRender;
+    RenderType m_renderType;
+    std::string m_filename;
+    size_t m_numPages;
+
+private:
+    cairo_surface_t *m_surface;
+    std::unique_ptr<CairoRender> m_cairoRender;
+
+}; // class CairoVectorRender::ImplCls
+
+CairoVectorRender::ImplCls::ImplCls(CairoVectorRender *vectorRender, RenderType renderType, const std::string &filename) :
+    m_vectorRender(vectorRender), m_renderType(renderType), m_filename(filename),
+    m_numPages(0), m_surface(nullptr){
+}
+
+CairoVectorRender::ImplCls::~ImplCls(){
+    Finish();
+}
+
+std::string CairoVectorRender::ImplCls::getPageFileName(size_t pageIndex) const{
+    if ( pageIndex == 0 ) return m_filename;
+    std::string suffix = "_" + std::to_string(pageIndex);
+    size_t pos = m_filename.rfind('.');
+    if ( pos == std::string::npos || m_filename.find('/', pos) != std::string::npos ){
+        return m_filename + suffix;
+    }
+    return m_filename.substr(0, pos) + suffix + m_filename.substr(pos);
+}
+
+// ======== CairoVectorRender::ImplCls::beginPage() ========
+// PDF、PS在首页创建表面，之后每页只修改页面大小；SVG每页新建表面。
+bool CairoVectorRender::ImplCls::beginPage(double pageWidth, double pageHeight){
+    if ( m_surface == nullptr ){
+        if ( m_renderType == RenderType::PDF ){
+            m_surface = cairo_pdf_surface_create(m_filename.c_str(), pageWidth, pageHeight);
+        } else if ( m_renderType == RenderType::PS ){
+            m_surface = cairo_ps_surface_create(m_filename.c_str(), pageWidth, pageHeight);
+        } else if ( m_renderType == RenderType::SVG ){
+            m_surface = cairo_svg_surface_create(getPageFileName(m_numPages).c_str(), pageWidth, pageHeight);
+        } else {
+            LOG(ERROR) << "Unsupported vector render type " << (int)m_renderType;
+            return false;
+        }
+        if ( cairo_surface_status(m_surface) != CAIRO_STATUS_SUCCESS ){
+            LOG(ERROR) << "Create vector surface failed. filename: " << m_filename
+                << " Cairo status: " << cairo_status_to_string(cairo_surface_status(m_surface));
+            cairo_surface_destroy(m_surface);
+            m_surface = nullptr;
+            return false;
+        }
+        m_cairoRender = std::unique_ptr<CairoRender>(new CairoRender(m_surface, 72.0, 72.0));
+    } else {
+        if ( m_renderType == RenderType::PDF ){
+            cairo_pdf_surface_set_size(m_surface, pageWidth, pageHeight);
+        } else if ( m_renderType == RenderType::PS ){
+            cairo_ps_surface_set_size(m_surface, pageWidth, pageHeight);
+        }
+    }
+    return true;
+}
+
+void CairoVectorRender::ImplCls::endPage(){
+    cairo_show_page(m_cairoRender->GetCairoContext());
+    m_numPages++;
+
+    // SVG一页一个文件。
+    if ( m_renderType == RenderType::SVG ){
+        m_cairoRender = nullptr;
+        cairo_surface_finish(m_surface);
+        cairo_surface_destroy(m_surface);
+        m_surface = nullptr;
+    }
+}
+
+// ======== CairoVectorRender::ImplCls::DrawPage() ========
+bool CairoVectorRender::ImplCls::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    if ( page == nullptr ) return true;
+
+    double scaling;
+    std::tie(std::ignore, std::ignore, scaling) = visibleParams;
+    ST_Box pageBox = page->Area.ApplicationBox;
+    if ( pageBox.Width <= 0.0 || pageBox.Height <= 0.0 ){
+        pageBox = page->Area.PhysicalBox;
+    }
+    double pageWidth = pageBox.Width * scaling;
+    double pageHeight = pageBox.Height * scaling;
+    if ( pageWidth <= 0.0 || pageHeight <= 0.0 ){
+        LOG(WARNING) << "Empty page area. PageID=" << page->ID;
+        return true;
+    }
+
+    if ( !beginPage(pageWidth, pageHeight) ) return false;
+
+    m_cairoRender->SetDrawState(m_vectorRender->GetDrawState());
+    m_cairoRender->SaveState();
+    bool completed = m_cairoRender->DrawPage(page, visibleParams, drawControl);
+    m_cairoRender->RestoreState();
+
+    // 被中断的页面仍然输出，保持页序。
+    endPage();
+
+    return completed;
+}
+
+// ======== CairoVectorRender::ImplCls::Finish() ========
+bool CairoVectorRender::ImplCls::Finish(){
+    if ( m_surface == nullptr ) return true;
+
+    m_cairoRender = nullptr;
+    cairo_surface_finish(m_surface);
+    cairo_status_t status = cairo_surface_status(m_surface);
+    cairo_surface_destroy(m_surface);
+    m_surface = nullptr;
+
+    if ( status != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "Finish vector surface failed. filename: " << m_filename
+            << " Cairo status: " << cairo_status_to_string(status);
+        return false;
+    }
+    return true;
+}
+
+// **************** class CairoVectorRender ****************
+
+CairoVectorRender::CairoVectorRender(RenderType renderType, const std::string &filename) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(this, renderType, filename))){
+}
+
+CairoVectorRender::~CairoVectorRender(){
+}
+
+void CairoVectorRender::DrawPage(PagePtr page, VisibleParams visibleParams){
+    Render::DrawPage(page, visibleParams);
+    m_impl->DrawPage(page, visibleParams, DrawControl());
+}
+
+bool CairoVectorRender::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    Render::DrawPage(page, visibleParams, drawControl);
+    return m_impl->DrawPage(page, visibleParams, drawControl);
+}
+
+bool CairoVectorRender::Finish(){
+    return m_impl->Finish();
+}
+
+size_t CairoVectorRender::GetNumPages() const{
+    return m_impl->m_numPages;
+}
@@ -0,0 +1,110 @@
+#include <assert.h>
+#include <string.h>
+#include <sstream>
+#include "ofd/CodeToGIDMap.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// **************** class CodeToGIDMap ****************
+
+const size_t CodeToGIDMap::MaxSize;
+
+CodeToGIDMap::CodeToGIDMap() :
+    m_size(0){
+}
+
+CodeToGIDMap::~CodeToGIDMap(){
+    for ( auto page : m_pages ){
+        delete[] page;
+    }
+}
+
+void CodeToGIDMap::resize(size_t size){
+    m_size = size;
+    m_pages.resize((size + PageSize - 1) / PageSize, nullptr);
+}
+
+void CodeToGIDMap::set(uint32_t code, uint16_t gid){
+    assert(code < m_size);
+    uint16_t *&page = m_pages[code >> PageBits];
+    if ( page == nullptr ){
+        if ( gid == 0 ) return;
+        page = new uint16_t[PageSize];
+        memset(page, 0, PageSize * sizeof(uint16_t));
+    }
+    page[code & (PageSize - 1)] = gid;
+}
+
+size_t CodeToGIDMap::GetNumPages() const{
+    size_t numPages = 0;
+    for ( auto page : m_pages ){
+        if ( page != nullptr ) numPages++;
+    }
+    return numPages;
+}
+
+// ======== CodeToGIDMap::FromArray() ========
+CodeToGIDMapPtr CodeToGIDMap::FromArray(const int *codeToGID, size_t size){
+    std::shared_ptr<CodeToGIDMap> codeToGIDMap = std::make_shared<CodeToGIDMap>();
+    codeToGIDMap->resize(size);
+    for ( size_t code = 0 ; code < size ; code++ ){
+        int gid = codeToGID[code];
+        if ( gid < 0 || gid > 0xffff ){
+            LOG(WARNING) << "Glyph ID " << gid << " of code " << code << " out of range.";
+            continue;
+        }
+        codeToGIDMap->set(code, (uint16_t)gid);
+    }
+    return codeToGIDMap;
+}
+
+// ======== CodeToGIDMap::ToString() ========
+std::string CodeToGIDMap::ToString() const{
+    std::stringstream ss;
+    uint32_t code = 0;
+    while ( code < m_size ){
+        uint32_t gid = Lookup(code);
+        if ( gid == 0 ){
+            code++;
+            continue;
+        }
+        uint32_t count = 1;
+        while ( code + count < m_size && Lookup(code + count) == gid + count ){
+            count++;
+        }
+        ss << code << " " << gid << " " << count << " ";
+        code += count;
+    }
+    std::string str = ss.str();
+    if ( !str.empty() ) str.pop_back();
+    return str;
+}
+
+// ======== CodeToGIDMap::FromString() ========
+CodeToGIDMapPtr CodeToGIDMap::FromString(const std::string &str, size_t size){
+    if ( size > MaxSize ){
+        LOG(WARNING) << "CodeToGID size " << size << " exceeds " << MaxSize << ". Map ignored.";
+        return nullptr;
+    }
+
+    std::shared_ptr<CodeToGIDMap> codeToGIDMap = std::make_shared<CodeToGIDMap>();
+    codeToGIDMap->resize(size);
+
+    std::istringstream iss(str);
+    uint64_t code = 0, gid = 0, count = 0;
+    while ( iss >> code >> gid >> count ){
+        if ( code + count > size || gid + count > 0x10000 ){
+            LOG(ERROR) << "Invalid CodeToGID range: " << code << " " << gid << " " << count;
+            return nullptr;
+        }
+        for ( uint64_t i = 0 ; i < count ; i++ ){
+            codeToGIDMap->set(code + i, (uint16_t)(gid + i));
+        }
+    }
+    if ( !iss.eof() ){
+        LOG(ERROR) << "Invalid CodeToGID data.";
+        return nullptr;
+    }
+    return codeToGIDMap;
+}
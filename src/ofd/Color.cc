@@ -1,5 +1,6 @@
 #include <assert.h>
 #include "ofd/Color.h"
+#include "ofd/ColorConvert.h"
 #include "utils/xml.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
@@ -95,8 +96,16 @@ bool Color::Equal(ColorPtr color) const {
 
 // ================ Color::GetRGBA() ================
 std::tuple<double, double, double, double> Color::GetRGBA()const{
-    double r, g, b, a;
-    std::tie(r, g, b) = Value.RGB.GetRGB();
+    double r = 0.0, g = 0.0, b = 0.0, a;
+    ColorSpacePtr colorSpace = GetColorSpace();
+    if ( m_bUsePalette ){
+        // 调色板颜色取颜色空间转换器中预先转换的值。
+        if ( !ColorConverter::GetInstance(colorSpace)->GetPaletteRGB(Index, r, g, b) ){
+            LOG(WARNING) << "Color palette index out of range: " << Index;
+        }
+    } else {
+        ColorConverter::ValueToRGB(colorSpace->Type, Value, r, g, b);
+    }
     a = (double)Alpha / 255.0;
     return std::make_tuple(r, g, b, a);
 }
@@ -200,11 +209,20 @@ std::tuple<ColorPtr, bool> Color::ReadColorXML(XMLElementPtr colorElement){
     //LOG(DEBUG) << "ReadColorXML() valueData=" << valueData;
     if ( exist ){
         std::vector<std::string> tokens = utils::SplitString(valueData);
-        if ( tokens.size() == 3 ){
+        if ( tokens.size() == 1 ){
+            uint32_t gray = atoi(tokens[0].c_str());
+            color = Color::Instance(ColorValue(gray), colorSpace, alpha);
+        } else if ( tokens.size() == 3 ){
             uint32_t r = atoi(tokens[0].c_str());
             uint32_t g = atoi(tokens[1].c_str());
             uint32_t b = atoi(tokens[2].c_str());
             color = Color::Instance(r, g, b, colorSpace, alpha);
+        } else if ( tokens.size() == 4 ){
+            uint32_t c = atoi(tokens[0].c_str());
+            uint32_t m = atoi(tokens[1].c_str());
+            uint32_t y = atoi(tokens[2].c_str());
+            uint32_t k = atoi(tokens[3].c_str());
+            color = Color::Instance(c, m, y, k, colorSpace, alpha);
         }
     } else {
         std::tie(index, exist) = colorElement->GetIntAttribute("Index");
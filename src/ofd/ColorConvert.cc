@@ -0,0 +1,305 @@
+#include <assert.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "ofd/ColorConvert.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+#if defined(__SSE2__)
+static std::atomic<bool> s_simdEnabled(true);
+#else
+static std::atomic<bool> s_simdEnabled(false);
+#endif
+
+// x / 255 四舍五入，x <= 255 * 255。
+static inline uint32_t div255(uint32_t x){
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+namespace ofd{
+
+// ======== ConvertGrayToARGB32() ========
+void ConvertGrayToARGB32(const uint8_t *src, uint32_t *dst, size_t n){
+    size_t i = 0;
+#if defined(__SSE2__)
+    if ( s_simdEnabled ){
+        const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+        for ( ; i + 16 <= n ; i += 16 ){
+            __m128i g = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i lo = _mm_unpacklo_epi8(g, g);
+            __m128i hi = _mm_unpackhi_epi8(g, g);
+            _mm_storeu_si128((__m128i*)(dst + i),      _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+            _mm_storeu_si128((__m128i*)(dst + i + 4),  _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+            _mm_storeu_si128((__m128i*)(dst + i + 8),  _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+            _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+        }
+    }
+#endif
+    for ( ; i < n ; i++ ){
+        uint32_t g = src[i];
+        dst[i] = packSurfacePixel(0xff, g, g, g);
+    }
+}
+
+// ======== ConvertRGBToARGB32() ========
+void ConvertRGBToARGB32(const uint8_t *src, uint32_t *dst, size_t n){
+    for ( size_t i = 0 ; i < n ; i++, src += 3 ){
+        dst[i] = packSurfacePixel(0xff, src[0], src[1], src[2]);
+    }
+}
+
+// ======== ConvertRGBAToARGB32() ========
+void ConvertRGBAToARGB32(const uint8_t *src, uint32_t *dst, size_t n, bool premultiply){
+    if ( !premultiply ){
+        for ( size_t i = 0 ; i < n ; i++, src += 4 ){
+            dst[i] = packSurfacePixel(0xff, src[0], src[1], src[2]);
+        }
+        return;
+    }
+    for ( size_t i = 0 ; i < n ; i++, src += 4 ){
+        uint32_t a = src[3];
+        if ( a == 0xff ){
+            dst[i] = packSurfacePixel(0xff, src[0], src[1], src[2]);
+        } else if ( a == 0 ){
+            dst[i] = 0;
+        } else {
+            dst[i] = packSurfacePixel(a, div255(src[0] * a), div255(src[1] * a), div255(src[2] * a));
+        }
+    }
+}
+
+// ======== PremultiplyARGB32() ========
+void PremultiplyARGB32(uint32_t *pixels, size_t n){
+    size_t i = 0;
+#if defined(__SSE2__)
+    if ( s_simdEnabled ){
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(128);
+        // 16位通道排列为(C0, C1, C2, A)，A乘以255保持不变。
+        const __m128i keepColor = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i alpha255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        for ( ; i + 4 <= n ; i += 4 ){
+            __m128i v = _mm_loadu_si128((const __m128i*)(pixels + i));
+            __m128i out[2];
+            for ( int h = 0 ; h < 2 ; h++ ){
+                __m128i x = h == 0 ? _mm_unpacklo_epi8(v, zero) : _mm_unpackhi_epi8(v, zero);
+                __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                a = _mm_or_si128(_mm_and_si128(a, keepColor), alpha255);
+                x = _mm_add_epi16(_mm_mullo_epi16(x, a), round);
+                out[h] = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+            }
+            _mm_storeu_si128((__m128i*)(pixels + i), _mm_packus_epi16(out[0], out[1]));
+        }
+    }
+#endif
+    for ( ; i < n ; i++ ){
+        uint32_t p = pixels[i];
+        uint32_t a = p >> 24;
+        if ( a == 0xff ) continue;
+        pixels[i] = (a << 24) | (div255(((p >> 16) & 0xff) * a) << 16) | (div255(((p >> 8) & 0xff) * a) << 8) | div255((p & 0xff) * a);
+    }
+}
+
+// ======== ConvertCMYKToARGB32() ========
+void ConvertCMYKToARGB32(const uint8_t *src, uint32_t *dst, size_t n){
+    size_t i = 0;
+#if defined(__SSE2__)
+    if ( s_simdEnabled ){
+        const __m128i ones = _mm_set1_epi8((char)0xff);
+        const __m128i round = _mm_set1_epi16(128);
+        // 16位通道排列为(R, G, B, X)，与绘制表面的内存顺序一致，X置为255。
+        const __m128i keepRGB = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        for ( ; i + 4 <= n ; i += 4 ){
+            __m128i cmyk = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            __m128i inv = _mm_xor_si128(cmyk, ones);
+            __m128i out[2];
+            for ( int h = 0 ; h < 2 ; h++ ){
+                // 两个像素：(C', M', Y', K')，C' = 255 - C。
+                __m128i v = h == 0 ? _mm_unpacklo_epi8(inv, _mm_setzero_si128()) : _mm_unpackhi_epi8(inv, _mm_setzero_si128());
+                __m128i k = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                __m128i x = _mm_add_epi16(_mm_mullo_epi16(v, k), round);
+                x = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+                out[h] = _mm_or_si128(_mm_and_si128(x, keepRGB), alpha);
+            }
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(out[0], out[1]));
+        }
+    }
+#endif
+    for ( ; i < n ; i++ ){
+        const uint8_t *p = src + i * 4;
+        dst[i] = packSurfacePixel(0xff, cmykChannelToRGB(p[0], p[3]), cmykChannelToRGB(p[1], p[3]), cmykChannelToRGB(p[2], p[3]));
+    }
+}
+
+// ======== ConvertIndexedToARGB32() ========
+void ConvertIndexedToARGB32(const uint8_t *src, int nBits, const uint32_t *palette, size_t paletteSize,
+        uint32_t *dst, size_t n){
+    if ( paletteSize == 0 ){
+        memset(dst, 0, n * sizeof(uint32_t));
+        return;
+    }
+    if ( nBits == 8 && paletteSize >= 256 ){
+        for ( size_t i = 0 ; i < n ; i++ ){
+            dst[i] = palette[src[i]];
+        }
+        return;
+    }
+    if ( nBits != 1 && nBits != 2 && nBits != 4 && nBits != 8 ){
+        LOG(ERROR) << "Unsupported indexed bits: " << nBits;
+        memset(dst, 0, n * sizeof(uint32_t));
+        return;
+    }
+
+    int perByte = 8 / nBits;
+    uint32_t mask = (1u << nBits) - 1;
+    for ( size_t i = 0 ; i < n ; i++ ){
+        int shift = 8 - nBits * (int)(i % perByte + 1);
+        uint32_t index = (src[i / perByte] >> shift) & mask;
+        dst[i] = index < paletteSize ? palette[index] : palette[0];
+    }
+}
+
+bool IsColorConvertSIMDEnabled(){
+    return s_simdEnabled;
+}
+
+void SetColorConvertSIMD(bool enable){
+#if defined(__SSE2__)
+    s_simdEnabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
+}; // namespace ofd
+
+// **************** class ColorConverter ****************
+
+ColorConverter::ColorConverter(const ColorSpace &colorSpace) :
+    m_type(colorSpace.Type){
+
+    m_palette.reserve(colorSpace.Palette.size());
+    m_paletteRGB.reserve(colorSpace.Palette.size());
+    for ( const auto &color : colorSpace.Palette ){
+        double r = 0.0, g = 0.0, b = 0.0;
+        uint32_t a = 0xff;
+        if ( color != nullptr ){
+            ValueToRGB(m_type, color->Value, r, g, b);
+            a = std::min(color->Alpha, (uint32_t)0xff);
+        }
+        uint32_t R = (uint32_t)(r * 255.0 + 0.5);
+        uint32_t G = (uint32_t)(g * 255.0 + 0.5);
+        uint32_t B = (uint32_t)(b * 255.0 + 0.5);
+        m_paletteRGB.push_back(packSurfacePixel(0, R, G, B));
+        m_palette.push_back(packSurfacePixel(a, div255(R * a), div255(G * a), div255(B * a)));
+    }
+}
+
+typedef struct ConverterEntry{
+    std::weak_ptr<ColorSpace> ColorSpaceRef;
+    ColorConverterPtr Converter;
+} ConverterEntry_t;
+static std::mutex s_convertersMutex;
+static std::map<const ColorSpace*, ConverterEntry> s_converters;
+
+// ======== ColorConverter::GetInstance() ========
+ColorConverterPtr ColorConverter::GetInstance(ColorSpacePtr colorSpace){
+    if ( colorSpace == nullptr ){
+        colorSpace = ColorSpace::DefaultInstance;
+    }
+
+    std::lock_guard<std::mutex> lock(s_convertersMutex);
+    auto it = s_converters.find(colorSpace.get());
+    if ( it != s_converters.end() && it->second.ColorSpaceRef.lock() == colorSpace ){
+        return it->second.Converter;
+    }
+
+    // 清除已释放颜色空间的转换器，地址可能被新的颜色空间复用。
+    for ( auto cur = s_converters.begin() ; cur != s_converters.end() ; ){
+        if ( cur->second.ColorSpaceRef.expired() ){
+            cur = s_converters.erase(cur);
+        } else {
+            cur++;
+        }
+    }
+
+    ConverterEntry entry;
+    entry.ColorSpaceRef = colorSpace;
+    entry.Converter = std::make_shared<ColorConverter>(*colorSpace);
+    s_converters[colorSpace.get()] = entry;
+    return entry.Converter;
+}
+
+void ColorConverter::Invalidate(ColorSpacePtr colorSpace){
+    std::lock_guard<std::mutex> lock(s_convertersMutex);
+    s_converters.erase(colorSpace.get());
+}
+
+int ColorConverter::GetNumComps() const{
+    switch ( m_type ){
+    case ColorSpaceType::GRAY:
+        return 1;
+    case ColorSpaceType::CMYK:
+        return 4;
+    default:
+        return 3;
+    }
+}
+
+void ColorConverter::ConvertRow(const uint8_t *src, uint32_t *dst, size_t n) const{
+    switch ( m_type ){
+    case ColorSpaceType::GRAY:
+        ConvertGrayToARGB32(src, dst, n);
+        break;
+    case ColorSpaceType::CMYK:
+        ConvertCMYKToARGB32(src, dst, n);
+        break;
+    default:
+        ConvertRGBToARGB32(src, dst, n);
+        break;
+    }
+}
+
+void ColorConverter::ConvertIndexedRow(const uint8_t *src, int nBits, uint32_t *dst, size_t n) const{
+    ConvertIndexedToARGB32(src, nBits, m_palette.data(), m_palette.size(), dst, n);
+}
+
+void ColorConverter::ValueToRGB(ColorSpaceType type, const ColorValue &value, double &r, double &g, double &b){
+    switch ( type ){
+    case ColorSpaceType::GRAY:
+        r = g = b = (double)std::min(value.Gray, (uint32_t)255) / 255.0;
+        break;
+    case ColorSpaceType::CMYK:
+        {
+            uint32_t c = std::min(value.CMYK.Cyan, (uint32_t)255);
+            uint32_t m = std::min(value.CMYK.Magenta, (uint32_t)255);
+            uint32_t y = std::min(value.CMYK.Yellow, (uint32_t)255);
+            uint32_t k = std::min(value.CMYK.blacK, (uint32_t)255);
+            r = cmykChannelToRGB(c, k) / 255.0;
+            g = cmykChannelToRGB(m, k) / 255.0;
+            b = cmykChannelToRGB(y, k) / 255.0;
+        } break;
+    default:
+        std::tie(r, g, b) = value.RGB.GetRGB();
+        break;
+    }
+}
+
+bool ColorConverter::GetPaletteRGB(uint32_t index, double &r, double &g, double &b) const{
+    if ( index >= m_paletteRGB.size() ) return false;
+    uint32_t R, G, B;
+    unpackSurfacePixel(m_paletteRGB[index], R, G, B);
+    r = R / 255.0;
+    g = G / 255.0;
+    b = B / 255.0;
+    return true;
+}
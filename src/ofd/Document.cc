@@ -1,8 +1,12 @@
 #include <sstream>
+#include <algorithm>
 #include "ofd/Package.h"
 #include "ofd/Document.h"
 #include "ofd/Page.h"
+#include "ofd/Layer.h"
+#include "ofd/Object.h"
 #include "ofd/Resource.h"
+#include "ofd/ImageCache.h"
 #include "utils/xml.h"
 #include "utils/uuid.h"
 #include "utils/logger.h"
@@ -21,6 +25,7 @@ Document::Document(PackagePtr package, const std::string &docRoot){
     m_package = package;
     m_opened = false;
     m_docBody.DocRoot = docRoot;
+    m_imageCache = std::make_shared<ImageCache>();
 }
 
 Document::~Document(){
@@ -76,6 +81,7 @@ bool Document::Open(){
 
 void Document::Close(){
     if ( !m_opened ) return;
+    m_imageCache->Clear();
 }
 
 size_t Document::GetNumPages() const{
@@ -97,6 +103,146 @@ PagePtr Document::AddNewPage(){
     return page;
 }
 
+// ======== Document::AddNewTemplatePage() ========
+PagePtr Document::AddNewTemplatePage(LayerType zorder){
+    CT_TemplatePage templatePage;
+    templatePage.ID = m_commonData.TemplatePages.size();
+    templatePage.ZOrder = zorder;
+    templatePage.BaseLoc = std::string("Tpls/Tpl_") + std::to_string(templatePage.ID) + "/Content.xml";
+    templatePage.Page = Page::CreateNewPage(GetSelf());
+    templatePage.Page->ID = templatePage.ID;
+    templatePage.Page->BaseLoc = templatePage.BaseLoc;
+    templatePage.Page->Area = m_commonData.PageArea;
+    m_commonData.TemplatePages.push_back(templatePage);
+    return templatePage.Page;
+}
+
+// ======== Document::GetTemplatePage() ========
+PagePtr Document::GetTemplatePage(uint64_t templateID){
+    for ( auto &templatePage : m_commonData.TemplatePages ){
+        if ( templatePage.ID != templateID ) continue;
+        PagePtr page = templatePage.Page;
+        if ( page == nullptr ) return nullptr;
+        // 多个页面可能在不同线程中同时引用同一模板页。
+        std::lock_guard<std::recursive_mutex> lock(m_templateMutex);
+        // 新建的模板页已有内容，无需从包内读取。
+        if ( !page->IsOpened() && page->GetNumLayers() == 0 ){
+            if ( !page->Open() ){
+                LOG(ERROR) << "Open template page failed. TemplateID=" << templateID << " BaseLoc: " << templatePage.BaseLoc;
+            }
+        }
+        return page;
+    }
+    return nullptr;
+}
+
+const Document::CT_TemplatePage *Document::GetTemplatePageInfo(uint64_t templateID) const{
+    for ( auto &templatePage : m_commonData.TemplatePages ){
+        if ( templatePage.ID == templateID ) return &templatePage;
+    }
+    return nullptr;
+}
+
+// 对象内容签名，不含对象ID。
+static std::string getObjectSignature(const ObjectPtr object){
+    XMLWriter writer;
+    writer.StartDocument();
+    object->GenerateXML(writer);
+    writer.EndDocument();
+    std::string signature = writer.GetString();
+
+    size_t pos = signature.find(" ID=\"");
+    if ( pos != std::string::npos ){
+        size_t end = signature.find('"', pos + 5);
+        if ( end != std::string::npos ){
+            signature.erase(pos, end + 1 - pos);
+        }
+    }
+    return signature;
+}
+
+// 两个签名序列开头（fromEnd时为结尾）相同的对象数。
+static size_t getCommonObjects(const std::vector<std::string> &a, const std::vector<std::string> &b, bool fromEnd){
+    size_t n = std::min(a.size(), b.size());
+    size_t k = 0;
+    while ( k < n ){
+        const std::string &sa = fromEnd ? a[a.size() - 1 - k] : a[k];
+        const std::string &sb = fromEnd ? b[b.size() - 1 - k] : b[k];
+        if ( sa != sb ) break;
+        k++;
+    }
+    return k;
+}
+
+// ======== Document::FactorTemplatePages() ========
+// 依次扫描页面，取连续多页正文层的最长公共开头（结尾），
+// 不少于minObjects个对象时移入新建的背景（前景）模板页。
+size_t Document::FactorTemplatePages(size_t minObjects){
+    if ( minObjects == 0 ) return 0;
+
+    size_t numPages = m_pages.size();
+    std::vector<LayerPtr> bodyLayers(numPages);
+    std::vector<std::vector<std::string> > signatures(numPages);
+    for ( size_t i = 0 ; i < numPages ; i++ ){
+        bodyLayers[i] = m_pages[i]->GetBodyLayer();
+        if ( bodyLayers[i] == nullptr ) continue;
+        const ObjectArray &objects = bodyLayers[i]->GetObjects();
+        for ( auto object : objects ){
+            signatures[i].push_back(getObjectSignature(object));
+        }
+    }
+
+    size_t numTemplates = 0;
+    for ( int pass = 0 ; pass < 2 ; pass++ ){
+        bool fromEnd = (pass == 1);
+
+        size_t i = 0;
+        while ( i < numPages ){
+            size_t numCommon = signatures[i].size();
+            size_t j = i;
+            while ( j + 1 < numPages ){
+                size_t n = std::min(numCommon, getCommonObjects(signatures[i], signatures[j + 1], fromEnd));
+                if ( n < minObjects ) break;
+                numCommon = n;
+                j++;
+            }
+            if ( j == i || numCommon < minObjects ){
+                i = j + 1;
+                continue;
+            }
+
+            // -------- 以第一页的对象建立模板页 --------
+            PagePtr templatePage = AddNewTemplatePage(fromEnd ? LayerType::FOREGROUND : LayerType::BACKGROUND);
+            templatePage->Area = m_pages[i]->Area;
+            LayerPtr templateLayer = templatePage->AddNewLayer(LayerType::BODY);
+            uint64_t templateID = templatePage->ID;
+
+            for ( size_t k = i ; k <= j ; k++ ){
+                ObjectArray &objects = bodyLayers[k]->GetObjects();
+                std::vector<std::string> &pageSignatures = signatures[k];
+                size_t first = fromEnd ? objects.size() - numCommon : 0;
+                if ( k == i ){
+                    for ( size_t m = first ; m < first + numCommon ; m++ ){
+                        objects[m]->SetLayer(templateLayer);
+                        templateLayer->GetObjects().push_back(objects[m]);
+                    }
+                }
+                objects.erase(objects.begin() + first, objects.begin() + first + numCommon);
+                pageSignatures.erase(pageSignatures.begin() + first, pageSignatures.begin() + first + numCommon);
+
+                m_pages[k]->Templates.push_back(CT_Template(templateID, fromEnd ? LayerType::FOREGROUND : LayerType::BACKGROUND));
+            }
+            LOG(INFO) << "Template page " << templateID << " factored from pages " << i << "-" << j
+                << ". objects: " << numCommon << (fromEnd ? " (foreground)" : " (background)");
+
+            numTemplates++;
+            i = j + 1;
+        }
+    }
+
+    return numTemplates;
+}
+
 // ======== Document::GenerateDocumentXML() ========
 // Called by ofd::Package::Save().
 std::string Document::GenerateDocumentXML() const{
@@ -182,9 +328,33 @@ void Document::generateCommonDataXML(XMLWriter &writer) const{
             writer.WriteElement("DocumentRes", m_commonData.DocumentRes->GetResDescFile());
         }
 
-        // TODO
         // -------- <TemplatePage>
         // Optional
+        for ( auto &templatePage : m_commonData.TemplatePages ){
+            writer.StartElement("TemplatePage");{
+
+                // -------- <TemplatePage ID="">
+                // Required.
+                writer.WriteAttribute("ID", templatePage.ID);
+
+                // -------- <TemplatePage Name="">
+                // Optional.
+                if ( !templatePage.Name.empty() ){
+                    writer.WriteAttribute("Name", templatePage.Name);
+                }
+
+                // -------- <TemplatePage ZOrder="">
+                // Optional. 缺省为Background。
+                if ( templatePage.ZOrder != LayerType::BACKGROUND ){
+                    writer.WriteAttribute("ZOrder", LayerTypeToString(templatePage.ZOrder));
+                }
+
+                // -------- <TemplatePage BaseLoc="">
+                // Required. 与Package::Save()写入的位置一致。
+                writer.WriteAttribute("BaseLoc", std::string("Tpls/Tpl_") + std::to_string(templatePage.ID) + "/Content.xml");
+
+            } writer.EndElement();
+        }
 
         // TODO
         // -------- <DefaultCS>
@@ -681,10 +851,32 @@ bool Document::fromCommonDataXML(XMLElementPtr commonDataElement){
                 //m_commonData.DocumentRes = Resource::CreateNewResource(m_ofdDocument->GetSelf());
             }
 
-        //} else if ( childName == "TemplatePage" ){
-            //// TODO
-            //// -------- <TemplatePage>
-            //// Optional.
+        } else if ( childName == "TemplatePage" ){
+            // -------- <TemplatePage>
+            // Optional.
+            // 只记录模板页定义，内容在首次被引用时由GetTemplatePage()解析。
+            bool exist = false;
+            CT_TemplatePage templatePage;
+            std::tie(templatePage.ID, exist) = childElement->GetIntAttribute("ID");
+            if ( !exist ){
+                LOG(ERROR) << "Attribute ID is required in TemplatePage.";
+            } else {
+                std::tie(templatePage.BaseLoc, exist) = childElement->GetStringAttribute("BaseLoc");
+                if ( !exist ){
+                    LOG(ERROR) << "Attribute BaseLoc is required in TemplatePage.";
+                } else {
+                    std::tie(templatePage.Name, std::ignore) = childElement->GetStringAttribute("Name");
+                    std::string strZOrder;
+                    std::tie(strZOrder, exist) = childElement->GetStringAttribute("ZOrder");
+                    if ( exist ){
+                        templatePage.ZOrder = LayerTypeFromString(strZOrder);
+                    }
+                    templatePage.Page = Page::CreateNewPage(GetSelf());
+                    templatePage.Page->ID = templatePage.ID;
+                    templatePage.Page->BaseLoc = templatePage.BaseLoc;
+                    m_commonData.TemplatePages.push_back(templatePage);
+                }
+            }
 
         //} else if ( childName == "DefaultCS" ){
             //// TODO
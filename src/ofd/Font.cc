@@ -3,18 +3,16 @@
 #include <assert.h>
 #include <tuple>
 #include <inttypes.h>
-// ---- freetype ----
-#include <ft2build.h>
-#include FT_FREETYPE_H
-#include FT_GLYPH_H
 // ---- cairo ----
 #include <cairo/cairo.h>
-#include <cairo/cairo-ft.h>
 
 #include "ofd/Font.h"
+#include "ofd/FontCache.h"
 #include "ofd/Package.h"
+#include "ofd/SystemFontIndex.h"
 #include "utils/logger.h"
 #include "utils/xml.h"
+#include "utils/unicode.h"
 
 using namespace ofd;
 using namespace utils;
@@ -29,83 +27,6 @@ namespace ofd{
     }
 }
 
-// **************** class FreetypeInitiator ****************
-
-class FreetypeInitiator{
-public:
-    FreetypeInitiator(){
-        InitializeFreetype();
-    }
-
-    ~FreetypeInitiator(){
-        FinalizeFreetype();
-    }
-
-    bool InitializeFreetype();
-    void FinalizeFreetype();
-
-public:
-    static FT_Library ft_lib;
-private:
-    static bool ft_lib_initialized;
-};
-
-bool FreetypeInitiator::InitializeFreetype(){
-    if ( ft_lib_initialized ) return true;
-
-    FT_Error error = FT_Init_FreeType(&ft_lib);
-    if ( error ){
-        LOG(ERROR) << "FT_Init_FreeType() in OFDRes::InitializeFreetype() failed.";
-    } else {
-        ft_lib_initialized = true;
-    }
-
-    return ft_lib_initialized;
-}
-
-void FreetypeInitiator::FinalizeFreetype(){
-    if ( ft_lib_initialized ){
-        FT_Done_FreeType(ft_lib);
-        ft_lib = nullptr;
-        ft_lib_initialized = false;
-    }
-}
-
-FT_Library FreetypeInitiator::ft_lib = nullptr;
-bool FreetypeInitiator::ft_lib_initialized = false;
-FreetypeInitiator ftInitiator;
-
-static cairo_user_data_key_t _ft_cairo_key;
-static void _ft_done_face_uncached (void *closure) {
-    FT_Face face = (FT_Face) closure;
-    FT_Done_Face (face);
-}
-
-// ======== CreateCairoFontFace() ========
-std::tuple<FT_Face, cairo_font_face_t*, bool> CreateCairoFontFace(char *fontData, size_t fontDataLen){
-    bool ok = false;
-
-    FT_Face face;
-    cairo_font_face_t *font_face;
-
-    if ( FT_New_Memory_Face(FreetypeInitiator::ft_lib, (unsigned char *)fontData, fontDataLen, 0, &face) != 0 ){
-        LOG(ERROR) << "FT_New_Memory_Face() in OFDFont::createCairoFontFace() failed.";
-    } else {
-
-        font_face = cairo_ft_font_face_create_for_ft_face (face, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
-        if ( cairo_font_face_set_user_data (font_face, &_ft_cairo_key, face, _ft_done_face_uncached) != 0 ) {
-            LOG(ERROR) << "cairo_font_face_set_user_data() in OFDFont::createCairoFontFace() failed.";
-            _ft_done_face_uncached(face);
-            cairo_font_face_destroy(font_face);
-            font_face = nullptr;
-        } else {
-            ok = true;
-        }
-    }
-
-    return std::make_tuple(face, font_face, ok);
-}
-
 // **************** class ofd::Font ****************
 
 Font::Font() :
@@ -113,24 +34,24 @@ Font::Font() :
     Serif(false), Bold(false), Italic(false), FixedWidth(false),
     FontType(ofd::FontType::TrueType), FontLoc(ofd::FontLocation::Embedded),
     m_bLoaded(false), m_fontData(nullptr), m_fontDataSize(0), m_fontFace(nullptr), m_substitute(false),
-    m_codeToGID(nullptr), m_codeToGIDLen(0)
+    m_codeToGID(nullptr)
 {
 }
 
 Font::~Font(){
+    releaseFontData();
+}
+
+// 字体数据由FontCache持有时随cairo字体一起归还。
+void Font::releaseFontData(){
     if ( m_fontFace != nullptr ){
-        cairo_font_face_destroy(m_fontFace);
+        FontCache::GlobalInstance().Release(m_fontFace);
         m_fontFace = nullptr;
+    } else if ( m_fontData != nullptr ){
+        delete[] m_fontData;
     }
-    if ( m_codeToGID != nullptr ){
-        delete m_codeToGID;
-        m_codeToGID = nullptr;
-        m_codeToGIDLen = 0;
-    }
-    if ( m_fontData != nullptr ){
-        delete m_fontData;
-        m_fontData = nullptr;
-    }
+    m_fontData = nullptr;
+    m_fontDataSize = 0;
 }
 
 // ======== Font::CreateFromData() ========
@@ -139,19 +60,22 @@ bool Font::CreateFromData(char *fontData, size_t fontDataSize){
 
     LOG(INFO) << "@@@@@@@@ ID: " << ID << " FontName: " << FontName << " fontDataSize: " << fontDataSize;
 
-    if ( m_fontData != nullptr ){
-        delete m_fontData;
-        m_fontData = nullptr;
+    releaseFontData();
+
+    // 相同内容的字体在进程内只创建一次。
+    cairo_font_face_t *font_face = nullptr;
+    const char *cachedData = nullptr;
+    std::tie(font_face, cachedData) = FontCache::GlobalInstance().Acquire(fontData, fontDataSize);
+    if ( font_face != nullptr ){
+        m_fontData = cachedData;
+    } else {
+        ok = false;
+        m_fontData = fontData;
     }
     m_fontDataSize = fontDataSize;
-    m_fontData = fontData;
-
-    FT_Face face;
-    cairo_font_face_t *font_face;
-    std::tie(face, font_face, ok) = CreateCairoFontFace(m_fontData, m_fontDataSize); 
 
     m_fontFace = font_face;
-    m_bLoaded = true;
+    m_bLoaded = ok;
 
     return ok;
 }
@@ -212,6 +136,15 @@ void Font::GenerateXML(XMLWriter &writer) const{
         std::string fontFilePath = GetFontFilePath();
         writer.WriteElement("FontFile", fontFilePath);
 
+        // -------- <CodeToGID Size="">
+        // 扩展：编码到字形编号映射，重新打开时不必从字体程序推导。
+        if ( m_codeToGID != nullptr ){
+            writer.StartElement("CodeToGID");{
+                writer.WriteAttribute("Size", (uint64_t)m_codeToGID->GetSize());
+                writer.WriteString(m_codeToGID->ToString());
+            } writer.EndElement();
+        }
+
     } writer.EndElement();
 
 }
@@ -273,11 +206,26 @@ bool Font::FromXML(XMLElementPtr fontElement){
             // Optional
             std::tie(FixedWidth, std::ignore) = fontElement->GetBooleanAttribute("FixedWidth");
 
-            XMLElementPtr fontFileElement = fontElement->GetFirstChildElement();
-            if ( fontFileElement != nullptr && fontFileElement->GetName() == "FontFile" ){
-                std::string fontFilePath;
-                std::tie(fontFilePath, std::ignore) = fontFileElement->GetStringValue();
-                SetFontFilePath(fontFilePath);
+            XMLElementPtr childElement = fontElement->GetFirstChildElement();
+            while ( childElement != nullptr ){
+                std::string childName = childElement->GetName();
+                if ( childName == "FontFile" ){
+                    std::string fontFilePath;
+                    std::tie(fontFilePath, std::ignore) = childElement->GetStringValue();
+                    SetFontFilePath(fontFilePath);
+                } else if ( childName == "CodeToGID" ){
+                    uint64_t size = 0;
+                    std::string codeToGIDString;
+                    std::tie(size, std::ignore) = childElement->GetIntAttribute("Size");
+                    std::tie(codeToGIDString, std::ignore) = childElement->GetStringValue();
+                    // Size来自文档，不可信，超出范围时忽略映射，按字体程序推导。
+                    if ( size <= CodeToGIDMap::MaxSize ){
+                        m_codeToGID = CodeToGIDMap::FromString(codeToGIDString, size);
+                    } else {
+                        LOG(WARNING) << "CodeToGID size " << size << " of font " << ID << " out of range. Map ignored.";
+                    }
+                }
+                childElement = childElement->GetNextSiblingElement();
             }
 
             ok = true;
@@ -316,7 +264,35 @@ bool Font::Load(PackagePtr package, bool reload){
         char *fontData = nullptr;
         size_t fontDataSize = 0;
         bool readOK = false;
-        std::tie(fontData, fontDataSize, readOK) = package->ReadZipFileRaw(fontFilePath);
+        if ( !fontFilePath.empty() ){
+            std::tie(fontData, fontDataSize, readOK) = package->ReadZipFileRaw(fontFilePath);
+            FontLoc = ofd::FontLocation::Embedded;
+            if ( !readOK && fontFilePath[0] == '/' ){
+                // 外部字体，FontFile为本机路径。
+                std::tie(fontData, fontDataSize, readOK) = utils::ReadFileData(fontFilePath);
+                FontLoc = ofd::FontLocation::External;
+            }
+            if ( !readOK ){
+                LOG(WARNING) << "Read font file " << fontFilePath << " failed. Try system fonts.";
+            }
+        }
+        m_substitute = false;
+        if ( !readOK ){
+            // 未嵌入的字体由系统字体索引查找，找不到同名字体时以相近字体替代。
+            std::string fontName = FamilyName.empty() ? FontName : FamilyName;
+            std::string systemFontFile;
+            bool found = false;
+            std::tie(systemFontFile, m_substitute, found) = SystemFontIndex::GlobalInstance().FindFont(fontName, Bold, Italic, Charset);
+            if ( found ){
+                std::tie(fontData, fontDataSize, readOK) = utils::ReadFileData(systemFontFile);
+                FontLoc = ofd::FontLocation::External;
+            }
+            if ( readOK ){
+                LOG(DEBUG) << "Font " << fontName << " resolved to " << systemFontFile << (m_substitute ? " (substitute)" : "");
+            } else {
+                LOG(ERROR) << "No system font for " << fontName << ".";
+            }
+        }
         if ( readOK ){
             if ( CreateFromData(fontData, fontDataSize) ){
                 LOG(INFO) << "Font " << FontName << "(ID=" << ID << ") loaded.";
@@ -326,7 +302,6 @@ bool Font::Load(PackagePtr package, bool reload){
             }
         } else {
             ok = false;
-            LOG(ERROR) << "Call ReadZipFileRaw() to read font file " << fontFilePath << " failed.";
         }
 
         m_bLoaded = ok;
@@ -335,14 +310,46 @@ bool Font::Load(PackagePtr package, bool reload){
     return m_bLoaded;
 }
 
-unsigned long Font::GetGlyph(unsigned int code, unsigned int *u, int uLen) const{
-    FT_UInt gid;
+// ======== Font::AddUsedText() ========
+void Font::AddUsedText(const std::string &text){
+    const unsigned char *p = (const unsigned char*)text.c_str();
+    const unsigned char *end = p + text.length();
+    while ( p < end ){
+        unsigned long unicode = 0;
+        int len = enc_utf8_to_unicode_one(p, &unicode);
+        if ( len <= 0 ){
+            p++;
+            continue;
+        }
+        m_usedUnicodes.insert((uint32_t)unicode);
+        p += len;
+    }
+}
 
-    if ( m_codeToGID && code < m_codeToGIDLen) {
-        gid = (FT_UInt)m_codeToGID[code];
-    } else {
-        gid = (FT_UInt)code;
+void Font::ClearGlyphUsage(){
+    m_usedUnicodes.clear();
+    m_usedGlyphs.clear();
+}
+
+// ======== Font::CreateSubsetData() ========
+// 转换时经编码到字形编号映射记录的字形须保持编号不变。
+std::tuple<char*, size_t, bool> Font::CreateSubsetData() const{
+    if ( !HasGlyphUsage() || m_fontData == nullptr || m_fontDataSize == 0 ){
+        return std::make_tuple((char*)nullptr, (size_t)0, false);
     }
-    return gid;
+
+    char *subsetData = nullptr;
+    size_t subsetDataSize = 0;
+    bool ok = false;
+    bool retainGIDs = m_codeToGID != nullptr;
+    std::tie(subsetData, subsetDataSize, ok) = SubsetFontData(m_fontData, m_fontDataSize,
+            m_usedUnicodes, m_usedGlyphs, retainGIDs);
+    if ( ok ){
+        LOG(DEBUG) << "Font " << FontName << "(ID=" << ID << ") subset: " << m_fontDataSize << " -> " << subsetDataSize
+            << " bytes, " << m_usedUnicodes.size() << " chars, " << m_usedGlyphs.size() << " glyphs.";
+    }
+
+    return std::make_tuple(subsetData, subsetDataSize, ok);
 }
 
+
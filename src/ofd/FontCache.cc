@@ -0,0 +1,239 @@
+#include <assert.h>
+#include <string.h>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+// ---- cairo ----
+#include <cairo/cairo.h>
+
+#include "ofd/FontCache.h"
+#include "ofd/FontEngine.h"
+#include "utils/utils.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 字体数据随cairo字体一起释放。cairo按设置顺序销毁用户数据，
+// 此键在FontEngine::CreateCairoFontFace()设置的FT_Face键之后设置，FT_Done_Face()先于释放数据。
+static cairo_user_data_key_t _font_data_key;
+static void _font_data_destroy(void *closure){
+    delete[] (char*)closure;
+}
+
+// **************** class FontCache::ImplCls ****************
+
+class FontCache::ImplCls {
+public:
+    ImplCls(size_t maxIdleBytes);
+    ~ImplCls();
+
+    std::tuple<cairo_font_face_t*, const char*> Acquire(char *fontData, size_t fontDataSize);
+    void Release(cairo_font_face_t *fontFace);
+    void Clear();
+    void SetMaxIdleBytes(size_t maxIdleBytes);
+
+private:
+    typedef std::list<cairo_font_face_t*> FaceList;
+
+    typedef struct Entry{
+        uint64_t Hash;
+        const char *Data;
+        size_t DataSize;
+        cairo_font_face_t *FontFace; // 缓存持有的引用
+        int NumUsers;
+        FaceList::iterator IdlePos;  // NumUsers为0时在空闲队列中的位置
+    } Entry_t;
+    typedef std::map<cairo_font_face_t*, Entry> EntryMap;
+
+    void evict();
+    void erase(EntryMap::iterator it);
+
+public:
+    mutable std::mutex m_mutex;
+    size_t m_maxIdleBytes;
+    size_t m_idleBytes;
+    uint64_t m_hits;
+    uint64_t m_misses;
+    EntryMap m_entries;
+
+private:
+    std::unordered_multimap<uint64_t, cairo_font_face_t*> m_hashIndex;
+    FaceList m_idleFaces; // 最近归还的在前
+
+}; // class FontCache::ImplCls
+
+FontCache::ImplCls::ImplCls(size_t maxIdleBytes) :
+    m_maxIdleBytes(maxIdleBytes), m_idleBytes(0), m_hits(0), m_misses(0){
+}
+
+FontCache::ImplCls::~ImplCls(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while ( !m_entries.empty() ){
+        erase(m_entries.begin());
+    }
+}
+
+// ======== FontCache::ImplCls::Acquire() ========
+std::tuple<cairo_font_face_t*, const char*> FontCache::ImplCls::Acquire(char *fontData, size_t fontDataSize){
+    if ( fontData == nullptr || fontDataSize == 0 ){
+        return std::make_tuple(nullptr, nullptr);
+    }
+
+    uint64_t hash = utils::HashData(fontData, fontDataSize);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto range = m_hashIndex.equal_range(hash);
+    for ( auto it = range.first ; it != range.second ; it++ ){
+        Entry &entry = m_entries[it->second];
+        if ( entry.DataSize == fontDataSize && memcmp(entry.Data, fontData, fontDataSize) == 0 ){
+            if ( entry.NumUsers == 0 ){
+                m_idleFaces.erase(entry.IdlePos);
+                m_idleBytes -= entry.DataSize;
+            }
+            entry.NumUsers++;
+            m_hits++;
+            delete[] fontData;
+            return std::make_tuple(cairo_font_face_reference(entry.FontFace), entry.Data);
+        }
+    }
+
+    // 在锁内创建，相同字体并发加载时只创建一次。
+    cairo_font_face_t *fontFace = FontEngine::CreateCairoFontFace(fontData, fontDataSize);
+    if ( fontFace == nullptr ){
+        return std::make_tuple(nullptr, nullptr);
+    }
+    if ( cairo_font_face_set_user_data(fontFace, &_font_data_key, fontData, _font_data_destroy) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "cairo_font_face_set_user_data() in FontCache::Acquire() failed.";
+        // 字体数据归调用者，FT_Face随cairo字体释放。
+        cairo_font_face_destroy(fontFace);
+        return std::make_tuple(nullptr, nullptr);
+    }
+    m_misses++;
+
+    Entry entry;
+    entry.Hash = hash;
+    entry.Data = fontData;
+    entry.DataSize = fontDataSize;
+    entry.FontFace = fontFace;
+    entry.NumUsers = 1;
+    entry.IdlePos = m_idleFaces.end();
+    m_entries[fontFace] = entry;
+    m_hashIndex.insert(std::make_pair(hash, fontFace));
+
+    return std::make_tuple(cairo_font_face_reference(fontFace), (const char*)fontData);
+}
+
+// ======== FontCache::ImplCls::Release() ========
+void FontCache::ImplCls::Release(cairo_font_face_t *fontFace){
+    if ( fontFace == nullptr ) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(fontFace);
+        if ( it != m_entries.end() ){
+            Entry &entry = it->second;
+            assert(entry.NumUsers > 0);
+            if ( --entry.NumUsers == 0 ){
+                m_idleFaces.push_front(fontFace);
+                entry.IdlePos = m_idleFaces.begin();
+                m_idleBytes += entry.DataSize;
+                evict();
+            }
+        }
+    }
+
+    // 释放使用者的引用。
+    cairo_font_face_destroy(fontFace);
+}
+
+void FontCache::ImplCls::evict(){
+    while ( m_idleBytes > m_maxIdleBytes && !m_idleFaces.empty() ){
+        erase(m_entries.find(m_idleFaces.back()));
+    }
+}
+
+// 删除缓存项并释放缓存的引用。使用中的字体由使用者的引用维持。
+void FontCache::ImplCls::erase(EntryMap::iterator it){
+    Entry &entry = it->second;
+    if ( entry.NumUsers == 0 ){
+        m_idleFaces.erase(entry.IdlePos);
+        m_idleBytes -= entry.DataSize;
+    }
+
+    auto range = m_hashIndex.equal_range(entry.Hash);
+    for ( auto hashIt = range.first ; hashIt != range.second ; hashIt++ ){
+        if ( hashIt->second == entry.FontFace ){
+            m_hashIndex.erase(hashIt);
+            break;
+        }
+    }
+
+    cairo_font_face_destroy(entry.FontFace);
+    m_entries.erase(it);
+}
+
+void FontCache::ImplCls::Clear(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while ( !m_idleFaces.empty() ){
+        erase(m_entries.find(m_idleFaces.back()));
+    }
+}
+
+void FontCache::ImplCls::SetMaxIdleBytes(size_t maxIdleBytes){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxIdleBytes = maxIdleBytes;
+    evict();
+}
+
+// **************** class FontCache ****************
+
+FontCache::FontCache(size_t maxIdleBytes) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(maxIdleBytes))){
+}
+
+FontCache::~FontCache(){
+}
+
+// 有意不释放：静态对象析构时仍可能有Font在释放字体，与FontEngine的FreeType库一致。
+FontCache& FontCache::GlobalInstance(){
+    static FontCache *globalInstance = new FontCache();
+    return *globalInstance;
+}
+
+std::tuple<cairo_font_face_t*, const char*> FontCache::Acquire(char *fontData, size_t fontDataSize){
+    return m_impl->Acquire(fontData, fontDataSize);
+}
+
+void FontCache::Release(cairo_font_face_t *fontFace){
+    m_impl->Release(fontFace);
+}
+
+void FontCache::Clear(){
+    m_impl->Clear();
+}
+
+size_t FontCache::GetMaxIdleBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_maxIdleBytes;
+}
+
+void FontCache::SetMaxIdleBytes(size_t maxIdleBytes){
+    m_impl->SetMaxIdleBytes(maxIdleBytes);
+}
+
+size_t FontCache::GetNumFonts() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_entries.size();
+}
+
+size_t FontCache::GetIdleBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_idleBytes;
+}
+
+std::tuple<uint64_t, uint64_t> FontCache::GetHitsMisses() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return std::make_tuple(m_impl->m_hits, m_impl->m_misses);
+}
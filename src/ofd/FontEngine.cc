@@ -0,0 +1,64 @@
+#include <assert.h>
+#include <mutex>
+// ---- freetype ----
+#include <ft2build.h>
+#include FT_FREETYPE_H
+// ---- cairo ----
+#include <cairo/cairo.h>
+#include <cairo/cairo-ft.h>
+
+#include "ofd/FontEngine.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 有意不释放：FT_Done_Face()可能在任意线程、任意时刻由cairo触发。
+static FT_Library ftLibrary = nullptr;
+static std::mutex *ftMutex = nullptr;
+static std::once_flag ftOnce;
+
+static void initializeFreeType(){
+    ftMutex = new std::mutex();
+    if ( FT_Init_FreeType(&ftLibrary) != 0 ){
+        LOG(ERROR) << "FT_Init_FreeType() in FontEngine::Initialize() failed.";
+        ftLibrary = nullptr;
+    }
+}
+
+static cairo_user_data_key_t _ft_cairo_key;
+static void _ft_done_face(void *closure){
+    FT_Face face = (FT_Face)closure;
+    std::lock_guard<std::mutex> lock(*ftMutex);
+    FT_Done_Face(face);
+}
+
+// **************** class FontEngine ****************
+
+bool FontEngine::Initialize(){
+    std::call_once(ftOnce, initializeFreeType);
+    return ftLibrary != nullptr;
+}
+
+// ======== FontEngine::CreateCairoFontFace() ========
+cairo_font_face_t *FontEngine::CreateCairoFontFace(const char *fontData, size_t fontDataSize){
+    if ( !Initialize() ) return nullptr;
+
+    FT_Face face = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(*ftMutex);
+        if ( FT_New_Memory_Face(ftLibrary, (const FT_Byte*)fontData, (FT_Long)fontDataSize, 0, &face) != 0 ){
+            LOG(ERROR) << "FT_New_Memory_Face() in FontEngine::CreateCairoFontFace() failed.";
+            return nullptr;
+        }
+    }
+
+    cairo_font_face_t *fontFace = cairo_ft_font_face_create_for_ft_face(face, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
+    if ( cairo_font_face_set_user_data(fontFace, &_ft_cairo_key, face, _ft_done_face) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "cairo_font_face_set_user_data() in FontEngine::CreateCairoFontFace() failed.";
+        cairo_font_face_destroy(fontFace);
+        _ft_done_face(face);
+        return nullptr;
+    }
+
+    return fontFace;
+}
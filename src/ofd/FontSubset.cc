@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <string.h>
+#ifdef HAVE_HB_SUBSET
+#include <hb.h>
+#include <hb-subset.h>
+// hb-subset的公开接口自2.6.0起稳定。
+#if HB_VERSION_ATLEAST(2, 6, 0)
+#define OFD_FONT_SUBSET 1
+#endif
+#endif
+#include "ofd/FontSubset.h"
+#include "utils/logger.h"
+
+namespace ofd{
+
+#ifdef OFD_FONT_SUBSET
+
+bool IsFontSubsetSupported(){
+    return true;
+}
+
+// ======== SubsetFontData() ========
+std::tuple<char*, size_t, bool> SubsetFontData(const char *fontData, size_t fontDataSize,
+        const CodeSet &unicodes, const CodeSet &glyphIDs, bool retainGIDs){
+    char *subsetData = nullptr;
+    size_t subsetDataSize = 0;
+    bool ok = false;
+
+    if ( fontData == nullptr || fontDataSize == 0 ){
+        return std::make_tuple(subsetData, subsetDataSize, ok);
+    }
+
+    hb_blob_t *blob = hb_blob_create(fontData, fontDataSize, HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+    hb_face_t *face = hb_face_create(blob, 0);
+    hb_blob_destroy(blob);
+
+    hb_subset_input_t *input = hb_subset_input_create_or_fail();
+    if ( input == nullptr ){
+        LOG(ERROR) << "hb_subset_input_create_or_fail() in SubsetFontData() failed.";
+        hb_face_destroy(face);
+        return std::make_tuple(subsetData, subsetDataSize, ok);
+    }
+
+    hb_set_t *unicodeSet = hb_subset_input_unicode_set(input);
+    for ( auto unicode : unicodes ){
+        hb_set_add(unicodeSet, unicode);
+    }
+    hb_set_t *glyphSet = hb_subset_input_glyph_set(input);
+    for ( auto glyphID : glyphIDs ){
+        hb_set_add(glyphSet, glyphID);
+    }
+
+#if HB_VERSION_ATLEAST(2, 9, 0)
+    if ( retainGIDs ){
+        hb_subset_input_set_flags(input, hb_subset_input_get_flags(input) | HB_SUBSET_FLAGS_RETAIN_GIDS);
+    }
+    hb_face_t *subsetFace = hb_subset_or_fail(face, input);
+#else
+    hb_subset_input_set_retain_gids(input, retainGIDs);
+    hb_face_t *subsetFace = hb_subset(face, input);
+#endif
+    hb_subset_input_destroy(input);
+    hb_face_destroy(face);
+
+    if ( subsetFace != nullptr ){
+        hb_blob_t *subsetBlob = hb_face_reference_blob(subsetFace);
+        unsigned int length = 0;
+        const char *data = hb_blob_get_data(subsetBlob, &length);
+        // 子集化失败时得到空字体。
+        if ( data != nullptr && length > 0 && length < fontDataSize ){
+            subsetDataSize = length;
+            subsetData = new char[subsetDataSize];
+            memcpy(subsetData, data, subsetDataSize);
+            ok = true;
+        }
+        hb_blob_destroy(subsetBlob);
+        hb_face_destroy(subsetFace);
+    }
+
+    return std::make_tuple(subsetData, subsetDataSize, ok);
+}
+
+#else
+
+bool IsFontSubsetSupported(){
+    return false;
+}
+
+std::tuple<char*, size_t, bool> SubsetFontData(const char *fontData, size_t fontDataSize,
+        const CodeSet &unicodes, const CodeSet &glyphIDs, bool retainGIDs){
+    return std::make_tuple((char*)nullptr, (size_t)0, false);
+}
+
+#endif // OFD_FONT_SUBSET
+
+}; // namespace ofd
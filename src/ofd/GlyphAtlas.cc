@@ -0,0 +1,331 @@
+#include <assert.h>
+#include <math.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include "ofd/GlyphAtlas.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 设备空间字号量化为1/64像素作为键。
+static inline int64_t getSizeKey(double size){
+    return (int64_t)llround(size * 64.0);
+}
+
+// **************** class GlyphAtlas::ImplCls ****************
+
+class GlyphAtlas::ImplCls {
+public:
+    ImplCls(size_t maxBytes);
+    ~ImplCls();
+
+    bool ShowText(cairo_t *cr, cairo_font_face_t *fontFace, const cairo_matrix_t &fontMatrix,
+            const cairo_font_options_t *fontOptions, double x, double y, const std::string &text);
+    void Clear();
+    void SetMaxBytes(size_t maxBytes);
+
+private:
+    typedef struct GlyphKey{
+        cairo_font_face_t *FontFace;
+        int64_t SizeX;
+        int64_t SizeY;
+        int Antialias;
+        unsigned long Index;
+        int Subpixel;
+
+        bool operator <(const GlyphKey &other) const {
+            return std::tie(FontFace, SizeX, SizeY, Antialias, Index, Subpixel) <
+                std::tie(other.FontFace, other.SizeX, other.SizeY, other.Antialias, other.Index, other.Subpixel);
+        }
+    } GlyphKey_t;
+    typedef std::list<GlyphKey> KeyList;
+
+    // 位图左上角相对字形原点所在像素的偏移。空白字形Surface为nullptr。
+    typedef struct Glyph{
+        cairo_surface_t *Surface;
+        int Left;
+        int Top;
+    } Glyph_t;
+
+    typedef struct Entry{
+        Glyph Bitmap;
+        size_t Bytes;
+        KeyList::iterator LRUPos;
+    } Entry_t;
+    typedef std::map<GlyphKey, Entry> EntryMap;
+
+    // 返回的位图持有一个引用。
+    bool lookup(const GlyphKey &key, Glyph &glyph);
+    Glyph insert(const GlyphKey &key, const Glyph &glyph);
+    Glyph rasterize(cairo_scaled_font_t *scaledFont, unsigned long index, int subpixel);
+    void evict();
+    void erase(EntryMap::iterator it);
+
+public:
+    mutable std::mutex m_mutex;
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+    uint64_t m_hits;
+    uint64_t m_misses;
+    EntryMap m_entries;
+
+private:
+    KeyList m_lru; // 最近使用的在前
+    // 缓存中有字形的字体持有一个引用，避免字体释放后地址被复用。
+    std::map<cairo_font_face_t*, size_t> m_fontFaces;
+
+}; // class GlyphAtlas::ImplCls
+
+GlyphAtlas::ImplCls::ImplCls(size_t maxBytes) :
+    m_maxBytes(maxBytes), m_usedBytes(0), m_hits(0), m_misses(0){
+}
+
+GlyphAtlas::ImplCls::~ImplCls(){
+    Clear();
+}
+
+// ======== GlyphAtlas::ImplCls::ShowText() ========
+bool GlyphAtlas::ImplCls::ShowText(cairo_t *cr, cairo_font_face_t *fontFace, const cairo_matrix_t &fontMatrix,
+        const cairo_font_options_t *fontOptions, double x, double y, const std::string &text){
+
+    if ( fontFace == nullptr || text.empty() ) return false;
+    if ( cairo_surface_get_type(cairo_get_group_target(cr)) != CAIRO_SURFACE_TYPE_IMAGE ) return false;
+    if ( cairo_pattern_get_type(cairo_get_source(cr)) != CAIRO_PATTERN_TYPE_SOLID ) return false;
+
+    // 设备空间字体矩阵，只处理未旋转、未错切的情况。
+    cairo_matrix_t ctm;
+    cairo_get_matrix(cr, &ctm);
+    cairo_matrix_t deviceMatrix;
+    cairo_matrix_multiply(&deviceMatrix, &fontMatrix, &ctm);
+    deviceMatrix.x0 = deviceMatrix.y0 = 0.0;
+    if ( fabs(deviceMatrix.xy) > 1e-6 || fabs(deviceMatrix.yx) > 1e-6 ||
+            deviceMatrix.xx <= 0.0 || deviceMatrix.yy <= 0.0 ){
+        return false;
+    }
+
+    cairo_matrix_t identity;
+    cairo_matrix_init_identity(&identity);
+    cairo_scaled_font_t *scaledFont = cairo_scaled_font_create(fontFace, &deviceMatrix, &identity, fontOptions);
+    if ( cairo_scaled_font_status(scaledFont) != CAIRO_STATUS_SUCCESS ){
+        cairo_scaled_font_destroy(scaledFont);
+        return false;
+    }
+
+    double originX = x, originY = y;
+    cairo_user_to_device(cr, &originX, &originY);
+
+    cairo_glyph_t *glyphs = nullptr;
+    int numGlyphs = 0;
+    cairo_status_t status = cairo_scaled_font_text_to_glyphs(scaledFont, originX, originY, text.c_str(), text.length(),
+            &glyphs, &numGlyphs, nullptr, nullptr, nullptr);
+    if ( status != CAIRO_STATUS_SUCCESS ){
+        cairo_scaled_font_destroy(scaledFont);
+        return false;
+    }
+
+    GlyphKey key;
+    key.FontFace = fontFace;
+    key.SizeX = getSizeKey(deviceMatrix.xx);
+    key.SizeY = getSizeKey(deviceMatrix.yy);
+    key.Antialias = fontOptions != nullptr ? (int)cairo_font_options_get_antialias(fontOptions) : 0;
+
+    cairo_save(cr);
+    cairo_identity_matrix(cr);
+    for ( int i = 0 ; i < numGlyphs ; i++ ){
+        double pixelX = floor(glyphs[i].x);
+        int subpixel = (int)((glyphs[i].x - pixelX) * SubpixelPositions);
+        double pixelY = floor(glyphs[i].y + 0.5);
+
+        key.Index = glyphs[i].index;
+        key.Subpixel = subpixel;
+        Glyph glyph;
+        if ( !lookup(key, glyph) ){
+            glyph = insert(key, rasterize(scaledFont, glyphs[i].index, subpixel));
+        }
+        if ( glyph.Surface != nullptr ){
+            cairo_mask_surface(cr, glyph.Surface, pixelX + glyph.Left, pixelY + glyph.Top);
+            cairo_surface_destroy(glyph.Surface);
+        }
+    }
+    cairo_restore(cr);
+
+    cairo_glyph_free(glyphs);
+    cairo_scaled_font_destroy(scaledFont);
+
+    return true;
+}
+
+bool GlyphAtlas::ImplCls::lookup(const GlyphKey &key, Glyph &glyph){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if ( it == m_entries.end() ){
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.LRUPos);
+    glyph = it->second.Bitmap;
+    if ( glyph.Surface != nullptr ){
+        cairo_surface_reference(glyph.Surface);
+    }
+    return true;
+}
+
+// 接管glyph的引用。其它线程已插入同一字形时使用已有的位图。
+GlyphAtlas::ImplCls::Glyph GlyphAtlas::ImplCls::insert(const GlyphKey &key, const Glyph &glyph){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if ( it != m_entries.end() ){
+        if ( glyph.Surface != nullptr ){
+            cairo_surface_destroy(glyph.Surface);
+        }
+        Glyph cached = it->second.Bitmap;
+        if ( cached.Surface != nullptr ){
+            cairo_surface_reference(cached.Surface);
+        }
+        return cached;
+    }
+
+    Entry entry;
+    entry.Bitmap = glyph;
+    entry.Bytes = sizeof(Entry);
+    if ( glyph.Surface != nullptr ){
+        entry.Bytes += (size_t)cairo_image_surface_get_stride(glyph.Surface) * cairo_image_surface_get_height(glyph.Surface);
+        cairo_surface_reference(glyph.Surface);
+    }
+    m_lru.push_front(key);
+    entry.LRUPos = m_lru.begin();
+    m_entries[key] = entry;
+    m_usedBytes += entry.Bytes;
+
+    if ( m_fontFaces[key.FontFace]++ == 0 ){
+        cairo_font_face_reference(key.FontFace);
+    }
+
+    evict();
+    return glyph;
+}
+
+// 在A8表面上绘制字形，字形原点位于左上角像素偏移(Left, Top)的相反位置加亚像素偏移处。
+GlyphAtlas::ImplCls::Glyph GlyphAtlas::ImplCls::rasterize(cairo_scaled_font_t *scaledFont, unsigned long index, int subpixel){
+    Glyph glyph;
+    glyph.Surface = nullptr;
+    glyph.Left = 0;
+    glyph.Top = 0;
+
+    double offsetX = (double)subpixel / SubpixelPositions;
+    cairo_glyph_t cairoGlyph = {index, offsetX, 0.0};
+    cairo_text_extents_t extents;
+    cairo_scaled_font_glyph_extents(scaledFont, &cairoGlyph, 1, &extents);
+    if ( extents.width <= 0.0 || extents.height <= 0.0 ){
+        return glyph;
+    }
+
+    // 留一个像素的边以容纳抗锯齿。
+    int left = (int)floor(offsetX + extents.x_bearing) - 1;
+    int top = (int)floor(extents.y_bearing) - 1;
+    int right = (int)ceil(offsetX + extents.x_bearing + extents.width) + 1;
+    int bottom = (int)ceil(extents.y_bearing + extents.height) + 1;
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A8, right - left, bottom - top);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        cairo_surface_destroy(surface);
+        return glyph;
+    }
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_scaled_font(cr, scaledFont);
+    cairoGlyph.x = offsetX - left;
+    cairoGlyph.y = -top;
+    cairo_show_glyphs(cr, &cairoGlyph, 1);
+    cairo_destroy(cr);
+    cairo_surface_flush(surface);
+
+    glyph.Surface = surface;
+    glyph.Left = left;
+    glyph.Top = top;
+    return glyph;
+}
+
+void GlyphAtlas::ImplCls::evict(){
+    while ( m_usedBytes > m_maxBytes && !m_lru.empty() ){
+        erase(m_entries.find(m_lru.back()));
+    }
+}
+
+void GlyphAtlas::ImplCls::erase(EntryMap::iterator it){
+    Entry &entry = it->second;
+    m_usedBytes -= entry.Bytes;
+    m_lru.erase(entry.LRUPos);
+    if ( entry.Bitmap.Surface != nullptr ){
+        cairo_surface_destroy(entry.Bitmap.Surface);
+    }
+
+    cairo_font_face_t *fontFace = it->first.FontFace;
+    m_entries.erase(it);
+    auto faceIt = m_fontFaces.find(fontFace);
+    if ( faceIt != m_fontFaces.end() && --faceIt->second == 0 ){
+        m_fontFaces.erase(faceIt);
+        cairo_font_face_destroy(fontFace);
+    }
+}
+
+void GlyphAtlas::ImplCls::Clear(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while ( !m_entries.empty() ){
+        erase(m_entries.begin());
+    }
+}
+
+void GlyphAtlas::ImplCls::SetMaxBytes(size_t maxBytes){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+// **************** class GlyphAtlas ****************
+
+GlyphAtlas::GlyphAtlas(size_t maxBytes) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(maxBytes))){
+}
+
+GlyphAtlas::~GlyphAtlas(){
+}
+
+GlyphAtlas& GlyphAtlas::GlobalInstance(){
+    static GlyphAtlas globalInstance;
+    return globalInstance;
+}
+
+bool GlyphAtlas::ShowText(cairo_t *cr, cairo_font_face_t *fontFace, const cairo_matrix_t &fontMatrix,
+        const cairo_font_options_t *fontOptions, double x, double y, const std::string &text){
+    return m_impl->ShowText(cr, fontFace, fontMatrix, fontOptions, x, y, text);
+}
+
+void GlyphAtlas::Clear(){
+    m_impl->Clear();
+}
+
+size_t GlyphAtlas::GetMaxBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_maxBytes;
+}
+
+void GlyphAtlas::SetMaxBytes(size_t maxBytes){
+    m_impl->SetMaxBytes(maxBytes);
+}
+
+size_t GlyphAtlas::GetUsedBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_usedBytes;
+}
+
+size_t GlyphAtlas::GetNumGlyphs() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_entries.size();
+}
+
+std::tuple<uint64_t, uint64_t> GlyphAtlas::GetHitsMisses() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return std::make_tuple(m_impl->m_hits, m_impl->m_misses);
+}
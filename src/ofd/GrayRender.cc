@@ -0,0 +1,233 @@
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "ofd/GrayRender.h"
+#include "ofd/CairoRender.h"
+#include "ofd/SurfacePool.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// cairo的A1格式按32位字存放，位序与平台字节序一致。
+static inline void setMonoPixel(uint8_t *row, int x){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+#else
+    row[x >> 3] |= (uint8_t)(1 << (x & 7));
+#endif
+}
+
+// **************** class GrayRender::ImplCls ****************
+
+class GrayRender::ImplCls {
+public:
+    ImplCls(int pixelWidth, int pixelHeight, double resolutionX, double resolutionY,
+            GrayFormat format, int bandHeight);
+    ~ImplCls();
+
+    bool DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl);
+
+private:
+    void convertBand(int bandTop, int numRows);
+    void thresholdRow(const uint8_t *gray, uint8_t *dst);
+    void ditherRow(const uint8_t *gray, uint8_t *dst);
+
+public:
+    int m_pixelWidth;
+    int m_pixelHeight;
+    double m_resolutionY;
+    GrayFormat m_format;
+    int m_bandHeight;
+    MonoMethod m_monoMethod;
+    uint8_t m_monoThreshold;
+
+    cairo_surface_t *m_surface;
+    std::unique_ptr<CairoRender> m_bandRender;
+
+private:
+    std::vector<uint8_t> m_grayRow;
+    // 误差扩散的当前行和下一行误差，两端各留一个像素。
+    std::vector<int> m_errors;
+    std::vector<int> m_nextErrors;
+
+}; // class GrayRender::ImplCls
+
+GrayRender::ImplCls::ImplCls(int pixelWidth, int pixelHeight, double resolutionX, double resolutionY,
+        GrayFormat format, int bandHeight) :
+    m_pixelWidth(pixelWidth), m_pixelHeight(pixelHeight),
+    m_resolutionY(resolutionY), m_format(format),
+    m_bandHeight(std::max(1, std::min(bandHeight, pixelHeight))),
+    m_monoMethod(MonoMethod::Threshold), m_monoThreshold(128),
+    m_surface(nullptr){
+
+    cairo_format_t cairoFormat = format == GrayFormat::Gray8 ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_A1;
+    m_surface = SurfacePool::GlobalInstance().Acquire(cairoFormat, pixelWidth, pixelHeight);
+    if ( cairo_surface_status(m_surface) == CAIRO_STATUS_SUCCESS ){
+        // 借来的表面内容未定义，清为白色。
+        memset(cairo_image_surface_get_data(m_surface), 0xff,
+                (size_t)cairo_image_surface_get_stride(m_surface) * pixelHeight);
+        cairo_surface_mark_dirty(m_surface);
+    }
+    m_bandRender = std::unique_ptr<CairoRender>(new CairoRender(pixelWidth, m_bandHeight, resolutionX, resolutionY));
+
+    m_grayRow.resize(pixelWidth);
+    m_errors.resize(pixelWidth + 2);
+    m_nextErrors.resize(pixelWidth + 2);
+}
+
+GrayRender::ImplCls::~ImplCls(){
+    if ( m_surface != nullptr ){
+        SurfacePool::GlobalInstance().Release(m_surface);
+        m_surface = nullptr;
+    }
+}
+
+// ======== GrayRender::ImplCls::DrawPage() ========
+bool GrayRender::ImplCls::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    if ( page == nullptr ) return true;
+    if ( cairo_surface_status(m_surface) != CAIRO_STATUS_SUCCESS ) return false;
+
+    double pixelX, pixelY, scaling;
+    std::tie(pixelX, pixelY, scaling) = visibleParams;
+
+    std::fill(m_errors.begin(), m_errors.end(), 0);
+    std::fill(m_nextErrors.begin(), m_nextErrors.end(), 0);
+
+    cairo_surface_t *bandSurface = m_bandRender->GetCairoSurface();
+    for ( int bandTop = 0 ; bandTop < m_pixelHeight ; bandTop += m_bandHeight ){
+        if ( drawControl.IsAborted() ) return false;
+
+        // 页面没有对象时DrawPage()不绘制背景，先将条带清为白色。
+        cairo_surface_flush(bandSurface);
+        memset(cairo_image_surface_get_data(bandSurface), 0xff,
+                (size_t)cairo_image_surface_get_stride(bandSurface) * cairo_image_surface_get_height(bandSurface));
+        cairo_surface_mark_dirty(bandSurface);
+
+        // 设备坐标 = resolution / 72 * (scaling * 页面坐标 - pixel)，条带顶端对应设备行bandTop。
+        double bandPixelY = pixelY + bandTop * 72.0 / m_resolutionY;
+        m_bandRender->SaveState();
+        bool completed = m_bandRender->DrawPage(page, std::make_tuple(pixelX, bandPixelY, scaling), drawControl);
+        m_bandRender->RestoreState();
+        if ( !completed ) return false;
+
+        convertBand(bandTop, std::min(m_bandHeight, m_pixelHeight - bandTop));
+    }
+
+    return true;
+}
+
+// 将条带表面的前numRows行转换后写入目标表面的bandTop行起。
+void GrayRender::ImplCls::convertBand(int bandTop, int numRows){
+    cairo_surface_t *bandSurface = m_bandRender->GetCairoSurface();
+    cairo_surface_flush(bandSurface);
+    const uint8_t *bandData = cairo_image_surface_get_data(bandSurface);
+    int bandStride = cairo_image_surface_get_stride(bandSurface);
+    cairo_format_t bandFormat = cairo_image_surface_get_format(bandSurface);
+
+    cairo_surface_flush(m_surface);
+    uint8_t *data = cairo_image_surface_get_data(m_surface);
+    int stride = cairo_image_surface_get_stride(m_surface);
+
+    for ( int y = 0 ; y < numRows ; y++ ){
+        const uint8_t *src = bandData + (size_t)y * bandStride;
+        uint8_t *dst = data + (size_t)(bandTop + y) * stride;
+        if ( m_format == GrayFormat::Gray8 ){
+            ConvertSurfaceRow(src, bandFormat, m_pixelWidth, ImageColorMode::Gray, 0, dst);
+        } else {
+            ConvertSurfaceRow(src, bandFormat, m_pixelWidth, ImageColorMode::Gray, 0, m_grayRow.data());
+            memset(dst, 0, stride);
+            if ( m_monoMethod == MonoMethod::Dither ){
+                ditherRow(m_grayRow.data(), dst);
+            } else {
+                thresholdRow(m_grayRow.data(), dst);
+            }
+        }
+    }
+
+    cairo_surface_mark_dirty_rectangle(m_surface, 0, bandTop, m_pixelWidth, numRows);
+}
+
+void GrayRender::ImplCls::thresholdRow(const uint8_t *gray, uint8_t *dst){
+    for ( int x = 0 ; x < m_pixelWidth ; x++ ){
+        if ( gray[x] >= m_monoThreshold ){
+            setMonoPixel(dst, x);
+        }
+    }
+}
+
+// 误差按7/16、3/16、5/16、1/16扩散到右、左下、下、右下，跨条带延续。
+void GrayRender::ImplCls::ditherRow(const uint8_t *gray, uint8_t *dst){
+    int *errors = m_errors.data() + 1;
+    int *nextErrors = m_nextErrors.data() + 1;
+    for ( int x = 0 ; x < m_pixelWidth ; x++ ){
+        int value = gray[x] + errors[x];
+        int output = value >= m_monoThreshold ? 255 : 0;
+        if ( output != 0 ){
+            setMonoPixel(dst, x);
+        }
+        int error = value - output;
+        errors[x + 1] += error * 7 / 16;
+        nextErrors[x - 1] += error * 3 / 16;
+        nextErrors[x] += error * 5 / 16;
+        nextErrors[x + 1] += error / 16;
+    }
+    m_errors.swap(m_nextErrors);
+    std::fill(m_nextErrors.begin(), m_nextErrors.end(), 0);
+}
+
+// **************** class GrayRender ****************
+
+GrayRender::GrayRender(int pixelWidth, int pixelHeight, double resolutionX, double resolutionY,
+        GrayFormat format, int bandHeight) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(pixelWidth, pixelHeight, resolutionX, resolutionY, format, bandHeight))){
+}
+
+GrayRender::~GrayRender(){
+}
+
+bool GrayRender::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    return m_impl->DrawPage(page, visibleParams, drawControl);
+}
+
+cairo_surface_t *GrayRender::GetCairoSurface() const{
+    return m_impl->m_surface;
+}
+
+GrayFormat GrayRender::GetFormat() const{
+    return m_impl->m_format;
+}
+
+MonoMethod GrayRender::GetMonoMethod() const{
+    return m_impl->m_monoMethod;
+}
+
+void GrayRender::SetMonoMethod(MonoMethod monoMethod){
+    m_impl->m_monoMethod = monoMethod;
+}
+
+uint8_t GrayRender::GetMonoThreshold() const{
+    return m_impl->m_monoThreshold;
+}
+
+void GrayRender::SetMonoThreshold(uint8_t threshold){
+    m_impl->m_monoThreshold = threshold;
+}
+
+const DrawState& GrayRender::GetDrawState() const{
+    return m_impl->m_bandRender->GetDrawState();
+}
+
+DrawState& GrayRender::GetDrawState(){
+    return m_impl->m_bandRender->GetDrawState();
+}
+
+void GrayRender::SetRenderQuality(RenderQuality quality){
+    m_impl->m_bandRender->SetRenderQuality(quality);
+}
+
+bool GrayRender::WriteImage(const std::string &filename, const EncodeParams &params){
+    ImageEncoderPtr encoder = ImageEncoderFactory::CreateEncoder(params);
+    if ( encoder == nullptr ) return false;
+    return encoder->EncodeToFile(m_impl->m_surface, filename);
+}
@@ -1,156 +1,27 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <algorithm>
 #include <cairo/cairo.h>
 #include "ofd/Package.h"
 #include "ofd/Image.h"
+#include "ofd/ImageDecoder.h"
 #include "utils/logger.h"
 #include "utils/xml.h"
 
 using namespace ofd;
 
 namespace ofd{
-    std::string generateImageFileName(uint64_t imageID){
+    std::string generateImageFileName(uint64_t imageID, ImageFormat format){
         char buf[1024];
-        sprintf(buf, "Image_%" PRIu64 ".png", imageID);
+        const char *ext = format == ImageFormat::JPEG ? "jpg" : (format == ImageFormat::TIFF ? "tif" : "png");
+        sprintf(buf, "Image_%" PRIu64 ".%s", imageID, ext);
         LOG(DEBUG) << "------- generateImageFileName() imageID:" << imageID << " filename=" << std::string(buf);
         return std::string(buf);
     }
 }
 
 
-#include <png.h>
-// **************** class ofd::PNGStream ****************
-class PNGStream{
-
-    public:
-        PNGStream();
-        virtual ~PNGStream();
-
-        bool Open(const std::string pngFileName);
-        void Close();
-        void Reset();
-
-        inline int DoGetChars(int nChars, uint8_t *buffer);
-
-
-}; // class PNGStream
-
-class ImageSource {
-    public:
-        ImageSource(char *dataA, size_t dataSizeA) : data(dataA), dataSize(dataSizeA), offset(0){};
-
-        char *data;
-        size_t dataSize;
-        size_t offset;
-};
-
-static void pngReadCallback(png_structp png_ptr, png_byte *data, png_size_t length){
-    ImageSource *imageSource = (ImageSource*)png_get_io_ptr(png_ptr);
-    if ( imageSource->offset + length <= imageSource->dataSize ){
-        memcpy((void*)data, (void*)(imageSource->data + imageSource->offset), length);
-        imageSource->offset += length;
-    } else {
-        png_error(png_ptr, "pngReadCallback() failed.");
-    }
-}
-
-PNGStream::PNGStream(){
-}
-
-PNGStream::~PNGStream(){
-}
-
-void PNGStream::Reset(){
-}
-
-void PNGStream::Close(){
-}
-
-std::tuple<ImageDataHead, char*, size_t> LoadPNGData(char* data, size_t dataSize){
-    ImageDataHead imageDataHead;
-    char *imageData = nullptr;
-    size_t imageDataSize = 0; 
-
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
-    if ( png_ptr != 0 ){
-        png_infop info_ptr = png_create_info_struct(png_ptr);
-        if ( info_ptr != 0 ){
-            if ( setjmp(png_jmpbuf(png_ptr)) == 0 ){
-                ImageSource imageSource(data, dataSize);
-                
-                png_set_read_fn(png_ptr, (png_voidp)&imageSource, pngReadCallback);
-                png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND /*| PNG_TRANSFORM_STRIP_ALPHA*/, 0);
-                // 图像的色彩类型
-                int color_type = png_get_color_type(png_ptr, info_ptr);
-                // 图像的宽高
-                int w = png_get_image_width(png_ptr, info_ptr);
-                int h = png_get_image_height(png_ptr, info_ptr);
-                imageDataHead.Width = w;
-                imageDataHead.Height = h;
-                imageDataHead.Components = 4;
-                imageDataHead.Bits = 8;
-
-                imageDataSize = (size_t)w * (size_t)h * 4;
-                imageData = (char*)new char[imageDataSize];
-                size_t idx = 0;
-
-                // 获得图像的所有行像素数据
-                png_bytep *row_pointers = png_get_rows(png_ptr, info_ptr);
-                switch ( color_type ){
-                    case PNG_COLOR_TYPE_RGB_ALPHA:
-
-                        for ( int y = 0 ; y < h ; ++y ){
-                            for ( int x = 0 ; x < w * 4; ){
-                                __attribute__((unused)) uint8_t red = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t green = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t blue = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t alpha = row_pointers[y][x++];
-                                imageData[idx++] = red;
-                                imageData[idx++] = green;
-                                imageData[idx++] = blue;
-                                imageData[idx++] = alpha;
-                            }
-                        }
-                        break;
-
-                    case PNG_COLOR_TYPE_RGB:
-
-                        for ( int y = 0 ; y < h ; ++y ){
-                            for ( int x = 0 ; x < w * 3; ){
-                                __attribute__((unused)) uint8_t red = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t green = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t blue = row_pointers[y][x++];
-                                __attribute__((unused)) uint8_t alpha = 255;
-
-                                imageData[idx++] = red;
-                                imageData[idx++] = green;
-                                imageData[idx++] = blue;
-                                imageData[idx++] = alpha;
-                            }
-                        }
-                        break;
-
-                    default:
-                        break;
-
-                }; // switch ( color_type )
-
-            }
-            png_destroy_read_struct(&png_ptr, &info_ptr, 0);
-        } else {
-            png_destroy_read_struct(&png_ptr, 0, 0);
-        }
-    }
-
-    return std::make_tuple(imageDataHead, imageData, imageDataSize);
-}
-
-int PNGStream::DoGetChars(int nChars, uint8_t *buffer){
-    int dataSize = 0;
-    return dataSize;
-}
-
 // **************** class ofd::Image ****************
 
 static uint64_t IMAGE_ID = 1;
@@ -161,6 +32,7 @@ Image::Image():
     nComps(0), nBits(0), nVals(0),
     inputLineSize(0), inputLine(nullptr),
     imgLine(nullptr), imgIdx(0),
+    Format(ImageFormat::PNG),
     m_bLoaded(false), m_imageData(nullptr), m_imageDataSize(0){
 }
 
@@ -170,7 +42,8 @@ Image::Image(int widthA, int heightA, int nCompsA, int nBitsA) :
     nComps(nCompsA), nBits(nBitsA), nVals(0),
     inputLineSize(0), inputLine(nullptr),
     imgLine(nullptr), imgIdx(0),
-    m_bLoaded(false){
+    Format(ImageFormat::PNG),
+    m_bLoaded(false), m_imageData(nullptr), m_imageDataSize(0){
 
     int imgLineSize = 0;
     nVals = width * nComps;
@@ -203,13 +76,13 @@ Image::~Image(){
     delete inputLine;
 
     if ( m_imageData != nullptr ){
-        delete m_imageData;
+        delete[] m_imageData;
         m_imageData = nullptr;
     }
 }
 
 std::string Image::GenerateImageFileName(){
-    return generateImageFileName(ID);
+    return generateImageFileName(ID, Format);
 }
 
 bool Image::Load(PackagePtr package, bool reload){
@@ -224,20 +97,21 @@ bool Image::Load(PackagePtr package, bool reload){
     size_t imageDataSize = 0;
     bool readOK = false;
 
-    // FIXME
-    char *pngData = nullptr;
-    size_t pngDataSize = 0;
-    std::tie(pngData, pngDataSize, readOK) = package->ReadZipFileRaw(imageFilePath);
-    if ( pngDataSize > 0 ){
-        ImageDataHead imageDataHead;
-        std::tie(imageDataHead, imageData, imageDataSize) = LoadPNGData(pngData, pngDataSize);
-        if ( imageDataSize > 0 ){
-            width = imageDataHead.Width;
-            height = imageDataHead.Height;
-            nComps = imageDataHead.Components;
-            nBits = imageDataHead.Bits;
-            readOK = true;
+    // 保留压缩的图像文件，绘制时按需要的尺寸逐行解码。
+    std::tie(imageData, imageDataSize, readOK) = package->ReadZipFileRaw(imageFilePath);
+    if ( readOK ){
+        ImageHeader imageHeader;
+        if ( ReadImageHeader(imageData, imageDataSize, imageHeader) ){
+            Format = imageHeader.Format;
+            width = imageHeader.Width;
+            height = imageHeader.Height;
+            // 黑白图像解码为A1表面，每像素1位。
+            nComps = imageHeader.Bilevel ? 1 : 4;
+            nBits = imageHeader.Bilevel ? 1 : 8;
         } else {
+            LOG(ERROR) << "Unsupported image file " << imageFilePath;
+            delete[] imageData;
+            imageData = nullptr;
             readOK = false;
         }
     }
@@ -265,6 +139,9 @@ bool Image::Load(PackagePtr package, bool reload){
 
 
     if ( readOK ){
+        if ( m_imageData != nullptr ){
+            delete[] m_imageData;
+        }
         m_imageData = imageData;
         m_imageDataSize = imageDataSize;
         ok = true;
@@ -361,6 +238,11 @@ void Image::GenerateXML(utils::XMLWriter &writer) const{
     writer.StartElement("Image");{
         // -------- <Font ID="">
         writer.WriteAttribute("ID", ID);
+        // -------- <Image Format="">
+        // 与MultiMedia的Format一致，取PNG、JPEG或TIFF。
+        std::string strFormat = ImageFormatToString(Format);
+        std::transform(strFormat.begin(), strFormat.end(), strFormat.begin(), ::toupper);
+        writer.WriteAttribute("Format", strFormat);
     }; writer.EndElement();
 
 }
@@ -380,9 +262,19 @@ bool Image::FromXML(utils::XMLElementPtr imageElement){
         // Required.
         std::tie(ID, exist) = imageElement->GetIntAttribute("ID");
         if ( exist ){
-            // -------- <Image ="">
-            // Required.
-
+            // -------- <Image Format="">
+            // Optional. 缺省为PNG。
+            std::string strFormat;
+            bool formatExist = false;
+            std::tie(strFormat, formatExist) = imageElement->GetStringAttribute("Format");
+            Format = ImageFormat::PNG;
+            if ( formatExist ){
+                std::transform(strFormat.begin(), strFormat.end(), strFormat.begin(), ::tolower);
+                if ( !ImageFormatFromString(strFormat, Format) || Format == ImageFormat::PNM ){
+                    LOG(WARNING) << "Unsupported image format " << strFormat << " in Image XML.";
+                    Format = ImageFormat::PNG;
+                }
+            }
         } else {
             LOG(ERROR) << "Attribute ID is required in Image XML.";
         }
@@ -0,0 +1,286 @@
+#include <assert.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include "ofd/ImageCache.h"
+#include "ofd/Image.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 最多生成的mip级别数。
+#define IMAGE_CACHE_MAX_LEVELS 16
+
+// 将ARGB32/RGB24图像表面按2x2盒式滤波缩小一半。
+// 预乘后的像素逐通道求平均，结果仍保持预乘。
+static cairo_surface_t *halveImageSurface(cairo_surface_t *src){
+    cairo_format_t format = cairo_image_surface_get_format(src);
+    if ( format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24 ){
+        return nullptr;
+    }
+
+    cairo_surface_flush(src);
+    int srcWidth = cairo_image_surface_get_width(src);
+    int srcHeight = cairo_image_surface_get_height(src);
+    int srcStride = cairo_image_surface_get_stride(src);
+    const uint8_t *srcData = cairo_image_surface_get_data(src);
+
+    int dstWidth = std::max(1, (srcWidth + 1) / 2);
+    int dstHeight = std::max(1, (srcHeight + 1) / 2);
+    cairo_surface_t *dst = cairo_image_surface_create(format, dstWidth, dstHeight);
+    if ( cairo_surface_status(dst) != CAIRO_STATUS_SUCCESS ){
+        cairo_surface_destroy(dst);
+        return nullptr;
+    }
+    int dstStride = cairo_image_surface_get_stride(dst);
+    uint8_t *dstData = cairo_image_surface_get_data(dst);
+
+    for ( int y = 0 ; y < dstHeight ; y++ ){
+        int y0 = std::min(2 * y, srcHeight - 1);
+        int y1 = std::min(y0 + 1, srcHeight - 1);
+        const uint32_t *row0 = (const uint32_t*)(srcData + y0 * srcStride);
+        const uint32_t *row1 = (const uint32_t*)(srcData + y1 * srcStride);
+        uint32_t *dstRow = (uint32_t*)(dstData + y * dstStride);
+        for ( int x = 0 ; x < dstWidth ; x++ ){
+            int x0 = std::min(2 * x, srcWidth - 1);
+            int x1 = std::min(x0 + 1, srcWidth - 1);
+            uint32_t p0 = row0[x0], p1 = row0[x1], p2 = row1[x0], p3 = row1[x1];
+            uint32_t pixel = 0;
+            for ( int shift = 0 ; shift < 32 ; shift += 8 ){
+                uint32_t sum = ((p0 >> shift) & 0xff) + ((p1 >> shift) & 0xff) +
+                               ((p2 >> shift) & 0xff) + ((p3 >> shift) & 0xff);
+                pixel |= ((sum + 2) >> 2) << shift;
+            }
+            dstRow[x] = pixel;
+        }
+    }
+    cairo_surface_mark_dirty(dst);
+
+    return dst;
+}
+
+static size_t getSurfaceBytes(cairo_surface_t *surface){
+    return (size_t)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+}
+
+// **************** class ImageCache::ImplCls ****************
+
+class ImageCache::ImplCls {
+public:
+    ImplCls(size_t maxBytes);
+    ~ImplCls();
+
+    cairo_surface_t *GetSurface(ImagePtr image, int scaledWidth, int scaledHeight, ImageDecodeFunc decodeFunc);
+    void RemoveImage(uint64_t imageID);
+    void Clear();
+    void SetMaxBytes(size_t maxBytes);
+
+private:
+    typedef std::pair<uint64_t, int> Key;
+    typedef std::list<Key> KeyList;
+
+    typedef struct Entry{
+        cairo_surface_t *Surface;
+        size_t Bytes;
+        KeyList::iterator LRUPos;
+    } Entry_t;
+    typedef std::map<Key, Entry> EntryMap;
+
+    cairo_surface_t *lookup(const Key &key);
+    cairo_surface_t *insert(const Key &key, cairo_surface_t *surface);
+    void evict();
+    void erase(EntryMap::iterator it);
+
+public:
+    mutable std::mutex m_mutex;
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+
+private:
+    EntryMap m_entries;
+    KeyList m_lru;
+
+}; // class ImageCache::ImplCls
+
+ImageCache::ImplCls::ImplCls(size_t maxBytes) :
+    m_maxBytes(maxBytes), m_usedBytes(0){
+}
+
+ImageCache::ImplCls::~ImplCls(){
+    Clear();
+}
+
+// ======== ImageCache::ImplCls::GetSurface() ========
+cairo_surface_t *ImageCache::ImplCls::GetSurface(ImagePtr image, int scaledWidth, int scaledHeight, ImageDecodeFunc decodeFunc){
+    if ( image == nullptr ) return nullptr;
+
+    // -------- 选择mip级别 --------
+    // 黑白图像按原尺寸解码为A1表面，由cairo缩放绘制，只缓存一个级别。
+    int levelWidth = image->width;
+    int levelHeight = image->height;
+    int level = 0;
+    while ( image->nBits > 1 && level < IMAGE_CACHE_MAX_LEVELS ){
+        int nextWidth = std::max(1, (levelWidth + 1) / 2);
+        int nextHeight = std::max(1, (levelHeight + 1) / 2);
+        if ( nextWidth < scaledWidth || nextHeight < scaledHeight ) break;
+        if ( nextWidth == levelWidth && nextHeight == levelHeight ) break;
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+        level++;
+    }
+
+    Key key = std::make_pair(image->ID, level);
+
+    // -------- 命中缓存，或由已缓存的更高分辨率级别逐级减半生成 --------
+    cairo_surface_t *finer = nullptr;
+    int finerLevel = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cairo_surface_t *surface = lookup(key);
+        if ( surface != nullptr ){
+            return surface;
+        }
+        for ( int l = level - 1 ; l >= 0 ; l-- ){
+            finer = lookup(std::make_pair(image->ID, l));
+            if ( finer != nullptr ){
+                finerLevel = l;
+                break;
+            }
+        }
+    }
+
+    cairo_surface_t *surface = nullptr;
+    if ( finer != nullptr ){
+        surface = cairo_surface_reference(finer);
+        for ( int l = finerLevel ; l < level && surface != nullptr ; l++ ){
+            cairo_surface_t *halved = halveImageSurface(surface);
+            cairo_surface_destroy(surface);
+            surface = halved;
+        }
+        cairo_surface_destroy(finer);
+    }
+
+    // -------- 解码 --------
+    if ( surface == nullptr ){
+        if ( !decodeFunc ) return nullptr;
+        surface = decodeFunc(image, levelWidth, levelHeight);
+        if ( surface == nullptr ) return nullptr;
+        if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+            LOG(ERROR) << "Decode image surface failed. ImageID=" << image->ID
+                << " Cairo status: " << cairo_status_to_string(cairo_surface_status(surface));
+            cairo_surface_destroy(surface);
+            return nullptr;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return insert(key, surface);
+}
+
+// 调用者需持有m_mutex。命中时返回增加了引用计数的表面。
+cairo_surface_t *ImageCache::ImplCls::lookup(const Key &key){
+    auto it = m_entries.find(key);
+    if ( it == m_entries.end() ) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.LRUPos);
+    return cairo_surface_reference(it->second.Surface);
+}
+
+// 调用者需持有m_mutex。接管surface的引用，返回增加了引用计数的表面。
+cairo_surface_t *ImageCache::ImplCls::insert(const Key &key, cairo_surface_t *surface){
+    auto it = m_entries.find(key);
+    if ( it != m_entries.end() ){
+        // 其他线程已先行解码。
+        cairo_surface_destroy(surface);
+        m_lru.splice(m_lru.begin(), m_lru, it->second.LRUPos);
+        return cairo_surface_reference(it->second.Surface);
+    }
+
+    m_lru.push_front(key);
+    Entry entry;
+    entry.Surface = surface;
+    entry.Bytes = getSurfaceBytes(surface);
+    entry.LRUPos = m_lru.begin();
+    m_entries.insert(EntryMap::value_type(key, entry));
+    m_usedBytes += entry.Bytes;
+
+    evict();
+
+    return cairo_surface_reference(surface);
+}
+
+void ImageCache::ImplCls::evict(){
+    // 至少保留最近使用的一项。
+    while ( m_usedBytes > m_maxBytes && m_lru.size() > 1 ){
+        auto it = m_entries.find(m_lru.back());
+        assert(it != m_entries.end());
+        erase(it);
+    }
+}
+
+void ImageCache::ImplCls::erase(EntryMap::iterator it){
+    m_usedBytes -= it->second.Bytes;
+    m_lru.erase(it->second.LRUPos);
+    cairo_surface_destroy(it->second.Surface);
+    m_entries.erase(it);
+}
+
+void ImageCache::ImplCls::RemoveImage(uint64_t imageID){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.lower_bound(std::make_pair(imageID, 0));
+    while ( it != m_entries.end() && it->first.first == imageID ){
+        auto cur = it++;
+        erase(cur);
+    }
+}
+
+void ImageCache::ImplCls::Clear(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for ( auto &kv : m_entries ){
+        cairo_surface_destroy(kv.second.Surface);
+    }
+    m_entries.clear();
+    m_lru.clear();
+    m_usedBytes = 0;
+}
+
+void ImageCache::ImplCls::SetMaxBytes(size_t maxBytes){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+// **************** class ImageCache ****************
+
+ImageCache::ImageCache(size_t maxBytes) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(maxBytes))){
+}
+
+ImageCache::~ImageCache(){
+}
+
+cairo_surface_t *ImageCache::GetSurface(ImagePtr image, int scaledWidth, int scaledHeight, ImageDecodeFunc decodeFunc){
+    return m_impl->GetSurface(image, scaledWidth, scaledHeight, decodeFunc);
+}
+
+void ImageCache::RemoveImage(uint64_t imageID){
+    m_impl->RemoveImage(imageID);
+}
+
+void ImageCache::Clear(){
+    m_impl->Clear();
+}
+
+size_t ImageCache::GetMaxBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_maxBytes;
+}
+
+void ImageCache::SetMaxBytes(size_t maxBytes){
+    m_impl->SetMaxBytes(maxBytes);
+}
+
+size_t ImageCache::GetUsedBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_usedBytes;
+}
@@ -0,0 +1,762 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include <algorithm>
+#include <vector>
+#include <png.h>
+#include <jpeglib.h>
+#include <tiffio.h>
+#include <cairo/cairo.h>
+#include "CairoRescaleBox.h"
+#include "ofd/ImageDecoder.h"
+#include "ofd/ColorConvert.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+static const uint8_t PNGSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+
+static bool isPNGData(const char *data, size_t dataSize){
+    return dataSize >= sizeof(PNGSignature) && memcmp(data, PNGSignature, sizeof(PNGSignature)) == 0;
+}
+
+static bool isJPEGData(const char *data, size_t dataSize){
+    return dataSize >= 3 && (uint8_t)data[0] == 0xFF && (uint8_t)data[1] == 0xD8 && (uint8_t)data[2] == 0xFF;
+}
+
+static bool isTIFFData(const char *data, size_t dataSize){
+    return dataSize >= 4 && (memcmp(data, "II*\0", 4) == 0 || memcmp(data, "MM\0*", 4) == 0);
+}
+
+// 高位在前的1位像素行转换为cairo A1表面的行，1为黑色。
+// cairo的A1格式按32位字存放，位序与平台字节序一致。
+static void packBilevelRow(const uint8_t *src, int width, bool blackIs1, uint8_t *dst){
+    int numBytes = (width + 7) / 8;
+    uint8_t flip = blackIs1 ? 0x00 : 0xff;
+    for ( int i = 0 ; i < numBytes ; i++ ){
+        uint8_t b = src[i] ^ flip;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+        b = (uint8_t)(((b * 0x0802LU & 0x22110LU) | (b * 0x8020LU & 0x88440LU)) * 0x10101LU >> 16);
+#endif
+        dst[i] = b;
+    }
+    // 清除行尾多余的位。
+    int tailBits = width & 7;
+    if ( tailBits != 0 ){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        dst[numBytes - 1] &= (uint8_t)(0xff << (8 - tailBits));
+#else
+        dst[numBytes - 1] &= (uint8_t)((1 << tailBits) - 1);
+#endif
+    }
+}
+
+static cairo_surface_t *createBilevelSurface(int width, int height){
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A1, width, height);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "Create image surface failed. Cairo status: " << cairo_status_to_string(cairo_surface_status(surface));
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+    return surface;
+}
+
+// **************** class PNGDecoder ****************
+// 基于libpng逐行解码。调色板、低位深灰度、16位和tRNS由libpng展开，
+// 每行输出4字节像素，直接读入cairo表面的行缓冲区，有alpha时就地预乘。
+// 缩小时作为CairoRescaleBox的行来源，解码一行缩放一行。
+// 无透明度的1位灰度图像不做变换，解码为A1表面。
+
+class PNGDecoder : public CairoRescaleBox {
+public:
+    PNGDecoder(const char *data, size_t dataSize);
+    virtual ~PNGDecoder();
+
+    bool ReadHeader();
+    cairo_surface_t *Decode(int scaledWidth, int scaledHeight);
+
+    int GetWidth() const {return m_width;};
+    int GetHeight() const {return m_height;};
+    bool HasAlpha() const {return m_hasAlpha;};
+    bool IsBilevel() const {return m_bilevel;};
+
+    // CairoRescaleBox按行号递增的顺序读取。
+    virtual void getRow(int row_num, uint32_t *row_data);
+
+private:
+    static void readData(png_structp png, png_bytep data, png_size_t length);
+    static void errorHandler(png_structp png, png_const_charp message);
+    static void warningHandler(png_structp png, png_const_charp message);
+
+    void readRow(uint32_t *row);
+    bool readInterlaced(cairo_surface_t *surface);
+    cairo_surface_t *decodeBilevel();
+    cairo_surface_t *createSurface(int width, int height) const;
+
+    const uint8_t *m_data;
+    size_t m_dataSize;
+    size_t m_offset;
+
+    png_structp m_png;
+    png_infop m_info;
+    int m_width;
+    int m_height;
+    bool m_hasAlpha;
+    bool m_interlaced;
+    bool m_bilevel;
+    int m_currentRow;
+    bool m_error;
+    std::vector<png_bytep> m_rows;
+
+}; // class PNGDecoder
+
+PNGDecoder::PNGDecoder(const char *data, size_t dataSize) :
+    m_data((const uint8_t*)data), m_dataSize(dataSize), m_offset(0),
+    m_png(nullptr), m_info(nullptr),
+    m_width(0), m_height(0), m_hasAlpha(false), m_interlaced(false), m_bilevel(false),
+    m_currentRow(-1), m_error(false){
+}
+
+PNGDecoder::~PNGDecoder(){
+    if ( m_png != nullptr ){
+        png_destroy_read_struct(&m_png, m_info != nullptr ? &m_info : nullptr, nullptr);
+    }
+}
+
+void PNGDecoder::readData(png_structp png, png_bytep data, png_size_t length){
+    PNGDecoder *decoder = (PNGDecoder*)png_get_io_ptr(png);
+    if ( length > decoder->m_dataSize - decoder->m_offset ){
+        png_error(png, "Unexpected end of PNG data.");
+    }
+    memcpy(data, decoder->m_data + decoder->m_offset, length);
+    decoder->m_offset += length;
+}
+
+void PNGDecoder::errorHandler(png_structp png, png_const_charp message){
+    LOG(WARNING) << "libpng error: " << message;
+    longjmp(png_jmpbuf(png), 1);
+}
+
+void PNGDecoder::warningHandler(png_structp, png_const_charp){
+}
+
+// ======== PNGDecoder::ReadHeader() ========
+// 读取文件头并设置输出变换，之后每行为width个4字节像素（黑白图像为1位）。
+bool PNGDecoder::ReadHeader(){
+    m_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, this, errorHandler, warningHandler);
+    if ( m_png == nullptr ) return false;
+    m_info = png_create_info_struct(m_png);
+    if ( m_info == nullptr ) return false;
+
+    if ( setjmp(png_jmpbuf(m_png)) != 0 ){
+        return false;
+    }
+    png_set_read_fn(m_png, this, readData);
+    png_read_info(m_png, m_info);
+
+    png_uint_32 width = png_get_image_width(m_png, m_info);
+    png_uint_32 height = png_get_image_height(m_png, m_info);
+    int colorType = png_get_color_type(m_png, m_info);
+    int bitDepth = png_get_bit_depth(m_png, m_info);
+    if ( width == 0 || height == 0 || width > 32767 || height > 32767 ){
+        LOG(WARNING) << "Unsupported PNG size " << width << "x" << height;
+        return false;
+    }
+    m_width = (int)width;
+    m_height = (int)height;
+    m_interlaced = png_get_interlace_type(m_png, m_info) != PNG_INTERLACE_NONE;
+
+    if ( colorType == PNG_COLOR_TYPE_GRAY && bitDepth == 1 && !png_get_valid(m_png, m_info, PNG_INFO_tRNS) ){
+        m_bilevel = true;
+        if ( m_interlaced ){
+            png_set_interlace_handling(m_png);
+        }
+        png_read_update_info(m_png, m_info);
+        return png_get_rowbytes(m_png, m_info) == (size_t)(m_width + 7) / 8;
+    }
+
+    if ( colorType == PNG_COLOR_TYPE_PALETTE ){
+        png_set_palette_to_rgb(m_png);
+    }
+    if ( colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8 ){
+        png_set_expand_gray_1_2_4_to_8(m_png);
+    }
+    if ( png_get_valid(m_png, m_info, PNG_INFO_tRNS) ){
+        png_set_tRNS_to_alpha(m_png);
+        m_hasAlpha = true;
+    }
+    if ( bitDepth == 16 ){
+#if PNG_LIBPNG_VER >= 10504
+        png_set_scale_16(m_png);
+#else
+        png_set_strip_16(m_png);
+#endif
+    }
+    if ( colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA ){
+        png_set_gray_to_rgb(m_png);
+    }
+    if ( colorType & PNG_COLOR_MASK_ALPHA ){
+        m_hasAlpha = true;
+    } else if ( !m_hasAlpha ){
+        png_set_filler(m_png, 0xff, PNG_FILLER_AFTER);
+    }
+    // 像素按32位整数为A<<24 | B<<16 | G<<8 | R。
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    png_set_bgr(m_png);
+    png_set_swap_alpha(m_png);
+#endif
+    if ( m_interlaced ){
+        png_set_interlace_handling(m_png);
+    }
+    png_read_update_info(m_png, m_info);
+
+    if ( png_get_rowbytes(m_png, m_info) != (size_t)m_width * 4 ){
+        LOG(WARNING) << "Unexpected PNG row size " << png_get_rowbytes(m_png, m_info);
+        return false;
+    }
+    return true;
+}
+
+void PNGDecoder::readRow(uint32_t *row){
+    if ( m_error ){
+        memset(row, 0, (size_t)m_width * 4);
+        return;
+    }
+    if ( setjmp(png_jmpbuf(m_png)) != 0 ){
+        m_error = true;
+        memset(row, 0, (size_t)m_width * 4);
+        return;
+    }
+    png_read_row(m_png, (png_bytep)row, nullptr);
+}
+
+void PNGDecoder::getRow(int row_num, uint32_t *row_data){
+    if ( row_num <= m_currentRow ) return;
+
+    while ( m_currentRow < row_num ){
+        readRow(row_data);
+        m_currentRow++;
+    }
+    if ( m_hasAlpha ){
+        PremultiplyARGB32(row_data, m_width);
+    }
+}
+
+// 隔行扫描的PNG需要各遍扫描叠加到整幅图像上。
+bool PNGDecoder::readInterlaced(cairo_surface_t *surface){
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    m_rows.resize(m_height);
+    for ( int y = 0 ; y < m_height ; y++ ){
+        m_rows[y] = data + (size_t)y * stride;
+    }
+    if ( setjmp(png_jmpbuf(m_png)) != 0 ){
+        return false;
+    }
+    png_read_image(m_png, m_rows.data());
+    return true;
+}
+
+cairo_surface_t *PNGDecoder::createSurface(int width, int height) const{
+    cairo_surface_t *surface = cairo_image_surface_create(m_hasAlpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24, width, height);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "Create image surface failed. Cairo status: " << cairo_status_to_string(cairo_surface_status(surface));
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+    return surface;
+}
+
+// 1位图像整幅读入后转换，数据量只有A1表面大小。
+cairo_surface_t *PNGDecoder::decodeBilevel(){
+    cairo_surface_t *surface = createBilevelSurface(m_width, m_height);
+    if ( surface == nullptr ) return nullptr;
+
+    size_t rowBytes = (size_t)(m_width + 7) / 8;
+    std::vector<uint8_t> pixels(rowBytes * m_height, 0xff);
+    m_rows.resize(m_height);
+    for ( int y = 0 ; y < m_height ; y++ ){
+        m_rows[y] = pixels.data() + rowBytes * y;
+    }
+    if ( setjmp(png_jmpbuf(m_png)) != 0 ){
+        m_error = true;
+    } else {
+        png_read_image(m_png, m_rows.data());
+    }
+    if ( m_error ){
+        LOG(WARNING) << "Bad PNG image data.";
+    }
+
+    // PNG灰度0为黑色。
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    for ( int y = 0 ; y < m_height ; y++ ){
+        packBilevelRow(m_rows[y], m_width, false, data + (size_t)y * stride);
+    }
+    cairo_surface_mark_dirty(surface);
+
+    return surface;
+}
+
+// ======== PNGDecoder::Decode() ========
+cairo_surface_t *PNGDecoder::Decode(int scaledWidth, int scaledHeight){
+    if ( m_bilevel ) return decodeBilevel();
+
+    bool downScale = scaledWidth > 0 && scaledHeight > 0 && scaledWidth < m_width && scaledHeight < m_height;
+
+    cairo_surface_t *surface = nullptr;
+    if ( downScale && !m_interlaced ){
+        surface = createSurface(scaledWidth, scaledHeight);
+        if ( surface == nullptr ) return nullptr;
+        downScaleImage(m_width, m_height, scaledWidth, scaledHeight, 0, 0, scaledWidth, scaledHeight, surface);
+    } else {
+        surface = createSurface(m_width, m_height);
+        if ( surface == nullptr ) return nullptr;
+        uint8_t *data = cairo_image_surface_get_data(surface);
+        int stride = cairo_image_surface_get_stride(surface);
+        if ( m_interlaced ){
+            m_error = !readInterlaced(surface);
+            if ( m_hasAlpha ){
+                for ( int y = 0 ; y < m_height ; y++ ){
+                    PremultiplyARGB32((uint32_t*)(data + (size_t)y * stride), m_width);
+                }
+            }
+        } else {
+            for ( int y = 0 ; y < m_height ; y++ ){
+                getRow(y, (uint32_t*)(data + (size_t)y * stride));
+            }
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    if ( m_error ){
+        LOG(WARNING) << "Bad PNG image data.";
+    }
+
+    // 隔行扫描的图像先按原尺寸解码再缩小。
+    if ( downScale && m_interlaced ){
+        cairo_surface_t *scaledSurface = createSurface(scaledWidth, scaledHeight);
+        if ( scaledSurface != nullptr ){
+            cairo_t *cr = cairo_create(scaledSurface);
+            cairo_scale(cr, (double)scaledWidth / m_width, (double)scaledHeight / m_height);
+            cairo_set_source_surface(cr, surface, 0, 0);
+            cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+            cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+            cairo_paint(cr);
+            cairo_destroy(cr);
+        }
+        cairo_surface_destroy(surface);
+        surface = scaledSurface;
+    }
+
+    return surface;
+}
+
+// **************** class JPEGDecoder ****************
+// 基于libjpeg（libjpeg-turbo）。缩小时先由DCT缩放（scale_num/8）解码到不小于目标的尺寸，
+// 其余的缩小由CairoRescaleBox逐行完成。
+// libjpeg-turbo支持JCS_EXT_RGBX时直接解码到表面的行，否则经一行缓冲转换。
+
+#if defined(JCS_EXTENSIONS) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JPEG_DIRECT_RGBX 1
+#endif
+
+typedef struct JPEGErrorManager{
+    struct jpeg_error_mgr Pub;
+    jmp_buf SetjmpBuffer;
+} JPEGErrorManager_t;
+
+static void jpegErrorExit(j_common_ptr cinfo){
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    LOG(WARNING) << "libjpeg error: " << message;
+    longjmp(((JPEGErrorManager*)cinfo->err)->SetjmpBuffer, 1);
+}
+
+static void jpegOutputMessage(j_common_ptr){
+}
+
+class JPEGDecoder : public CairoRescaleBox {
+public:
+    JPEGDecoder(const char *data, size_t dataSize);
+    virtual ~JPEGDecoder();
+
+    bool ReadHeader();
+    cairo_surface_t *Decode(int scaledWidth, int scaledHeight);
+
+    int GetWidth() const {return m_width;};
+    int GetHeight() const {return m_height;};
+
+    virtual void getRow(int row_num, uint32_t *row_data);
+
+private:
+    bool startDecompress(int scaledWidth, int scaledHeight);
+    void readRow(uint32_t *row);
+
+    const char *m_data;
+    size_t m_dataSize;
+
+    struct jpeg_decompress_struct m_cinfo;
+    JPEGErrorManager m_jerr;
+    bool m_created;
+    int m_width;
+    int m_height;
+    int m_outputWidth;  // DCT缩放后的尺寸
+    int m_outputHeight;
+    bool m_direct;
+    int m_currentRow;
+    bool m_error;
+    std::vector<uint8_t> m_row;
+
+}; // class JPEGDecoder
+
+JPEGDecoder::JPEGDecoder(const char *data, size_t dataSize) :
+    m_data(data), m_dataSize(dataSize), m_created(false),
+    m_width(0), m_height(0), m_outputWidth(0), m_outputHeight(0),
+    m_direct(false), m_currentRow(-1), m_error(false){
+    memset(&m_cinfo, 0, sizeof(m_cinfo));
+}
+
+JPEGDecoder::~JPEGDecoder(){
+    if ( m_created ){
+        jpeg_destroy_decompress(&m_cinfo);
+    }
+}
+
+// ======== JPEGDecoder::ReadHeader() ========
+bool JPEGDecoder::ReadHeader(){
+    m_cinfo.err = jpeg_std_error(&m_jerr.Pub);
+    m_jerr.Pub.error_exit = jpegErrorExit;
+    m_jerr.Pub.output_message = jpegOutputMessage;
+    if ( setjmp(m_jerr.SetjmpBuffer) ){
+        return false;
+    }
+    jpeg_create_decompress(&m_cinfo);
+    m_created = true;
+
+    jpeg_mem_src(&m_cinfo, (unsigned char*)m_data, (unsigned long)m_dataSize);
+    jpeg_read_header(&m_cinfo, TRUE);
+
+    if ( m_cinfo.image_width == 0 || m_cinfo.image_height == 0 ||
+            m_cinfo.image_width > 32767 || m_cinfo.image_height > 32767 ){
+        LOG(WARNING) << "Unsupported JPEG size " << m_cinfo.image_width << "x" << m_cinfo.image_height;
+        return false;
+    }
+    m_width = (int)m_cinfo.image_width;
+    m_height = (int)m_cinfo.image_height;
+    return true;
+}
+
+bool JPEGDecoder::startDecompress(int scaledWidth, int scaledHeight){
+    if ( setjmp(m_jerr.SetjmpBuffer) ){
+        return false;
+    }
+
+    // 取输出不小于目标尺寸的最小DCT缩放比例。
+    if ( scaledWidth > 0 && scaledHeight > 0 && scaledWidth < m_width && scaledHeight < m_height ){
+        int numX = (int)(((int64_t)scaledWidth * 8 + m_width - 1) / m_width);
+        int numY = (int)(((int64_t)scaledHeight * 8 + m_height - 1) / m_height);
+        m_cinfo.scale_num = std::min(8, std::max(1, std::max(numX, numY)));
+        m_cinfo.scale_denom = 8;
+    }
+
+    int numComponents = 3;
+    if ( m_cinfo.jpeg_color_space == JCS_CMYK || m_cinfo.jpeg_color_space == JCS_YCCK ){
+        m_cinfo.out_color_space = JCS_CMYK;
+        numComponents = 4;
+    } else {
+#ifdef JPEG_DIRECT_RGBX
+        m_cinfo.out_color_space = JCS_EXT_RGBX;
+        m_direct = true;
+#else
+        if ( m_cinfo.jpeg_color_space == JCS_GRAYSCALE ){
+            m_cinfo.out_color_space = JCS_GRAYSCALE;
+            numComponents = 1;
+        } else {
+            m_cinfo.out_color_space = JCS_RGB;
+        }
+#endif
+    }
+    jpeg_start_decompress(&m_cinfo);
+
+    m_outputWidth = (int)m_cinfo.output_width;
+    m_outputHeight = (int)m_cinfo.output_height;
+    if ( !m_direct ){
+        m_row.resize((size_t)m_outputWidth * numComponents);
+    }
+    return true;
+}
+
+void JPEGDecoder::readRow(uint32_t *row){
+    if ( m_error || (int)m_cinfo.output_scanline >= m_outputHeight ){
+        memset(row, 0, (size_t)m_outputWidth * 4);
+        return;
+    }
+    if ( setjmp(m_jerr.SetjmpBuffer) ){
+        m_error = true;
+        memset(row, 0, (size_t)m_outputWidth * 4);
+        return;
+    }
+
+    JSAMPROW rowPointer = m_direct ? (JSAMPROW)row : m_row.data();
+    jpeg_read_scanlines(&m_cinfo, &rowPointer, 1);
+    if ( m_direct ) return;
+
+    const uint8_t *src = m_row.data();
+    if ( m_cinfo.out_color_space == JCS_GRAYSCALE ){
+        ConvertGrayToARGB32(src, row, m_outputWidth);
+    } else if ( m_cinfo.out_color_space == JCS_CMYK ){
+        // Adobe的CMYK JPEG按反相存放，先按位取反再转换。
+        if ( m_cinfo.saw_Adobe_marker ){
+            size_t numBytes = (size_t)m_outputWidth * 4;
+            for ( size_t i = 0 ; i < numBytes ; i++ ){
+                m_row[i] ^= 0xff;
+            }
+        }
+        ConvertCMYKToARGB32(src, row, m_outputWidth);
+    } else {
+        ConvertRGBToARGB32(src, row, m_outputWidth);
+    }
+}
+
+void JPEGDecoder::getRow(int row_num, uint32_t *row_data){
+    if ( row_num <= m_currentRow ) return;
+
+    while ( m_currentRow < row_num ){
+        readRow(row_data);
+        m_currentRow++;
+    }
+}
+
+// ======== JPEGDecoder::Decode() ========
+cairo_surface_t *JPEGDecoder::Decode(int scaledWidth, int scaledHeight){
+    if ( !startDecompress(scaledWidth, scaledHeight) ) return nullptr;
+
+    bool downScale = scaledWidth > 0 && scaledHeight > 0 &&
+        scaledWidth < m_width && scaledHeight < m_height &&
+        (scaledWidth < m_outputWidth || scaledHeight < m_outputHeight);
+    int width = downScale ? scaledWidth : m_outputWidth;
+    int height = downScale ? scaledHeight : m_outputHeight;
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "Create image surface failed. Cairo status: " << cairo_status_to_string(cairo_surface_status(surface));
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+    if ( downScale ){
+        downScaleImage(m_outputWidth, m_outputHeight, scaledWidth, scaledHeight, 0, 0, scaledWidth, scaledHeight, surface);
+    } else {
+        uint8_t *data = cairo_image_surface_get_data(surface);
+        int stride = cairo_image_surface_get_stride(surface);
+        for ( int y = 0 ; y < height ; y++ ){
+            getRow(y, (uint32_t*)(data + (size_t)y * stride));
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    if ( m_error ){
+        LOG(WARNING) << "Bad JPEG image data.";
+    }
+
+    return surface;
+}
+
+// **************** class TIFFDecoder ****************
+// 基于libtiff，只支持1位黑白图像（如原样封装的CCITT G4数据），解码为A1表面。
+
+typedef struct TIFFInput{
+    const uint8_t *Data;
+    toff_t Size;
+    toff_t Pos;
+} TIFFInput_t;
+
+static tsize_t tiffRead(thandle_t handle, tdata_t buf, tsize_t size){
+    TIFFInput *memory = (TIFFInput*)handle;
+    if ( memory->Pos >= memory->Size ) return 0;
+    toff_t length = std::min((toff_t)size, memory->Size - memory->Pos);
+    memcpy(buf, memory->Data + memory->Pos, length);
+    memory->Pos += length;
+    return (tsize_t)length;
+}
+
+static tsize_t tiffWrite(thandle_t, tdata_t, tsize_t){
+    return 0;
+}
+
+static toff_t tiffSeek(thandle_t handle, toff_t offset, int whence){
+    TIFFInput *memory = (TIFFInput*)handle;
+    if ( whence == SEEK_SET ){
+        memory->Pos = offset;
+    } else if ( whence == SEEK_CUR ){
+        memory->Pos += offset;
+    } else if ( whence == SEEK_END ){
+        memory->Pos = memory->Size + offset;
+    }
+    return memory->Pos;
+}
+
+static int tiffClose(thandle_t){
+    return 0;
+}
+
+static toff_t tiffSize(thandle_t handle){
+    return ((TIFFInput*)handle)->Size;
+}
+
+static int tiffMap(thandle_t, tdata_t*, toff_t*){
+    return 0;
+}
+
+static void tiffUnmap(thandle_t, tdata_t, toff_t){
+}
+
+class TIFFDecoder {
+public:
+    TIFFDecoder(const char *data, size_t dataSize);
+    ~TIFFDecoder();
+
+    bool ReadHeader();
+    cairo_surface_t *Decode();
+
+    int GetWidth() const {return m_width;};
+    int GetHeight() const {return m_height;};
+
+private:
+    TIFFInput m_memory;
+    TIFF *m_tif;
+    int m_width;
+    int m_height;
+    bool m_blackIs1;
+
+}; // class TIFFDecoder
+
+TIFFDecoder::TIFFDecoder(const char *data, size_t dataSize) :
+    m_tif(nullptr), m_width(0), m_height(0), m_blackIs1(true){
+    m_memory.Data = (const uint8_t*)data;
+    m_memory.Size = dataSize;
+    m_memory.Pos = 0;
+}
+
+TIFFDecoder::~TIFFDecoder(){
+    if ( m_tif != nullptr ){
+        TIFFClose(m_tif);
+    }
+}
+
+// ======== TIFFDecoder::ReadHeader() ========
+bool TIFFDecoder::ReadHeader(){
+    m_tif = TIFFClientOpen("ofd", "rm", (thandle_t)&m_memory,
+            tiffRead, tiffWrite, tiffSeek, tiffClose, tiffSize, tiffMap, tiffUnmap);
+    if ( m_tif == nullptr ){
+        LOG(WARNING) << "TIFFClientOpen() failed.";
+        return false;
+    }
+
+    uint32_t width = 0, height = 0;
+    uint16_t bitsPerSample = 1, samplesPerPixel = 1, photometric = PHOTOMETRIC_MINISWHITE;
+    TIFFGetField(m_tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(m_tif, TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetFieldDefaulted(m_tif, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    TIFFGetFieldDefaulted(m_tif, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+    TIFFGetField(m_tif, TIFFTAG_PHOTOMETRIC, &photometric);
+    if ( width == 0 || height == 0 || width > 32767 || height > 32767 ){
+        LOG(WARNING) << "Unsupported TIFF size " << width << "x" << height;
+        return false;
+    }
+    if ( bitsPerSample != 1 || samplesPerPixel != 1 ||
+            (photometric != PHOTOMETRIC_MINISWHITE && photometric != PHOTOMETRIC_MINISBLACK) ){
+        LOG(WARNING) << "Unsupported TIFF image. Only bilevel images are supported.";
+        return false;
+    }
+    m_width = (int)width;
+    m_height = (int)height;
+    m_blackIs1 = photometric == PHOTOMETRIC_MINISWHITE;
+    return true;
+}
+
+// ======== TIFFDecoder::Decode() ========
+cairo_surface_t *TIFFDecoder::Decode(){
+    cairo_surface_t *surface = createBilevelSurface(m_width, m_height);
+    if ( surface == nullptr ) return nullptr;
+
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    size_t rowBytes = (size_t)(m_width + 7) / 8;
+    std::vector<uint8_t> row(std::max((size_t)TIFFScanlineSize(m_tif), rowBytes));
+
+    bool ok = true;
+    for ( int y = 0 ; y < m_height ; y++ ){
+        uint8_t *dst = data + (size_t)y * stride;
+        if ( ok && TIFFReadScanline(m_tif, row.data(), (uint32_t)y, 0) < 0 ){
+            LOG(WARNING) << "Bad TIFF image data.";
+            ok = false;
+        }
+        if ( ok ){
+            packBilevelRow(row.data(), m_width, m_blackIs1, dst);
+        } else {
+            memset(dst, 0, rowBytes);
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+
+    return surface;
+}
+
+namespace ofd{
+
+// ======== ReadImageHeader() ========
+bool ReadImageHeader(const char *data, size_t dataSize, ImageHeader &header){
+    if ( data == nullptr ) return false;
+
+    if ( isPNGData(data, dataSize) ){
+        PNGDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return false;
+        header.Format = ImageFormat::PNG;
+        header.Width = decoder.GetWidth();
+        header.Height = decoder.GetHeight();
+        header.HasAlpha = decoder.HasAlpha();
+        header.Bilevel = decoder.IsBilevel();
+        return true;
+    } else if ( isJPEGData(data, dataSize) ){
+        JPEGDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return false;
+        header.Format = ImageFormat::JPEG;
+        header.Width = decoder.GetWidth();
+        header.Height = decoder.GetHeight();
+        header.HasAlpha = false;
+        return true;
+    } else if ( isTIFFData(data, dataSize) ){
+        TIFFDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return false;
+        header.Format = ImageFormat::TIFF;
+        header.Width = decoder.GetWidth();
+        header.Height = decoder.GetHeight();
+        header.HasAlpha = false;
+        header.Bilevel = true;
+        return true;
+    }
+    return false;
+}
+
+// ======== DecodeImage() ========
+cairo_surface_t *DecodeImage(const char *data, size_t dataSize, int scaledWidth, int scaledHeight){
+    if ( data == nullptr ) return nullptr;
+
+    if ( isPNGData(data, dataSize) ){
+        PNGDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return nullptr;
+        return decoder.Decode(scaledWidth, scaledHeight);
+    } else if ( isJPEGData(data, dataSize) ){
+        JPEGDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return nullptr;
+        return decoder.Decode(scaledWidth, scaledHeight);
+    } else if ( isTIFFData(data, dataSize) ){
+        TIFFDecoder decoder(data, dataSize);
+        if ( !decoder.ReadHeader() ) return nullptr;
+        return decoder.Decode();
+    }
+    LOG(WARNING) << "Unsupported image format.";
+    return nullptr;
+}
+
+}; // namespace ofd
@@ -0,0 +1,904 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include <tiffio.h>
+extern "C" {
+#include <jpeglib.h>
+}
+#include "ofd/ImageEncoder.h"
+#include "ofd/ColorConvert.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+namespace ofd{
+
+std::string ImageFormatToString(ImageFormat format){
+    switch ( format ){
+    case ImageFormat::PNG:
+        return "png";
+    case ImageFormat::JPEG:
+        return "jpeg";
+    case ImageFormat::TIFF:
+        return "tiff";
+    case ImageFormat::PNM:
+        return "pnm";
+    }
+    return "png";
+}
+
+bool ImageFormatFromString(const std::string &strFormat, ImageFormat &format){
+    if ( strFormat == "png" ){
+        format = ImageFormat::PNG;
+    } else if ( strFormat == "jpeg" || strFormat == "jpg" ){
+        format = ImageFormat::JPEG;
+    } else if ( strFormat == "tiff" || strFormat == "tif" ){
+        format = ImageFormat::TIFF;
+    } else if ( strFormat == "pnm" || strFormat == "ppm" || strFormat == "pgm" || strFormat == "pbm" ){
+        format = ImageFormat::PNM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string ImageColorModeToString(ImageColorMode colorMode){
+    switch ( colorMode ){
+    case ImageColorMode::RGB:
+        return "rgb";
+    case ImageColorMode::RGBA:
+        return "rgba";
+    case ImageColorMode::Gray:
+        return "gray";
+    case ImageColorMode::Mono:
+        return "mono";
+    }
+    return "rgb";
+}
+
+bool ImageColorModeFromString(const std::string &strColorMode, ImageColorMode &colorMode){
+    if ( strColorMode == "rgb" ){
+        colorMode = ImageColorMode::RGB;
+    } else if ( strColorMode == "rgba" ){
+        colorMode = ImageColorMode::RGBA;
+    } else if ( strColorMode == "gray" ){
+        colorMode = ImageColorMode::Gray;
+    } else if ( strColorMode == "mono" ){
+        colorMode = ImageColorMode::Mono;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+size_t GetRowBytes(ImageColorMode colorMode, int width){
+    switch ( colorMode ){
+    case ImageColorMode::RGB:
+        return (size_t)width * 3;
+    case ImageColorMode::RGBA:
+        return (size_t)width * 4;
+    case ImageColorMode::Gray:
+        return (size_t)width;
+    case ImageColorMode::Mono:
+        return ((size_t)width + 7) / 8;
+    }
+    return 0;
+}
+
+// 灰度按 0.3*R + 0.59*G + 0.11*B 的整数近似计算，与pdf2ofd一致。
+static inline uint8_t pixelToGray(uint32_t pixel){
+    uint32_t r, g, b;
+    unpackSurfacePixel(pixel, r, g, b);
+    return (uint8_t)((r * 19661 + g * 38666 + b * 7209 + 32829) >> 16);
+}
+
+// A8表面按灰度解释（255为白），A1表面1为白，位序与平台字节序一致。
+static inline uint8_t grayPixel(const uint8_t *src, cairo_format_t format, int x){
+    if ( format == CAIRO_FORMAT_A8 ) return src[x];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (src[x >> 3] & (0x80 >> (x & 7))) ? 0xff : 0;
+#else
+    return (src[x >> 3] & (1 << (x & 7))) ? 0xff : 0;
+#endif
+}
+
+static void convertGrayRow(const uint8_t *src, cairo_format_t format, int width,
+        ImageColorMode colorMode, uint8_t monoThreshold, uint8_t *dst){
+    switch ( colorMode ){
+    case ImageColorMode::RGB:
+        for ( int x = 0 ; x < width ; x++ ){
+            uint8_t gray = grayPixel(src, format, x);
+            *dst++ = gray;
+            *dst++ = gray;
+            *dst++ = gray;
+        }
+        break;
+    case ImageColorMode::RGBA:
+        for ( int x = 0 ; x < width ; x++ ){
+            uint8_t gray = grayPixel(src, format, x);
+            *dst++ = gray;
+            *dst++ = gray;
+            *dst++ = gray;
+            *dst++ = 0xff;
+        }
+        break;
+    case ImageColorMode::Gray:
+        if ( format == CAIRO_FORMAT_A8 ){
+            memcpy(dst, src, width);
+        } else {
+            for ( int x = 0 ; x < width ; x++ ){
+                dst[x] = grayPixel(src, format, x);
+            }
+        }
+        break;
+    case ImageColorMode::Mono:
+        memset(dst, 0, ((size_t)width + 7) / 8);
+        for ( int x = 0 ; x < width ; x++ ){
+            if ( grayPixel(src, format, x) >= monoThreshold ){
+                dst[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+            }
+        }
+        break;
+    }
+}
+
+void ConvertSurfaceRow(const uint8_t *src, cairo_format_t format, int width,
+        ImageColorMode colorMode, uint8_t monoThreshold, uint8_t *dst){
+    if ( format == CAIRO_FORMAT_A8 || format == CAIRO_FORMAT_A1 ){
+        convertGrayRow(src, format, width, colorMode, monoThreshold, dst);
+        return;
+    }
+
+    const uint32_t *pixels = (const uint32_t*)src;
+    uint32_t alphaMask = (format == CAIRO_FORMAT_RGB24) ? 0xff000000 : 0;
+
+    switch ( colorMode ){
+    case ImageColorMode::RGB:
+        for ( int x = 0 ; x < width ; x++ ){
+            uint32_t r, g, b;
+            unpackSurfacePixel(pixels[x], r, g, b);
+            *dst++ = (uint8_t)r;
+            *dst++ = (uint8_t)g;
+            *dst++ = (uint8_t)b;
+        }
+        break;
+    case ImageColorMode::RGBA:
+        for ( int x = 0 ; x < width ; x++ ){
+            uint32_t pixel = pixels[x] | alphaMask;
+            uint32_t a = pixel >> 24;
+            uint32_t r, g, b;
+            unpackSurfacePixel(pixel, r, g, b);
+            if ( a == 0 ){
+                r = g = b = 0;
+            } else if ( a != 0xff ){
+                r = (r * 255 + a / 2) / a;
+                g = (g * 255 + a / 2) / a;
+                b = (b * 255 + a / 2) / a;
+            }
+            *dst++ = (uint8_t)r;
+            *dst++ = (uint8_t)g;
+            *dst++ = (uint8_t)b;
+            *dst++ = (uint8_t)a;
+        }
+        break;
+    case ImageColorMode::Gray:
+        for ( int x = 0 ; x < width ; x++ ){
+            dst[x] = pixelToGray(pixels[x]);
+        }
+        break;
+    case ImageColorMode::Mono:
+        memset(dst, 0, ((size_t)width + 7) / 8);
+        for ( int x = 0 ; x < width ; x++ ){
+            if ( pixelToGray(pixels[x]) >= monoThreshold ){
+                dst[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+            }
+        }
+        break;
+    }
+}
+
+}; // namespace ofd
+
+static bool checkSurface(cairo_surface_t *surface){
+    if ( surface == nullptr || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE ){
+        LOG(ERROR) << "ImageEncoder requires an image surface.";
+        return false;
+    }
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    if ( format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24 &&
+            format != CAIRO_FORMAT_A8 && format != CAIRO_FORMAT_A1 ){
+        LOG(ERROR) << "ImageEncoder does not support cairo format " << (int)format;
+        return false;
+    }
+    cairo_surface_flush(surface);
+    return true;
+}
+
+// **************** class ImageEncoder ****************
+
+ImageEncoder::ImageEncoder(const EncodeParams &params) :
+    m_params(params){
+}
+
+ImageEncoder::~ImageEncoder(){
+}
+
+bool ImageEncoder::EncodeToFile(cairo_surface_t *surface, const std::string &filename){
+    FILE *file = fopen(filename.c_str(), "wb");
+    if ( file == nullptr ){
+        LOG(ERROR) << "Open output file failed. filename=" << filename;
+        return false;
+    }
+    bool ok = Encode(surface, [file](const uint8_t *data, size_t length){
+        return fwrite(data, 1, length, file) == length;
+    });
+    if ( fclose(file) != 0 ){
+        ok = false;
+    }
+    if ( !ok ){
+        LOG(ERROR) << "Write image file failed. filename=" << filename;
+    }
+    return ok;
+}
+
+bool ImageEncoder::EncodeToBuffer(cairo_surface_t *surface, std::string &buffer){
+    return Encode(surface, [&buffer](const uint8_t *data, size_t length){
+        buffer.append((const char*)data, length);
+        return true;
+    });
+}
+
+// **************** class PNGEncoder ****************
+// 各线程独立压缩一段连续的行，除最后一段外以Z_SYNC_FLUSH结束，
+// 拼接后即为一个完整的deflate流，Adler-32校验值由各段合并得到。
+
+class PNGEncoder : public ImageEncoder {
+public:
+    PNGEncoder(const EncodeParams &params) : ImageEncoder(params){};
+    virtual bool Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc) override;
+
+private:
+    typedef struct Segment{
+        int RowBegin;
+        int RowEnd;
+        bool IsLast;
+        bool Ok;
+        uLong Adler;
+        size_t RawBytes;
+        std::string Data;
+    } Segment_t;
+
+    void compressSegment(const uint8_t *data, int stride, cairo_format_t format, int width, Segment &segment) const;
+
+}; // class PNGEncoder
+
+static int getPNGLevel(const EncodeParams &params){
+    return std::min(std::max(params.PNGLevel, 0), 9);
+}
+
+static uint32_t paethPredictor(int a, int b, int c){
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if ( pa <= pb && pa <= pc ) return a;
+    if ( pb <= pc ) return b;
+    return c;
+}
+
+// 按filter过滤一行，结果（含首字节的过滤类型）写入out。
+static void filterPNGRow(PNGFilter filter, const uint8_t *cur, const uint8_t *prev,
+        size_t rowBytes, size_t bpp, uint8_t *out){
+    out[0] = (uint8_t)filter;
+    uint8_t *dst = out + 1;
+    switch ( filter ){
+    case PNGFilter::None:
+        memcpy(dst, cur, rowBytes);
+        break;
+    case PNGFilter::Sub:
+        for ( size_t i = 0 ; i < rowBytes ; i++ ){
+            dst[i] = cur[i] - (i >= bpp ? cur[i - bpp] : 0);
+        }
+        break;
+    case PNGFilter::Up:
+        for ( size_t i = 0 ; i < rowBytes ; i++ ){
+            dst[i] = cur[i] - prev[i];
+        }
+        break;
+    case PNGFilter::Average:
+        for ( size_t i = 0 ; i < rowBytes ; i++ ){
+            int a = i >= bpp ? cur[i - bpp] : 0;
+            dst[i] = cur[i] - (uint8_t)((a + prev[i]) >> 1);
+        }
+        break;
+    case PNGFilter::Paeth:
+        for ( size_t i = 0 ; i < rowBytes ; i++ ){
+            int a = i >= bpp ? cur[i - bpp] : 0;
+            int c = i >= bpp ? prev[i - bpp] : 0;
+            dst[i] = cur[i] - (uint8_t)paethPredictor(a, prev[i], c);
+        }
+        break;
+    case PNGFilter::Adaptive:
+        assert(false);
+        break;
+    }
+}
+
+static uint64_t filteredRowCost(const uint8_t *filtered, size_t rowBytes){
+    uint64_t cost = 0;
+    for ( size_t i = 1 ; i <= rowBytes ; i++ ){
+        cost += abs((int)(int8_t)filtered[i]);
+    }
+    return cost;
+}
+
+static bool deflateData(z_stream &zs, const uint8_t *data, size_t length, int flush, std::string &output){
+    uint8_t buffer[16384];
+    zs.next_in = (Bytef*)data;
+    zs.avail_in = (uInt)length;
+    do {
+        zs.next_out = buffer;
+        zs.avail_out = sizeof(buffer);
+        int ret = deflate(&zs, flush);
+        if ( ret == Z_STREAM_ERROR ) return false;
+        output.append((const char*)buffer, sizeof(buffer) - zs.avail_out);
+    } while ( zs.avail_out == 0 );
+    return true;
+}
+
+void PNGEncoder::compressSegment(const uint8_t *data, int stride, cairo_format_t format, int width, Segment &segment) const{
+    segment.Ok = false;
+    segment.Adler = adler32(0L, Z_NULL, 0);
+    segment.RawBytes = 0;
+
+    ImageColorMode colorMode = m_params.ColorMode;
+    size_t rowBytes = GetRowBytes(colorMode, width);
+    // 过滤时左侧对应字节的距离，不足一字节按一字节计。
+    size_t bpp = std::max((size_t)1, rowBytes / width);
+
+    std::vector<uint8_t> prevRow(rowBytes, 0);
+    std::vector<uint8_t> curRow(rowBytes);
+    size_t numCandidates = m_params.Filter == PNGFilter::Adaptive ? 5 : 1;
+    std::vector<uint8_t> filtered((rowBytes + 1) * numCandidates);
+
+    // 段首行的Up、Average、Paeth过滤需要上一行。
+    if ( segment.RowBegin > 0 ){
+        ConvertSurfaceRow(data + (size_t)(segment.RowBegin - 1) * stride, format, width,
+                colorMode, m_params.MonoThreshold, prevRow.data());
+    }
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int strategy = m_params.Filter == PNGFilter::None ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    if ( deflateInit2(&zs, getPNGLevel(m_params), Z_DEFLATED, -15, 8, strategy) != Z_OK ){
+        LOG(ERROR) << "deflateInit2() failed.";
+        return;
+    }
+
+    bool ok = true;
+    for ( int y = segment.RowBegin ; y < segment.RowEnd && ok ; y++ ){
+        ConvertSurfaceRow(data + (size_t)y * stride, format, width,
+                colorMode, m_params.MonoThreshold, curRow.data());
+
+        const uint8_t *row = filtered.data();
+        if ( m_params.Filter == PNGFilter::Adaptive ){
+            uint64_t bestCost = 0;
+            for ( size_t f = 0 ; f < numCandidates ; f++ ){
+                uint8_t *candidate = filtered.data() + f * (rowBytes + 1);
+                filterPNGRow((PNGFilter)f, curRow.data(), prevRow.data(), rowBytes, bpp, candidate);
+                uint64_t cost = filteredRowCost(candidate, rowBytes);
+                if ( f == 0 || cost < bestCost ){
+                    bestCost = cost;
+                    row = candidate;
+                }
+            }
+        } else {
+            filterPNGRow(m_params.Filter, curRow.data(), prevRow.data(), rowBytes, bpp, filtered.data());
+        }
+
+        segment.Adler = adler32(segment.Adler, row, rowBytes + 1);
+        segment.RawBytes += rowBytes + 1;
+        ok = deflateData(zs, row, rowBytes + 1, Z_NO_FLUSH, segment.Data);
+        std::swap(prevRow, curRow);
+    }
+    if ( ok ){
+        ok = deflateData(zs, nullptr, 0, segment.IsLast ? Z_FINISH : Z_SYNC_FLUSH, segment.Data);
+    }
+    deflateEnd(&zs);
+
+    segment.Ok = ok;
+}
+
+static void putUInt32BE(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static bool writePNGChunk(ImageWriteFunc &writeFunc, const char *type, const uint8_t *data, size_t length){
+    uint8_t header[8];
+    putUInt32BE(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, header + 4, 4);
+    if ( length > 0 ){
+        crc = crc32(crc, data, (uInt)length);
+    }
+    uint8_t trailer[4];
+    putUInt32BE(trailer, (uint32_t)crc);
+    return writeFunc(header, 8) &&
+        (length == 0 || writeFunc(data, length)) &&
+        writeFunc(trailer, 4);
+}
+
+bool PNGEncoder::Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc){
+    if ( !checkSurface(surface) ) return false;
+
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+    if ( width <= 0 || height <= 0 ) return false;
+
+    // -------- 分段并行压缩 --------
+    size_t numThreads = m_params.Threads > 0 ? m_params.Threads : std::thread::hardware_concurrency();
+    size_t numSegments = std::max((size_t)1, std::min(numThreads, (size_t)height));
+    std::vector<Segment> segments(numSegments);
+    for ( size_t i = 0 ; i < numSegments ; i++ ){
+        segments[i].RowBegin = (int)(height * i / numSegments);
+        segments[i].RowEnd = (int)(height * (i + 1) / numSegments);
+        segments[i].IsLast = (i == numSegments - 1);
+    }
+
+    std::vector<std::thread> workers;
+    for ( size_t i = 1 ; i < numSegments ; i++ ){
+        workers.push_back(std::thread(&PNGEncoder::compressSegment, this, data, stride, format, width, std::ref(segments[i])));
+    }
+    compressSegment(data, stride, format, width, segments[0]);
+    for ( auto &worker : workers ){
+        worker.join();
+    }
+    for ( auto &segment : segments ){
+        if ( !segment.Ok ) return false;
+    }
+
+    // -------- 文件头 --------
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    if ( !writeFunc(signature, 8) ) return false;
+
+    uint8_t ihdr[13];
+    putUInt32BE(ihdr, (uint32_t)width);
+    putUInt32BE(ihdr + 4, (uint32_t)height);
+    switch ( m_params.ColorMode ){
+    case ImageColorMode::RGB:
+        ihdr[8] = 8; ihdr[9] = 2;
+        break;
+    case ImageColorMode::RGBA:
+        ihdr[8] = 8; ihdr[9] = 6;
+        break;
+    case ImageColorMode::Gray:
+        ihdr[8] = 8; ihdr[9] = 0;
+        break;
+    case ImageColorMode::Mono:
+        ihdr[8] = 1; ihdr[9] = 0;
+        break;
+    }
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // 自适应过滤
+    ihdr[12] = 0; // 不隔行
+    if ( !writePNGChunk(writeFunc, "IHDR", ihdr, sizeof(ihdr)) ) return false;
+
+    if ( m_params.ResolutionX > 0.0 && m_params.ResolutionY > 0.0 ){
+        uint8_t phys[9];
+        putUInt32BE(phys, (uint32_t)(m_params.ResolutionX / 0.0254 + 0.5));
+        putUInt32BE(phys + 4, (uint32_t)(m_params.ResolutionY / 0.0254 + 0.5));
+        phys[8] = 1; // 米
+        if ( !writePNGChunk(writeFunc, "pHYs", phys, sizeof(phys)) ) return false;
+    }
+
+    // -------- 图像数据 --------
+    // zlib头：32K窗口的deflate，FLEVEL按压缩级别设置，FCHECK使头部为31的倍数。
+    int level = getPNGLevel(m_params);
+    uint8_t cmf = 0x78;
+    uint8_t flg = (uint8_t)((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6);
+    flg += 31 - ((cmf * 256 + flg) % 31);
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for ( size_t i = 0 ; i < numSegments ; i++ ){
+        const Segment &segment = segments[i];
+        adler = adler32_combine(adler, segment.Adler, (z_off_t)segment.RawBytes);
+
+        std::string idat;
+        if ( i == 0 ){
+            idat.push_back((char)cmf);
+            idat.push_back((char)flg);
+        }
+        idat.append(segment.Data);
+        if ( segment.IsLast ){
+            uint8_t trailer[4];
+            putUInt32BE(trailer, (uint32_t)adler);
+            idat.append((const char*)trailer, 4);
+        }
+        if ( !writePNGChunk(writeFunc, "IDAT", (const uint8_t*)idat.data(), idat.size()) ) return false;
+    }
+
+    return writePNGChunk(writeFunc, "IEND", nullptr, 0);
+}
+
+// **************** class JPEGEncoder ****************
+// 基于libjpeg（libjpeg-turbo）。RGBA按RGB、Mono按Gray编码。
+// libjpeg-turbo支持JCS_EXT_RGBX时，RGB直接以表面缓冲区的行作为输入（小端内存中为R、G、B、A）。
+
+class JPEGEncoder : public ImageEncoder {
+public:
+    JPEGEncoder(const EncodeParams &params) : ImageEncoder(params){};
+    virtual bool Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc) override;
+
+}; // class JPEGEncoder
+
+#if defined(JCS_EXTENSIONS) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JPEG_DIRECT_RGBX 1
+#endif
+
+#define JPEG_OUTPUT_BUFFER_SIZE 65536
+
+typedef struct JPEGErrorManager{
+    struct jpeg_error_mgr Pub;
+    jmp_buf SetjmpBuffer;
+} JPEGErrorManager_t;
+
+static void jpegErrorExit(j_common_ptr cinfo){
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    LOG(ERROR) << "libjpeg error: " << message;
+    longjmp(((JPEGErrorManager*)cinfo->err)->SetjmpBuffer, 1);
+}
+
+typedef struct JPEGDestination{
+    struct jpeg_destination_mgr Pub;
+    ImageWriteFunc *WriteFunc;
+    bool Failed;
+    JOCTET Buffer[JPEG_OUTPUT_BUFFER_SIZE];
+} JPEGDestination_t;
+
+static void jpegInitDestination(j_compress_ptr cinfo){
+    JPEGDestination *dest = (JPEGDestination*)cinfo->dest;
+    dest->Pub.next_output_byte = dest->Buffer;
+    dest->Pub.free_in_buffer = JPEG_OUTPUT_BUFFER_SIZE;
+}
+
+static boolean jpegEmptyOutputBuffer(j_compress_ptr cinfo){
+    JPEGDestination *dest = (JPEGDestination*)cinfo->dest;
+    if ( !dest->Failed && !(*dest->WriteFunc)(dest->Buffer, JPEG_OUTPUT_BUFFER_SIZE) ){
+        dest->Failed = true;
+    }
+    dest->Pub.next_output_byte = dest->Buffer;
+    dest->Pub.free_in_buffer = JPEG_OUTPUT_BUFFER_SIZE;
+    return TRUE;
+}
+
+static void jpegTermDestination(j_compress_ptr cinfo){
+    JPEGDestination *dest = (JPEGDestination*)cinfo->dest;
+    size_t length = JPEG_OUTPUT_BUFFER_SIZE - dest->Pub.free_in_buffer;
+    if ( !dest->Failed && length > 0 && !(*dest->WriteFunc)(dest->Buffer, length) ){
+        dest->Failed = true;
+    }
+}
+
+bool JPEGEncoder::Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc){
+    if ( !checkSurface(surface) ) return false;
+
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    if ( width <= 0 || height <= 0 ) return false;
+
+    bool gray = m_params.ColorMode == ImageColorMode::Gray || m_params.ColorMode == ImageColorMode::Mono;
+    ImageColorMode rowMode = gray ? ImageColorMode::Gray : ImageColorMode::RGB;
+    std::vector<uint8_t> row(GetRowBytes(rowMode, width));
+    std::unique_ptr<JPEGDestination> dest(new JPEGDestination());
+
+    struct jpeg_compress_struct cinfo;
+    JPEGErrorManager jerr;
+    cinfo.err = jpeg_std_error(&jerr.Pub);
+    jerr.Pub.error_exit = jpegErrorExit;
+    if ( setjmp(jerr.SetjmpBuffer) ){
+        jpeg_destroy_compress(&cinfo);
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+
+    dest->Pub.init_destination = jpegInitDestination;
+    dest->Pub.empty_output_buffer = jpegEmptyOutputBuffer;
+    dest->Pub.term_destination = jpegTermDestination;
+    dest->WriteFunc = &writeFunc;
+    dest->Failed = false;
+    cinfo.dest = &dest->Pub;
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    bool direct = false;
+    if ( gray ){
+        cinfo.in_color_space = JCS_GRAYSCALE;
+        cinfo.input_components = 1;
+    } else {
+        cinfo.in_color_space = JCS_RGB;
+        cinfo.input_components = 3;
+#ifdef JPEG_DIRECT_RGBX
+        if ( format == CAIRO_FORMAT_ARGB32 || format == CAIRO_FORMAT_RGB24 ){
+            cinfo.in_color_space = JCS_EXT_RGBX;
+            cinfo.input_components = 4;
+            direct = true;
+        }
+#endif
+    }
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, std::min(std::max(m_params.JPEGQuality, 1), 100), TRUE);
+    if ( m_params.ResolutionX > 0.0 && m_params.ResolutionY > 0.0 ){
+        cinfo.density_unit = 1; // DPI
+        cinfo.X_density = (UINT16)(m_params.ResolutionX + 0.5);
+        cinfo.Y_density = (UINT16)(m_params.ResolutionY + 0.5);
+    }
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while ( cinfo.next_scanline < cinfo.image_height ){
+        uint8_t *src = data + (size_t)cinfo.next_scanline * stride;
+        JSAMPROW rowPointer;
+        if ( direct ){
+            rowPointer = src;
+        } else {
+            ConvertSurfaceRow(src, format, width, rowMode, m_params.MonoThreshold, row.data());
+            rowPointer = row.data();
+        }
+        jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    return !dest->Failed;
+}
+
+// **************** class TIFFEncoder ****************
+// 基于libtiff，在内存中生成后一次写出。
+// Mono使用CCITT G4压缩，其余使用带水平差分预测的Deflate压缩。
+
+class TIFFEncoder : public ImageEncoder {
+public:
+    TIFFEncoder(const EncodeParams &params) : ImageEncoder(params){};
+    virtual bool Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc) override;
+
+}; // class TIFFEncoder
+
+typedef struct TIFFMemory{
+    std::string Data;
+    toff_t Pos;
+} TIFFMemory_t;
+
+static tsize_t tiffRead(thandle_t, tdata_t, tsize_t){
+    return 0;
+}
+
+static tsize_t tiffWrite(thandle_t handle, tdata_t buf, tsize_t size){
+    TIFFMemory *memory = (TIFFMemory*)handle;
+    if ( memory->Pos + size > memory->Data.size() ){
+        memory->Data.resize(memory->Pos + size);
+    }
+    memcpy(&memory->Data[memory->Pos], buf, size);
+    memory->Pos += size;
+    return size;
+}
+
+static toff_t tiffSeek(thandle_t handle, toff_t offset, int whence){
+    TIFFMemory *memory = (TIFFMemory*)handle;
+    if ( whence == SEEK_SET ){
+        memory->Pos = offset;
+    } else if ( whence == SEEK_CUR ){
+        memory->Pos += offset;
+    } else if ( whence == SEEK_END ){
+        memory->Pos = memory->Data.size() + offset;
+    }
+    return memory->Pos;
+}
+
+static int tiffClose(thandle_t){
+    return 0;
+}
+
+static toff_t tiffSize(thandle_t handle){
+    return ((TIFFMemory*)handle)->Data.size();
+}
+
+static int tiffMap(thandle_t, tdata_t*, toff_t*){
+    return 0;
+}
+
+static void tiffUnmap(thandle_t, tdata_t, toff_t){
+}
+
+bool TIFFEncoder::Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc){
+    if ( !checkSurface(surface) ) return false;
+
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+    if ( width <= 0 || height <= 0 ) return false;
+
+    TIFFMemory memory;
+    memory.Pos = 0;
+    TIFF *tif = TIFFClientOpen("ofd", "w", (thandle_t)&memory,
+            tiffRead, tiffWrite, tiffSeek, tiffClose, tiffSize, tiffMap, tiffUnmap);
+    if ( tif == nullptr ){
+        LOG(ERROR) << "TIFFClientOpen() failed.";
+        return false;
+    }
+
+    ImageColorMode colorMode = m_params.ColorMode;
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)width);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)height);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    switch ( colorMode ){
+    case ImageColorMode::RGB:
+    case ImageColorMode::RGBA:
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, colorMode == ImageColorMode::RGBA ? 4 : 3);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        if ( colorMode == ImageColorMode::RGBA ){
+            uint16_t extraSamples[1] = {EXTRASAMPLE_UNASSALPHA};
+            TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, 1, extraSamples);
+        }
+        break;
+    case ImageColorMode::Gray:
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        break;
+    case ImageColorMode::Mono:
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 1);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        break;
+    }
+    if ( colorMode == ImageColorMode::Mono ){
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_CCITTFAX4);
+    } else {
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+        TIFFSetField(tif, TIFFTAG_ZIPQUALITY, std::min(std::max(m_params.PNGLevel, 1), 9));
+        TIFFSetField(tif, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL);
+    }
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(tif, 0));
+    if ( m_params.ResolutionX > 0.0 && m_params.ResolutionY > 0.0 ){
+        TIFFSetField(tif, TIFFTAG_XRESOLUTION, (float)m_params.ResolutionX);
+        TIFFSetField(tif, TIFFTAG_YRESOLUTION, (float)m_params.ResolutionY);
+        TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
+    }
+
+    std::vector<uint8_t> row(GetRowBytes(colorMode, width));
+    bool ok = true;
+    for ( int y = 0 ; y < height && ok ; y++ ){
+        ConvertSurfaceRow(data + (size_t)y * stride, format, width, colorMode, m_params.MonoThreshold, row.data());
+        ok = TIFFWriteScanline(tif, row.data(), y, 0) >= 0;
+    }
+    TIFFClose(tif);
+
+    if ( !ok ){
+        LOG(ERROR) << "TIFFWriteScanline() failed.";
+        return false;
+    }
+    return writeFunc((const uint8_t*)memory.Data.data(), memory.Data.size());
+}
+
+namespace ofd{
+
+// ======== WriteCCITTG4TIFF() ========
+// 压缩数据作为单个条带原样写入，不经libtiff的编解码。
+bool WriteCCITTG4TIFF(const uint8_t *data, size_t dataSize, int width, int height, bool invert, ImageWriteFunc writeFunc){
+    if ( data == nullptr || dataSize == 0 || width <= 0 || height <= 0 ) return false;
+
+    TIFFMemory memory;
+    memory.Pos = 0;
+    TIFF *tif = TIFFClientOpen("ofd", "w", (thandle_t)&memory,
+            tiffRead, tiffWrite, tiffSeek, tiffClose, tiffSize, tiffMap, tiffUnmap);
+    if ( tif == nullptr ){
+        LOG(ERROR) << "TIFFClientOpen() failed.";
+        return false;
+    }
+
+    TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)width);
+    TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)height);
+    TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 1);
+    TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, invert ? PHOTOMETRIC_MINISBLACK : PHOTOMETRIC_MINISWHITE);
+    TIFFSetField(tif, TIFFTAG_FILLORDER, FILLORDER_MSB2LSB);
+    TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_CCITTFAX4);
+    TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, (uint32_t)height);
+
+    bool ok = TIFFWriteRawStrip(tif, 0, (tdata_t)data, (tsize_t)dataSize) >= 0;
+    TIFFClose(tif);
+
+    if ( !ok ){
+        LOG(ERROR) << "TIFFWriteRawStrip() failed.";
+        return false;
+    }
+    return writeFunc((const uint8_t*)memory.Data.data(), memory.Data.size());
+}
+
+}; // namespace ofd
+
+// **************** class PNMEncoder ****************
+// RGB、RGBA输出为PPM(P6)，Gray为PGM(P5)，Mono为PBM(P4，1为黑色)。
+
+class PNMEncoder : public ImageEncoder {
+public:
+    PNMEncoder(const EncodeParams &params) : ImageEncoder(params){};
+    virtual bool Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc) override;
+
+}; // class PNMEncoder
+
+bool PNMEncoder::Encode(cairo_surface_t *surface, ImageWriteFunc writeFunc){
+    if ( !checkSurface(surface) ) return false;
+
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    cairo_format_t format = cairo_image_surface_get_format(surface);
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+
+    ImageColorMode colorMode = m_params.ColorMode;
+    if ( colorMode == ImageColorMode::RGBA ){
+        colorMode = ImageColorMode::RGB;
+    }
+    std::string magic = colorMode == ImageColorMode::RGB ? "P6" : colorMode == ImageColorMode::Gray ? "P5" : "P4";
+    std::string header = magic + "\n" + std::to_string(width) + " " + std::to_string(height) + "\n";
+    if ( colorMode != ImageColorMode::Mono ){
+        header += "255\n";
+    }
+    if ( !writeFunc((const uint8_t*)header.data(), header.size()) ) return false;
+
+    size_t rowBytes = GetRowBytes(colorMode, width);
+    std::vector<uint8_t> row(rowBytes);
+    for ( int y = 0 ; y < height ; y++ ){
+        ConvertSurfaceRow(data + (size_t)y * stride, format, width, colorMode, m_params.MonoThreshold, row.data());
+        if ( colorMode == ImageColorMode::Mono ){
+            for ( size_t i = 0 ; i < rowBytes ; i++ ){
+                row[i] = ~row[i];
+            }
+        }
+        if ( !writeFunc(row.data(), rowBytes) ) return false;
+    }
+    return true;
+}
+
+// **************** class ImageEncoderFactory ****************
+
+ImageEncoderPtr ImageEncoderFactory::CreateEncoder(const EncodeParams &params){
+    ImageEncoderPtr encoder = nullptr;
+    switch ( params.Format ){
+    case ImageFormat::PNG:
+        encoder = std::make_shared<PNGEncoder>(params);
+        break;
+    case ImageFormat::JPEG:
+        encoder = std::make_shared<JPEGEncoder>(params);
+        break;
+    case ImageFormat::TIFF:
+        encoder = std::make_shared<TIFFEncoder>(params);
+        break;
+    case ImageFormat::PNM:
+        encoder = std::make_shared<PNMEncoder>(params);
+        break;
+    }
+    return encoder;
+}
@@ -8,6 +8,31 @@ using namespace utils;
 
 uint64_t numObjects = 0;
 
+std::string ofd::LayerTypeToString(LayerType layerType){
+    switch ( layerType ){
+    case LayerType::BACKGROUND:
+        return "Background";
+    case LayerType::FOREGROUND:
+        return "Foreground";
+    case LayerType::CUSTOM:
+        return "Custom";
+    default:
+        return "Body";
+    }
+}
+
+LayerType ofd::LayerTypeFromString(const std::string &strLayerType){
+    if ( strLayerType == "Background" ){
+        return LayerType::BACKGROUND;
+    } else if ( strLayerType == "Foreground" ){
+        return LayerType::FOREGROUND;
+    } else if ( strLayerType == "Custom" ){
+        return LayerType::CUSTOM;
+    } else {
+        return LayerType::BODY;
+    }
+}
+
 Layer::Layer(PagePtr page) :
     ID(0), Type(LayerType::BODY),
     m_page(page){
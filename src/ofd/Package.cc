@@ -3,6 +3,8 @@
 #include "ofd/Package.h"
 #include "ofd/Document.h"
 #include "ofd/Page.h"
+#include "ofd/Layer.h"
+#include "ofd/TextObject.h"
 #include "ofd/Font.h"
 #include "ofd/Image.h"
 #include "ofd/Resource.h"
@@ -26,6 +28,32 @@ Package::Package(const std::string &filename) :
 Package::~Package(){
 }
 
+// 记录页面及模板页中文本对象用到的字符。
+static void collectPageGlyphUsage(PagePtr page){
+    if ( page == nullptr ) return;
+    for ( size_t i = 0 ; i < page->GetNumLayers() ; i++ ){
+        LayerPtr layer = page->GetLayer(i);
+        for ( auto object : layer->GetObjects() ){
+            if ( object->Type != ObjectType::TEXT ) continue;
+            const TextObject *textObject = static_cast<const TextObject*>(object.get());
+            FontPtr font = textObject->GetFont();
+            if ( font == nullptr ) continue;
+            for ( size_t k = 0 ; k < textObject->GetNumTextCodes() ; k++ ){
+                font->AddUsedText(textObject->GetTextCode(k).Text);
+            }
+        }
+    }
+}
+
+static void collectGlyphUsage(DocumentPtr document){
+    for ( size_t k = 0 ; k < document->GetNumPages() ; k++ ){
+        collectPageGlyphUsage(document->GetPage(k));
+    }
+    for ( auto &templatePage : document->GetCommonData().TemplatePages ){
+        collectPageGlyphUsage(document->GetTemplatePage(templatePage.ID));
+    }
+}
+
 PackagePtr Package::GetSelf(){
     return shared_from_this();
 }
@@ -131,29 +159,6 @@ bool Package::Save(const std::string &filename){
         std::string strDocumentResXML;
         if ( commonData.DocumentRes != nullptr ){
 
-            // -------- Default Font --------
-            // FIXME
-            // Default font. fontID=0, AdobeSongStd-Light.otf
-            FontPtr defaultFont = commonData.DocumentRes->GetFont(0);
-            if ( defaultFont == nullptr ){
-                defaultFont = std::make_shared<Font>();
-                defaultFont->ID = 0;
-                defaultFont->FontName = "Default";
-                defaultFont->FontType = ofd::FontType::TrueType;
-                defaultFont->FontLoc = ofd::FontLocation::Embedded;
-                commonData.DocumentRes->AddFont(defaultFont);
-
-                char *data = nullptr;
-                size_t dataSize = 0;
-                bool dataOK = false;
-                std::tie(data, dataSize, dataOK) = utils::ReadFileData("data/default.otf");
-                if ( dataOK ){
-                    defaultFont->CreateFromData(data, dataSize);
-                } else {
-                    LOG(ERROR) << "Read default font data failed.";
-                }
-            }
-
             strDocumentResXML = commonData.DocumentRes->GenerateResXML();
         }
         zip->AddFile(Doc_N + "/DocumentRes.xml", strDocumentResXML); 
@@ -186,6 +191,20 @@ bool Package::Save(const std::string &filename){
             // Doc_N/Pages/Page_K/Res/Image_M.png
         }
 
+        // mkdir Doc_N/Tpls
+        // Doc_N/Tpls/Tpl_K/Content.xml
+        const Document::TemplatePageArray &templatePages = commonData.TemplatePages;
+        if ( templatePages.size() > 0 ){
+            zip->AddDir(Doc_N + "/Tpls");
+            for ( auto &templatePage : templatePages ){
+                PagePtr page = document->GetTemplatePage(templatePage.ID);
+                if ( page == nullptr ) continue;
+                std::string templateDir = Doc_N + "/Tpls/Tpl_" + std::to_string(templatePage.ID);
+                zip->AddDir(templateDir);
+                zip->AddFile(templateDir + "/Content.xml", page->GeneratePageXML());
+            }
+        }
+
         // mkdir Doc_N/Signs
         std::string signsDir = Doc_N + "/Signs";
         zip->AddDir(signsDir); 
@@ -222,26 +241,38 @@ bool Package::Save(const std::string &filename){
         assert(documentRes != nullptr);
 
         // Font Resource
+        // 字体只保存文档中用到的字形。
+        // 由本机路径或系统字体加载的字体不写入包内，保留原有的FontFile引用。
+        collectGlyphUsage(document);
         const FontMap &fonts = documentRes->GetFonts();
         for ( auto iter : fonts){
             auto font = iter.second;
+            if ( font->IsSubstitute() || font->FontLoc != FontLocation::Embedded ) continue;
             const char *fontData = font->GetFontData();
             size_t fontDataSize = font->GetFontDataSize();
             if ( fontData != nullptr && fontDataSize > 0 ){
                 std::string fontFileName = resDir + "/" + generateFontFileName(font->ID);
                 //LOG(ERROR) << "zip->AddFile() while save Font. file = " << fontFileName;
-                zip->AddFile(fontFileName, fontData, fontDataSize);
+                char *subsetData = nullptr;
+                size_t subsetDataSize = 0;
+                bool subsetOK = false;
+                std::tie(subsetData, subsetDataSize, subsetOK) = font->CreateSubsetData();
+                if ( subsetOK ){
+                    zip->AddFile(fontFileName, subsetData, subsetDataSize);
+                    delete[] subsetData;
+                } else {
+                    zip->AddFile(fontFileName, fontData, fontDataSize);
+                }
             }
         }
 
         // Image Resource
-        // Doc_N/Res/Image_M.png
+        // Doc_N/Res/Image_M.png，DCT图像为Doc_N/Res/Image_M.jpg
         const ImageMap &images = documentRes->GetImages();
         for ( auto iter : images ){
             auto image = iter.second;
-            uint64_t imageID = image->ID;
 
-            std::string imageFileName = generateImageFileName(imageID);
+            std::string imageFileName = image->GenerateImageFileName();
 
             char *imageData = nullptr;
             size_t imageDataSize = 0;
@@ -266,7 +297,7 @@ bool Package::Save(const std::string &filename){
                 std::string imageFilePath = resDir + "/" + imageFileName;
                 zip->AddFile(imageFilePath, imageData, imageDataSize);
 
-                delete imageData;
+                delete[] imageData;
             }
         }
 
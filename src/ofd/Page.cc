@@ -56,7 +56,11 @@ bool Page::Open(){
     if ( package == nullptr ) return false;
 
     std::string docRoot = document->GetDocRoot();
-    std::string pageXMLFile = docRoot + "/" + BaseLoc + "/Content.xml";
+    // 模板页的BaseLoc直接指向内容描述文件。
+    std::string pageXMLFile = docRoot + "/" + BaseLoc;
+    if ( BaseLoc.size() < 4 || BaseLoc.compare(BaseLoc.size() - 4, 4, ".xml") != 0 ){
+        pageXMLFile += "/Content.xml";
+    }
     LOG(INFO) << "Try to open zipfile " << pageXMLFile;
 
     bool ok = false;
@@ -69,6 +73,10 @@ bool Page::Open(){
         if ( m_opened ){
             LOG(INFO) << "Open page success.";
             LOG(INFO) << to_string();
+            // 引用的模板页随页面一起打开，绘制时不再解析。
+            for ( auto &tpl : Templates ){
+                document->GetTemplatePage(tpl.TemplateID);
+            }
         } else {
             LOG(ERROR) << "Open page failed. ID: " << ID << " BaseLoc: " << BaseLoc;
         }
@@ -92,6 +100,9 @@ LayerPtr Page::AddNewLayer(LayerType layerType){
 }
 
 const LayerPtr Page::GetBodyLayer() const{
+    for ( auto layer : m_layers ){
+        if ( layer->Type == LayerType::BODY ) return layer;
+    }
     if ( m_layers.size() > 0 ){
         const LayerPtr bodyLayer = m_layers[0]; 
         return bodyLayer;
@@ -101,6 +112,9 @@ const LayerPtr Page::GetBodyLayer() const{
 }
 
 LayerPtr Page::GetBodyLayer(){
+    for ( auto layer : m_layers ){
+        if ( layer->Type == LayerType::BODY ) return layer;
+    }
     if ( m_layers.size() > 0 ){
         const LayerPtr bodyLayer = m_layers[0]; 
         return bodyLayer;
@@ -109,6 +123,48 @@ LayerPtr Page::GetBodyLayer(){
     }
 }
 
+LayerArray Page::GetDrawingLayers() const{
+    LayerArray layers;
+
+    // -------- 模板页图层 --------
+    LayerArray backgroundTemplateLayers;
+    LayerArray foregroundTemplateLayers;
+    DocumentPtr document = m_document.lock();
+    if ( document != nullptr ){
+        for ( auto &tpl : Templates ){
+            PagePtr templatePage = document->GetTemplatePage(tpl.TemplateID);
+            if ( templatePage == nullptr ){
+                LOG(WARNING) << "Template page not found. TemplateID=" << tpl.TemplateID;
+                continue;
+            }
+            LayerArray &templateLayers = tpl.ZOrder == LayerType::FOREGROUND ? foregroundTemplateLayers : backgroundTemplateLayers;
+            for ( size_t i = 0 ; i < templatePage->GetNumLayers() ; i++ ){
+                templateLayers.push_back(templatePage->GetLayer(i));
+            }
+        }
+    }
+
+    layers.insert(layers.end(), backgroundTemplateLayers.begin(), backgroundTemplateLayers.end());
+    for ( auto layer : m_layers ){
+        if ( layer->Type == LayerType::BACKGROUND ) layers.push_back(layer);
+    }
+    for ( auto layer : m_layers ){
+        if ( layer->Type == LayerType::BODY || layer->Type == LayerType::CUSTOM ) layers.push_back(layer);
+    }
+    for ( auto layer : m_layers ){
+        if ( layer->Type == LayerType::FOREGROUND ) layers.push_back(layer);
+    }
+    layers.insert(layers.end(), foregroundTemplateLayers.begin(), foregroundTemplateLayers.end());
+
+    return layers;
+}
+
+bool Page::IsTemplateLayer(const LayerPtr layer) const{
+    if ( layer == nullptr ) return false;
+    const PagePtr layerPage = layer->GetPage();
+    return layerPage != nullptr && layerPage.get() != this;
+}
+
 std::tuple<ST_Box, bool> ReadBoxFromXML(XMLElementPtr boxElement){
     ST_Box box;
     bool exist = false;
@@ -156,10 +212,22 @@ std::string Page::GeneratePageXML() const{
            writePageAreaXML(writer, Area); 
         } writer.EndElement();
 
-        // TODO
         // -------- <Template>
         // OFD (section 7.7) P19.
         // Optional.
+        for ( auto &tpl : Templates ){
+            writer.StartElement("Template");{
+                // -------- <Template TemplateID="">
+                // Required.
+                writer.WriteAttribute("TemplateID", tpl.TemplateID);
+
+                // -------- <Template ZOrder="">
+                // Optional. 缺省为Background。
+                if ( tpl.ZOrder != LayerType::BACKGROUND ){
+                    writer.WriteAttribute("ZOrder", LayerTypeToString(tpl.ZOrder));
+                }
+            } writer.EndElement();
+        }
 
         // TODO
         // -------- <PageRes>
@@ -200,8 +268,11 @@ void Page::generateContentXML(XMLWriter &writer) const{
 
                 // -------- CT_Layer --------
 
-                // TODO
                 // -------- <Layer Type="">
+                // Optional. 缺省为Body。
+                if ( layer->Type != LayerType::BODY ){
+                    writer.WriteAttribute("Type", LayerTypeToString(layer->Type));
+                }
 
                 // TODO
                 // -------- <Layer DrawParam="">
@@ -292,6 +363,12 @@ bool Page::fromPageXML(const std::string &strPageXML){
                     // -------- <Area>
                     // Optional.
                     std::tie(Area, ok) = fromPageAreaXML(childElement);
+                } else if ( childName == "Template" ) {
+                    // -------- <Template>
+                    // OFD (section 7.7) P19.
+                    // Optional.
+                    fromTemplateXML(childElement);
+
                 } else if ( childName == "Content" ) {
                     // -------- <Content>
                     // Optional.
@@ -329,6 +406,37 @@ bool Page::fromPageXML(const std::string &strPageXML){
     return ok;
 }
 
+// -------- Page::fromTemplateXML() --------
+// Called by Page::fromPageXML()
+// OFD (section 7.7) P19. Page.xsd
+bool Page::fromTemplateXML(XMLElementPtr templateElement){
+    bool exist = false;
+
+    CT_Template tpl;
+    std::tie(tpl.TemplateID, exist) = templateElement->GetIntAttribute("TemplateID");
+    if ( !exist ){
+        LOG(ERROR) << "Attribute TemplateID is required in Page.xsd";
+        return false;
+    }
+
+    // 未指定ZOrder时采用模板页定义中的默认值。
+    std::string strZOrder;
+    std::tie(strZOrder, exist) = templateElement->GetStringAttribute("ZOrder");
+    if ( exist ){
+        tpl.ZOrder = LayerTypeFromString(strZOrder);
+    } else {
+        DocumentPtr document = m_document.lock();
+        const Document::CT_TemplatePage *templatePage = document != nullptr ? document->GetTemplatePageInfo(tpl.TemplateID) : nullptr;
+        if ( templatePage != nullptr ){
+            tpl.ZOrder = templatePage->ZOrder;
+        }
+    }
+
+    Templates.push_back(tpl);
+
+    return true;
+}
+
 // -------- fromLayerXML() --------
 // Called by Page::fromContentXML()
 LayerPtr Page::fromLayerXML(XMLElementPtr layerElement){
@@ -341,16 +449,16 @@ LayerPtr Page::fromLayerXML(XMLElementPtr layerElement){
     bool exist = false;
 
     uint64_t layerID = 0;
-    uint64_t layerType = 0;
+    std::string strLayerType;
     uint64_t drawParamID = 0;
 
     std::tie(layerID, exist) = layerElement->GetIntAttribute("ID");
     if ( !exist ) return nullptr;
-    std::tie(layerType, std::ignore) = layerElement->GetIntAttribute("Type");
+    std::tie(strLayerType, exist) = layerElement->GetStringAttribute("Type");
     std::tie(drawParamID, std::ignore) = layerElement->GetIntAttribute("DrawParam");
 
     layer->ID = layerID;
-    layer->Type = (LayerType)layerType;
+    layer->Type = exist ? LayerTypeFromString(strLayerType) : LayerType::BODY;
 
     XMLElementPtr childElement = layerElement->GetFirstChildElement();
     while ( childElement != nullptr ){
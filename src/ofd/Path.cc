@@ -50,6 +50,41 @@ Boundary Subpath::CalculateBoundary() const{
     return boundary;
 }
 
+bool Subpath::GetAxisAlignedRect(Boundary &rect) const{
+    size_t numPoints = m_points.size();
+    if ( numPoints == 5 && m_points[4].X == m_points[0].X && m_points[4].Y == m_points[0].Y ){
+        numPoints = 4;
+    }
+    if ( numPoints != 4 ) return false;
+    for ( size_t i = 1 ; i < m_points.size() ; i++ ){
+        if ( m_flags[i] != 'L' ) return false;
+    }
+
+    // 各边交替为水平和垂直。
+    bool firstHorizontal = (m_points[0].Y == m_points[1].Y);
+    for ( size_t i = 0 ; i < 4 ; i++ ){
+        const Point_t &p0 = m_points[i];
+        const Point_t &p1 = m_points[(i + 1) % 4];
+        bool horizontal = ((i % 2 == 0) == firstHorizontal);
+        if ( horizontal ){
+            if ( p0.Y != p1.Y ) return false;
+        } else {
+            if ( p0.X != p1.X ) return false;
+        }
+    }
+
+    rect = CalculateBoundary();
+    return true;
+}
+
+bool Subpath::GetAxisAlignedLine(Point_t &p0, Point_t &p1) const{
+    if ( m_points.size() != 2 || m_flags[1] != 'L' ) return false;
+    if ( m_points[0].X != m_points[1].X && m_points[0].Y != m_points[1].Y ) return false;
+    p0 = m_points[0];
+    p1 = m_points[1];
+    return true;
+}
+
 SubpathPtr Subpath::Clone() const{
     return std::make_shared<Subpath>(this);
 }
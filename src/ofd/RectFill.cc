@@ -0,0 +1,87 @@
+#include <math.h>
+#include <algorithm>
+#include "ofd/RectFill.h"
+
+using namespace ofd;
+
+// 预乘像素按8位覆盖率coverage缩放，各通道四舍五入。
+static inline uint32_t scalePixel(uint32_t pixel, uint32_t coverage){
+    uint32_t rb = (pixel & 0x00ff00ff) * coverage + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    uint32_t ag = ((pixel >> 8) & 0x00ff00ff) * coverage + 0x00800080;
+    ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+    return rb | ag;
+}
+
+// OVER: dst = src + dst * (1 - src.alpha)。
+static inline uint32_t overPixel(uint32_t src, uint32_t dst){
+    return src + scalePixel(dst, 255 - (src >> 24));
+}
+
+// 一行中[ix0, ix1)的像素，首尾像素的水平覆盖率为leftCoverage、rightCoverage（0~1），
+// 行的垂直覆盖率为rowCoverage。只有一个像素时其覆盖率为leftCoverage。
+static void fillSpan(uint32_t *row, int ix0, int ix1, double leftCoverage, double rightCoverage,
+        double rowCoverage, uint32_t color){
+    if ( ix0 >= ix1 ) return;
+
+    if ( ix1 - ix0 == 1 ){
+        uint32_t coverage = (uint32_t)(leftCoverage * rowCoverage * 255.0 + 0.5);
+        row[ix0] = overPixel(scalePixel(color, coverage), row[ix0]);
+        return;
+    }
+
+    uint32_t leftSrc = scalePixel(color, (uint32_t)(leftCoverage * rowCoverage * 255.0 + 0.5));
+    uint32_t rightSrc = scalePixel(color, (uint32_t)(rightCoverage * rowCoverage * 255.0 + 0.5));
+    row[ix0] = overPixel(leftSrc, row[ix0]);
+    row[ix1 - 1] = overPixel(rightSrc, row[ix1 - 1]);
+
+    // -------- 内部像素 --------
+    // 以下两个循环均无跨迭代依赖，编译器可自动向量化。
+    uint32_t *begin = row + ix0 + 1;
+    uint32_t *end = row + ix1 - 1;
+    uint32_t src = scalePixel(color, (uint32_t)(rowCoverage * 255.0 + 0.5));
+    if ( (src >> 24) == 0xff ){
+        std::fill(begin, end, src);
+    } else {
+        uint32_t inverseAlpha = 255 - (src >> 24);
+        for ( uint32_t *p = begin ; p < end ; p++ ){
+            *p = src + scalePixel(*p, inverseAlpha);
+        }
+    }
+}
+
+namespace ofd{
+
+void FillRectARGB32(uint8_t *data, int stride, int width, int height,
+        double x0, double y0, double x1, double y1, uint32_t color){
+    x0 = std::max(x0, 0.0);
+    y0 = std::max(y0, 0.0);
+    x1 = std::min(x1, (double)width);
+    y1 = std::min(y1, (double)height);
+    if ( x0 >= x1 || y0 >= y1 || (color >> 24) == 0 ) return;
+
+    int ix0 = (int)floor(x0);
+    int ix1 = (int)ceil(x1);
+    int iy0 = (int)floor(y0);
+    int iy1 = (int)ceil(y1);
+
+    double leftCoverage = std::min((double)(ix0 + 1), x1) - x0;
+    double rightCoverage = x1 - std::max((double)(ix1 - 1), x0);
+
+    for ( int y = iy0 ; y < iy1 ; y++ ){
+        double rowCoverage = std::min((double)(y + 1), y1) - std::max((double)y, y0);
+        uint32_t *row = (uint32_t*)(data + (size_t)y * stride);
+        fillSpan(row, ix0, ix1, leftCoverage, rightCoverage, rowCoverage, color);
+    }
+}
+
+uint32_t PremultiplyARGB32(double r, double g, double b, double a){
+    a = std::min(std::max(a, 0.0), 1.0);
+    uint32_t A = (uint32_t)(a * 255.0 + 0.5);
+    uint32_t R = (uint32_t)(std::min(std::max(r, 0.0), 1.0) * a * 255.0 + 0.5);
+    uint32_t G = (uint32_t)(std::min(std::max(g, 0.0), 1.0) * a * 255.0 + 0.5);
+    uint32_t B = (uint32_t)(std::min(std::max(b, 0.0), 1.0) * a * 255.0 + 0.5);
+    return (A << 24) | (R << 16) | (G << 8) | B;
+}
+
+}; // namespace ofd
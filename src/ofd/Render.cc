@@ -1,6 +1,8 @@
 #include "ofd/Render.h"
 #include "ofd/Page.h"
-//#include "ofd/CairoRender.h"
+#include "ofd/CairoRender.h"
+#include "ofd/CairoVectorRender.h"
+#include "utils/logger.h"
 
 using namespace ofd;
 
@@ -21,6 +23,11 @@ void Render::DrawPage(PagePtr page, VisibleParams visibleParams){
     m_visibleParams = visibleParams;
 }
 
+bool Render::DrawPage(PagePtr page, VisibleParams visibleParams, const DrawControl &drawControl){
+    m_visibleParams = visibleParams;
+    return true;
+}
+
 VisibleParams Render::GetVisibleParams() const{
     return m_visibleParams;
 }
@@ -29,10 +36,21 @@ void Render::SetVisibleParams(VisibleParams visibleParams){
     m_visibleParams = visibleParams;
 }
 
-//RenderPtr RenderFactory::CreateRenderInstance(RenderType renderType){
-    //if ( renderType == RenderType::Cairo ){
-        //return std::make_shared<OFDCairoRender>();
-    //} else {
-        //return nullptr;
-    //}
-//}
+// ======== RenderFactory::CreateRenderInstance() ========
+RenderPtr RenderFactory::CreateRenderInstance(RenderType renderType, double pixelWidth, double pixelHeight, double resolutionX, double resolutionY){
+    if ( renderType == RenderType::Cairo ){
+        return std::make_shared<CairoRender>(pixelWidth, pixelHeight, resolutionX, resolutionY);
+    } else {
+        LOG(ERROR) << "RenderType " << (int)renderType << " is not a raster render type.";
+        return nullptr;
+    }
+}
+
+RenderPtr RenderFactory::CreateRenderInstance(RenderType renderType, const std::string &filename){
+    if ( renderType == RenderType::PDF || renderType == RenderType::SVG || renderType == RenderType::PS ){
+        return std::make_shared<CairoVectorRender>(renderType, filename);
+    } else {
+        LOG(ERROR) << "RenderType " << (int)renderType << " is not a vector render type.";
+        return nullptr;
+    }
+}
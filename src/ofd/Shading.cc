@@ -1,4 +1,5 @@
 #include <math.h>
+#include <algorithm>
 #include "ofd/Shading.h"
 #include "utils/xml.h"
 #include "utils/logger.h"
@@ -19,6 +20,50 @@ using namespace ofd;
 //cairo_set_source (cr, spat);
 //cairo_paint(cr);
 
+// Cairo/pixman do not work well with a very large or small scaled
+// matrix.  See cairo bug #81657.
+//
+// As a workaround, scale the pattern by the average of the vertical
+// and horizontal scaling of the current transformation matrix.
+static double getPatternScale(cairo_t *cr){
+    cairo_matrix_t matrix;
+    cairo_get_matrix(cr, &matrix);
+    return (sqrt(matrix.xx * matrix.xx + matrix.yx * matrix.yx)
+            + sqrt(matrix.xy * matrix.xy + matrix.yy * matrix.yy)) / 2;
+}
+
+// 按offset在颜色段间线性插值，颜色段按Position升序排列。
+static void interpolateColorStops(const ColorStopArray &colorStops, double offset,
+        double &r, double &g, double &b, double &a){
+    r = g = b = a = 0.0;
+    const ColorStop_t *prev = nullptr;
+    for ( const auto &cs : colorStops ){
+        if ( cs.Color == nullptr ) continue;
+        if ( cs.Offset >= offset ){
+            std::tie(r, g, b, a) = cs.Color->GetRGBA();
+            if ( prev != nullptr && cs.Offset > prev->Offset ){
+                double r0, g0, b0, a0;
+                std::tie(r0, g0, b0, a0) = prev->Color->GetRGBA();
+                double f = (offset - prev->Offset) / (cs.Offset - prev->Offset);
+                r = r0 + (r - r0) * f;
+                g = g0 + (g - g0) * f;
+                b = b0 + (b - b0) * f;
+                a = a0 + (a - a0) * f;
+            }
+            return;
+        }
+        prev = &cs;
+    }
+    if ( prev != nullptr ){
+        std::tie(r, g, b, a) = prev->Color->GetRGBA();
+    }
+}
+
+// ======== RadialShading::getPatternKey() ========
+double RadialShading::getPatternKey(cairo_t *cr) const{
+    return getPatternScale(cr);
+}
+
 // ======== RadialShading::CreateFillPattern() ========
 cairo_pattern_t *RadialShading::CreateFillPattern(cairo_t *cr){
 
@@ -37,16 +82,8 @@ cairo_pattern_t *RadialShading::CreateFillPattern(cairo_t *cr){
     dy = y1 - y0;
     dr = r1 - r0;
 
-    // Cairo/pixman do not work well with a very large or small scaled
-    // matrix.  See cairo bug #81657.
-    //
-    // As a workaround, scale the pattern by the average of the vertical
-    // and horizontal scaling of the current transformation matrix.
     cairo_matrix_t matrix;
-    cairo_get_matrix(cr, &matrix);
-    double scale;
-    scale = (sqrt(matrix.xx * matrix.xx + matrix.yx * matrix.yx)
-            + sqrt(matrix.xy * matrix.xy + matrix.yy * matrix.yy)) / 2;
+    double scale = getPatternScale(cr);
     cairo_matrix_init_scale(&matrix, scale, scale);
 
     double sMin = 0;
@@ -58,18 +95,7 @@ cairo_pattern_t *RadialShading::CreateFillPattern(cairo_t *cr){
             (y0 + sMax * dy) * scale,
             (r0 + sMax * dr) * scale);
 
-    for ( size_t i = 0 ; i < ColorSegments.size() ; i++ ){
-
-        const ColorStop_t &cs = ColorSegments[i];
-        const ColorPtr color = cs.Color;
-        double pos = cs.Offset;
-
-        double r = color->Value.RGB.Red / 255.0;
-        double g = color->Value.RGB.Green / 255.0;
-        double b = color->Value.RGB.Blue / 255.0;
-        double a = color->Alpha / 255.0;
-        cairo_pattern_add_color_stop_rgba(fillPattern, pos, r, g, b, a);
-    } 
+    addColorStops(fillPattern, isRasterTarget(cr));
 
     cairo_pattern_set_matrix(fillPattern, &matrix);
 
@@ -184,6 +210,7 @@ bool RadialShading::ReadShadingXML(utils::XMLElementPtr shadingElement){
     EndPoint = endPoint;
     StartRadius = startRadius;
     EndRadius = endRadius;
+    InvalidateCache();
 
     return true;
 }
@@ -207,6 +234,7 @@ cairo_pattern_t *AxialShading::CreateFillPattern(cairo_t *cr){
     double tMax = 1;
     fillPattern = cairo_pattern_create_linear (x0 + tMin * dx, y0 + tMin * dy,
             x0 + tMax * dx, y0 + tMax * dy);
+    addColorStops(fillPattern, isRasterTarget(cr));
 
     if ( Extend ){
         cairo_pattern_set_extend(fillPattern, CAIRO_EXTEND_PAD);
@@ -301,19 +329,105 @@ bool AxialShading::ReadShadingXML(utils::XMLElementPtr shadingElement){
 
     StartPoint = startPoint;
     EndPoint = endPoint;
+    InvalidateCache();
 
     return true;
 }
 
+void AxialShading::addColorStops(cairo_pattern_t *pattern, bool swapRB) const{
+    for ( const auto &cs : ColorSegments ){
+        if ( cs.Color == nullptr ) continue;
+        double r, g, b, a;
+        std::tie(r, g, b, a) = cs.Color->GetRGBA();
+        // 与纯色填充一致，光栅表面像素的R、B通道互换存放。
+        if ( swapRB ) std::swap(r, b);
+        cairo_pattern_add_color_stop_rgba(pattern, cs.Offset, r, g, b, a);
+    }
+}
+
+void AxialShading::SetColorStops(const ColorStopArray &colorStops){
+    ColorSegments = colorStops;
+    InvalidateCache();
+}
+
+void AxialShading::InvalidateCache(){
+    Shading::InvalidateCache();
+    buildColorRamp();
+}
+
+void AxialShading::buildColorRamp(){
+    m_colorRamp.clear();
+    if ( ColorSegments.empty() ) return;
+
+    ColorStopArray colorStops = ColorSegments;
+    std::stable_sort(colorStops.begin(), colorStops.end(), [](const ColorStop_t &a, const ColorStop_t &b){
+        return a.Offset < b.Offset;
+    });
+
+    m_colorRamp.reserve(RampSize);
+    for ( int i = 0 ; i < RampSize ; i++ ){
+        double r, g, b, a;
+        interpolateColorStops(colorStops, (double)i / (RampSize - 1), r, g, b, a);
+        m_colorRamp.push_back(Color::Instance((uint32_t)lround(r * 255.0), (uint32_t)lround(g * 255.0), (uint32_t)lround(b * 255.0),
+                    ColorSpace::DefaultInstance, (uint32_t)lround(a * 255.0)));
+    }
+}
+
+// ======== AxialShading::GetColor() ========
 ColorPtr AxialShading::GetColor(double offset) const{
-    ColorPtr color = nullptr;
-    for ( auto cs : ColorSegments){
-        if ( cs.Offset >= offset ){
-            color = cs.Color;
-            break;
+    offset = std::min(std::max(offset, 0.0), 1.0);
+    if ( !m_colorRamp.empty() ){
+        return m_colorRamp[(int)(offset * (RampSize - 1) + 0.5)];
+    }
+
+    // 颜色段被直接修改而未调用InvalidateCache()时逐次插值。
+    if ( ColorSegments.empty() ) return nullptr;
+    double r, g, b, a;
+    interpolateColorStops(ColorSegments, offset, r, g, b, a);
+    return Color::Instance((uint32_t)lround(r * 255.0), (uint32_t)lround(g * 255.0), (uint32_t)lround(b * 255.0),
+            ColorSpace::DefaultInstance, (uint32_t)lround(a * 255.0));
+}
+
+// **************** class Shading ****************
+
+Shading::Shading() : Extend(0), m_fillPattern(nullptr), m_fillPatternKey(0.0), m_fillPatternRaster(true){
+}
+
+Shading::~Shading(){
+    if ( m_fillPattern != nullptr ){
+        cairo_pattern_destroy(m_fillPattern);
+        m_fillPattern = nullptr;
+    }
+}
+
+// ======== Shading::GetFillPattern() ========
+cairo_pattern_t *Shading::GetFillPattern(cairo_t *cr){
+    double key = getPatternKey(cr);
+    bool raster = isRasterTarget(cr);
+
+    std::lock_guard<std::mutex> lock(m_patternMutex);
+    if ( m_fillPattern == nullptr || key != m_fillPatternKey || raster != m_fillPatternRaster ){
+        if ( m_fillPattern != nullptr ){
+            cairo_pattern_destroy(m_fillPattern);
         }
+        m_fillPattern = CreateFillPattern(cr);
+        m_fillPatternKey = key;
+        m_fillPatternRaster = raster;
+    }
+    return m_fillPattern != nullptr ? cairo_pattern_reference(m_fillPattern) : nullptr;
+}
+
+// ======== Shading::isRasterTarget() ========
+bool Shading::isRasterTarget(cairo_t *cr){
+    return cairo_surface_get_type(cairo_get_target(cr)) == CAIRO_SURFACE_TYPE_IMAGE;
+}
+
+void Shading::InvalidateCache(){
+    std::lock_guard<std::mutex> lock(m_patternMutex);
+    if ( m_fillPattern != nullptr ){
+        cairo_pattern_destroy(m_fillPattern);
+        m_fillPattern = nullptr;
     }
-    return color;
 }
 
 // ======== Shading::WriteShadingXML() ========
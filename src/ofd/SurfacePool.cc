@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <list>
+#include <mutex>
+#include "ofd/SurfacePool.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// **************** class SurfacePool::ImplCls ****************
+
+class SurfacePool::ImplCls {
+public:
+    ImplCls(size_t maxBytes);
+    ~ImplCls();
+
+    cairo_surface_t *Acquire(cairo_format_t format, int width, int height);
+    void Release(cairo_surface_t *surface);
+    void Clear();
+    void SetMaxBytes(size_t maxBytes);
+
+private:
+    typedef struct Entry{
+        cairo_format_t Format;
+        int Width;
+        int Height;
+        cairo_surface_t *Surface;
+        size_t Bytes;
+    } Entry_t;
+    typedef std::list<Entry> EntryList;
+
+    void evict();
+
+public:
+    mutable std::mutex m_mutex;
+    size_t m_maxBytes;
+    size_t m_idleBytes;
+
+private:
+    EntryList m_entries; // 最近归还的在前
+
+}; // class SurfacePool::ImplCls
+
+SurfacePool::ImplCls::ImplCls(size_t maxBytes) :
+    m_maxBytes(maxBytes), m_idleBytes(0){
+}
+
+SurfacePool::ImplCls::~ImplCls(){
+    Clear();
+}
+
+// ======== SurfacePool::ImplCls::Acquire() ========
+cairo_surface_t *SurfacePool::ImplCls::Acquire(cairo_format_t format, int width, int height){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for ( auto it = m_entries.begin() ; it != m_entries.end() ; it++ ){
+            if ( it->Format == format && it->Width == width && it->Height == height ){
+                cairo_surface_t *surface = it->Surface;
+                m_idleBytes -= it->Bytes;
+                m_entries.erase(it);
+                return surface;
+            }
+        }
+    }
+
+    cairo_surface_t *surface = cairo_image_surface_create(format, width, height);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        LOG(ERROR) << "Create image surface failed. Cairo status: " << cairo_status_to_string(cairo_surface_status(surface));
+    }
+    return surface;
+}
+
+// ======== SurfacePool::ImplCls::Release() ========
+void SurfacePool::ImplCls::Release(cairo_surface_t *surface){
+    if ( surface == nullptr ) return;
+
+    if ( cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE ||
+            cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ||
+            cairo_surface_get_reference_count(surface) != 1 ){
+        cairo_surface_destroy(surface);
+        return;
+    }
+
+    // 复用前恢复借出时的默认状态。
+    cairo_surface_flush(surface);
+    cairo_surface_set_device_offset(surface, 0.0, 0.0);
+
+    Entry entry;
+    entry.Format = cairo_image_surface_get_format(surface);
+    entry.Width = cairo_image_surface_get_width(surface);
+    entry.Height = cairo_image_surface_get_height(surface);
+    entry.Surface = surface;
+    entry.Bytes = (size_t)cairo_image_surface_get_stride(surface) * entry.Height;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_front(entry);
+    m_idleBytes += entry.Bytes;
+    evict();
+}
+
+void SurfacePool::ImplCls::evict(){
+    while ( m_idleBytes > m_maxBytes && !m_entries.empty() ){
+        m_idleBytes -= m_entries.back().Bytes;
+        cairo_surface_destroy(m_entries.back().Surface);
+        m_entries.pop_back();
+    }
+}
+
+void SurfacePool::ImplCls::Clear(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for ( auto &entry : m_entries ){
+        cairo_surface_destroy(entry.Surface);
+    }
+    m_entries.clear();
+    m_idleBytes = 0;
+}
+
+void SurfacePool::ImplCls::SetMaxBytes(size_t maxBytes){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+// **************** class SurfacePool ****************
+
+SurfacePool::SurfacePool(size_t maxBytes) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(maxBytes))){
+}
+
+SurfacePool::~SurfacePool(){
+}
+
+SurfacePool& SurfacePool::GlobalInstance(){
+    static SurfacePool globalInstance;
+    return globalInstance;
+}
+
+cairo_surface_t *SurfacePool::Acquire(cairo_format_t format, int width, int height){
+    return m_impl->Acquire(format, width, height);
+}
+
+void SurfacePool::Release(cairo_surface_t *surface){
+    m_impl->Release(surface);
+}
+
+void SurfacePool::Clear(){
+    m_impl->Clear();
+}
+
+size_t SurfacePool::GetMaxBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_maxBytes;
+}
+
+void SurfacePool::SetMaxBytes(size_t maxBytes){
+    m_impl->SetMaxBytes(maxBytes);
+}
+
+size_t SurfacePool::GetIdleBytes() const{
+    std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+    return m_impl->m_idleBytes;
+}
@@ -0,0 +1,498 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+// ---- freetype ----
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SFNT_NAMES_H
+#include FT_TRUETYPE_IDS_H
+
+#include "ofd/SystemFontIndex.h"
+#include "utils/logger.h"
+#include "utils/unicode.h"
+
+using namespace ofd;
+
+static const char *FontIndexMagic = "OFDFONTINDEX";
+static const int FontIndexVersion = 1;
+
+// 字体标志位
+enum FaceFlags{
+    FaceBold   = 1,
+    FaceItalic = 2,
+    FaceHan    = 4, // 含中日韩统一汉字
+    FaceKana   = 8,
+    FaceHangul = 16,
+};
+static const uint32_t CoverageMask = FaceHan | FaceKana | FaceHangul;
+
+// 名称比较忽略ASCII大小写、空格、'-'和'_'。
+static std::string normalizeName(const std::string &name){
+    std::string key;
+    key.reserve(name.length());
+    for ( char c : name ){
+        if ( c == ' ' || c == '-' || c == '_' ) continue;
+        key.push_back((c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c);
+    }
+    return key;
+}
+
+// OFD字符集要求的字符覆盖。
+static uint32_t getCharsetCoverage(const std::string &charset){
+    std::string key = normalizeName(charset);
+    if ( key == "prc" || key == "big5" || key == "gb2312" || key == "gbk" || key == "gb18030" ){
+        return FaceHan;
+    } else if ( key == "shiftjis" ){
+        return FaceKana;
+    } else if ( key == "wansung" || key == "johab" ){
+        return FaceHangul;
+    }
+    return 0;
+}
+
+static int64_t getDirMTime(const std::string &dirName){
+    struct stat st;
+    if ( stat(dirName.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ){
+        return -1;
+    }
+    return (int64_t)st.st_mtime;
+}
+
+static bool isFontFile(const std::string &fileName){
+    size_t pos = fileName.rfind('.');
+    if ( pos == std::string::npos ) return false;
+    std::string ext = normalizeName(fileName.substr(pos + 1));
+    return ext == "ttf" || ext == "otf" || ext == "ttc" || ext == "otc";
+}
+
+// name表中的名称转为UTF-8。Windows平台为UTF-16BE，Mac Roman按ASCII处理。
+static std::string decodeSfntName(const FT_SfntName &sfntName){
+    std::string name;
+    if ( sfntName.platform_id == TT_PLATFORM_MICROSOFT || sfntName.platform_id == TT_PLATFORM_APPLE_UNICODE ){
+        for ( FT_UInt i = 0 ; i + 1 < sfntName.string_len ; i += 2 ){
+            unsigned long unicode = ((unsigned long)sfntName.string[i] << 8) | sfntName.string[i + 1];
+            unsigned char buf[8];
+            int len = enc_unicode_to_utf8_one(unicode, buf, sizeof(buf));
+            name.append((const char*)buf, len > 0 ? len : 0);
+        }
+    } else if ( sfntName.platform_id == TT_PLATFORM_MACINTOSH && sfntName.encoding_id == TT_MAC_ID_ROMAN ){
+        for ( FT_UInt i = 0 ; i < sfntName.string_len ; i++ ){
+            if ( sfntName.string[i] < 0x80 ) name.push_back((char)sfntName.string[i]);
+        }
+    }
+    return name;
+}
+
+// **************** class SystemFontIndex::ImplCls ****************
+
+class SystemFontIndex::ImplCls {
+public:
+    ImplCls(const std::vector<std::string> &fontDirs, const std::string &cacheFile);
+    ~ImplCls();
+
+    std::tuple<std::string, bool, bool> FindFont(const std::string &name, bool bold, bool italic, const std::string &charset);
+    bool Rebuild();
+    size_t GetNumFaces();
+
+private:
+    typedef struct Face{
+        std::string Path;
+        uint32_t Flags;
+        std::vector<std::string> Names;
+    } Face_t;
+
+    void ensureLoaded();
+    bool loadCache();
+    bool saveCache() const;
+    void scan();
+    void scanDir(FT_Library library, const std::string &dirName, int depth);
+    void addFontFile(FT_Library library, const std::string &fileName);
+    void buildIndex();
+    int selectFace(const std::vector<size_t> &candidates, uint32_t coverage, bool bold, bool italic) const;
+
+    std::vector<std::string> m_fontDirs;
+    std::string m_cacheFile;
+
+    std::mutex m_mutex;
+    bool m_loaded;
+    std::vector<Face> m_faces;
+    std::vector<std::pair<std::string, int64_t> > m_dirs; // 扫描过的目录及修改时间
+
+    std::unordered_map<std::string, std::vector<size_t> > m_nameIndex;
+    // 按(覆盖类别, 风格)预选的替代字体，-1表示没有。
+    int m_fallbacks[4][4];
+
+}; // class SystemFontIndex::ImplCls
+
+SystemFontIndex::ImplCls::ImplCls(const std::vector<std::string> &fontDirs, const std::string &cacheFile) :
+    m_fontDirs(fontDirs), m_cacheFile(cacheFile), m_loaded(false){
+}
+
+SystemFontIndex::ImplCls::~ImplCls(){
+}
+
+void SystemFontIndex::ImplCls::ensureLoaded(){
+    if ( m_loaded ) return;
+    if ( !loadCache() ){
+        scan();
+        saveCache();
+    }
+    buildIndex();
+    m_loaded = true;
+}
+
+// ======== SystemFontIndex::ImplCls::loadCache() ========
+// 缓存中的字体目录列表与当前一致且各目录修改时间未变时有效。
+bool SystemFontIndex::ImplCls::loadCache(){
+    if ( m_cacheFile.empty() ) return false;
+
+    std::ifstream ifile(m_cacheFile);
+    if ( !ifile.is_open() ) return false;
+
+    std::string line;
+    if ( !std::getline(ifile, line) || line != std::string(FontIndexMagic) + "\t" + std::to_string(FontIndexVersion) ){
+        return false;
+    }
+
+    std::vector<std::string> roots;
+    std::vector<std::pair<std::string, int64_t> > dirs;
+    std::vector<Face> faces;
+    while ( std::getline(ifile, line) ){
+        std::vector<std::string> fields;
+        std::string field;
+        std::istringstream iss(line);
+        while ( std::getline(iss, field, '\t') ){
+            fields.push_back(field);
+        }
+        if ( fields.empty() ) continue;
+
+        if ( fields[0] == "R" && fields.size() == 2 ){
+            roots.push_back(fields[1]);
+        } else if ( fields[0] == "D" && fields.size() == 3 ){
+            int64_t mtime = strtoll(fields[1].c_str(), nullptr, 10);
+            if ( getDirMTime(fields[2]) != mtime ){
+                LOG(INFO) << "Font directory " << fields[2] << " changed, rebuild font index.";
+                return false;
+            }
+            dirs.push_back(std::make_pair(fields[2], mtime));
+        } else if ( fields[0] == "F" && fields.size() >= 3 ){
+            Face face;
+            face.Flags = (uint32_t)strtoul(fields[1].c_str(), nullptr, 10);
+            face.Path = fields[2];
+            face.Names.assign(fields.begin() + 3, fields.end());
+            faces.push_back(face);
+        } else {
+            LOG(WARNING) << "Invalid font index line in " << m_cacheFile;
+            return false;
+        }
+    }
+    if ( roots != m_fontDirs ) return false;
+
+    m_dirs.swap(dirs);
+    m_faces.swap(faces);
+    LOG(DEBUG) << "Load font index " << m_cacheFile << ": " << m_faces.size() << " faces.";
+    return true;
+}
+
+// ======== SystemFontIndex::ImplCls::saveCache() ========
+// 先写入临时文件再改名，并发启动的进程不会读到不完整的缓存。
+bool SystemFontIndex::ImplCls::saveCache() const{
+    if ( m_cacheFile.empty() ) return false;
+
+    // 逐级创建缓存目录。
+    for ( size_t pos = m_cacheFile.find('/', 1) ; pos != std::string::npos ; pos = m_cacheFile.find('/', pos + 1) ){
+        std::string dirName = m_cacheFile.substr(0, pos);
+        if ( mkdir(dirName.c_str(), 0755) != 0 && errno != EEXIST ){
+            LOG(WARNING) << "Create font index directory " << dirName << " failed.";
+            return false;
+        }
+    }
+
+    std::string tmpFile = m_cacheFile + "." + std::to_string(getpid());
+    {
+        std::ofstream ofile(tmpFile, std::ios::trunc);
+        if ( !ofile.is_open() ){
+            LOG(WARNING) << "Write font index " << tmpFile << " failed.";
+            return false;
+        }
+        ofile << FontIndexMagic << "\t" << FontIndexVersion << "\n";
+        for ( auto &root : m_fontDirs ){
+            ofile << "R\t" << root << "\n";
+        }
+        for ( auto &dir : m_dirs ){
+            ofile << "D\t" << dir.second << "\t" << dir.first << "\n";
+        }
+        for ( auto &face : m_faces ){
+            ofile << "F\t" << face.Flags << "\t" << face.Path;
+            for ( auto &name : face.Names ){
+                ofile << "\t" << name;
+            }
+            ofile << "\n";
+        }
+        if ( !ofile.good() ){
+            unlink(tmpFile.c_str());
+            return false;
+        }
+    }
+    if ( rename(tmpFile.c_str(), m_cacheFile.c_str()) != 0 ){
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ======== SystemFontIndex::ImplCls::scan() ========
+void SystemFontIndex::ImplCls::scan(){
+    m_faces.clear();
+    m_dirs.clear();
+
+    FT_Library library = nullptr;
+    if ( FT_Init_FreeType(&library) != 0 ){
+        LOG(ERROR) << "FT_Init_FreeType() in SystemFontIndex::scan() failed.";
+        return;
+    }
+    for ( auto &fontDir : m_fontDirs ){
+        scanDir(library, fontDir, 0);
+    }
+    FT_Done_FreeType(library);
+
+    // 按路径排序，替代字体的选择与扫描顺序无关。
+    std::sort(m_faces.begin(), m_faces.end(), [](const Face &a, const Face &b){return a.Path < b.Path;});
+    LOG(INFO) << "Scan system fonts: " << m_faces.size() << " faces in " << m_dirs.size() << " directories.";
+}
+
+void SystemFontIndex::ImplCls::scanDir(FT_Library library, const std::string &dirName, int depth){
+    // 不存在的目录也记录下来，日后出现时重新扫描。
+    m_dirs.push_back(std::make_pair(dirName, getDirMTime(dirName)));
+    if ( m_dirs.back().second < 0 || depth > 16 ) return;
+
+    DIR *dir = opendir(dirName.c_str());
+    if ( dir == nullptr ) return;
+
+    std::vector<std::string> subDirs;
+    struct dirent *dirEntry = nullptr;
+    while ( (dirEntry = readdir(dir)) != nullptr ){
+        if ( dirEntry->d_name[0] == '.' ) continue;
+        std::string path = dirName + "/" + dirEntry->d_name;
+        struct stat st;
+        if ( stat(path.c_str(), &st) != 0 ) continue;
+        if ( S_ISDIR(st.st_mode) ){
+            subDirs.push_back(path);
+        } else if ( S_ISREG(st.st_mode) && isFontFile(path) ){
+            addFontFile(library, path);
+        }
+    }
+    closedir(dir);
+
+    for ( auto &subDir : subDirs ){
+        scanDir(library, subDir, depth + 1);
+    }
+}
+
+void SystemFontIndex::ImplCls::addFontFile(FT_Library library, const std::string &fileName){
+    FT_Face ftFace = nullptr;
+    if ( FT_New_Face(library, fileName.c_str(), 0, &ftFace) != 0 ){
+        LOG(DEBUG) << "FT_New_Face() failed: " << fileName;
+        return;
+    }
+
+    Face face;
+    face.Path = fileName;
+    face.Flags = 0;
+    if ( ftFace->style_flags & FT_STYLE_FLAG_BOLD ) face.Flags |= FaceBold;
+    if ( ftFace->style_flags & FT_STYLE_FLAG_ITALIC ) face.Flags |= FaceItalic;
+    if ( FT_Get_Char_Index(ftFace, 0x4E2D) != 0 ) face.Flags |= FaceHan;    // 中
+    if ( FT_Get_Char_Index(ftFace, 0x3042) != 0 ) face.Flags |= FaceKana;   // あ
+    if ( FT_Get_Char_Index(ftFace, 0xAC00) != 0 ) face.Flags |= FaceHangul; // 가
+
+    std::vector<std::string> names;
+    if ( ftFace->family_name != nullptr ){
+        names.push_back(ftFace->family_name);
+        if ( ftFace->style_name != nullptr ){
+            names.push_back(std::string(ftFace->family_name) + " " + ftFace->style_name);
+        }
+    }
+    const char *postscriptName = FT_Get_Postscript_Name(ftFace);
+    if ( postscriptName != nullptr ){
+        names.push_back(postscriptName);
+    }
+    // 家族名、全名、PostScript名及其本地化名称，如“宋体”。
+    FT_UInt numNames = FT_Get_Sfnt_Name_Count(ftFace);
+    for ( FT_UInt i = 0 ; i < numNames ; i++ ){
+        FT_SfntName sfntName;
+        if ( FT_Get_Sfnt_Name(ftFace, i, &sfntName) != 0 ) continue;
+        if ( sfntName.name_id != TT_NAME_ID_FONT_FAMILY && sfntName.name_id != TT_NAME_ID_FULL_NAME &&
+                sfntName.name_id != TT_NAME_ID_PS_NAME && sfntName.name_id != TT_NAME_ID_PREFERRED_FAMILY ){
+            continue;
+        }
+        names.push_back(decodeSfntName(sfntName));
+    }
+    FT_Done_Face(ftFace);
+
+    for ( auto &name : names ){
+        std::replace(name.begin(), name.end(), '\t', ' ');
+        std::replace(name.begin(), name.end(), '\n', ' ');
+        if ( !name.empty() && std::find(face.Names.begin(), face.Names.end(), name) == face.Names.end() ){
+            face.Names.push_back(name);
+        }
+    }
+    m_faces.push_back(face);
+}
+
+void SystemFontIndex::ImplCls::buildIndex(){
+    m_nameIndex.clear();
+    for ( size_t i = 0 ; i < m_faces.size() ; i++ ){
+        for ( auto &name : m_faces[i].Names ){
+            std::vector<size_t> &candidates = m_nameIndex[normalizeName(name)];
+            if ( candidates.empty() || candidates.back() != i ){
+                candidates.push_back(i);
+            }
+        }
+    }
+
+    // 覆盖类别0（未指定字符集）以含汉字的字体替代。
+    const uint32_t coverages[4] = {FaceHan, FaceHan, FaceKana, FaceHangul};
+    std::vector<size_t> allFaces(m_faces.size());
+    for ( size_t i = 0 ; i < allFaces.size() ; i++ ) allFaces[i] = i;
+    for ( int c = 0 ; c < 4 ; c++ ){
+        for ( int style = 0 ; style < 4 ; style++ ){
+            m_fallbacks[c][style] = selectFace(allFaces, coverages[c], (style & FaceBold) != 0, (style & FaceItalic) != 0);
+            if ( c == 0 && m_fallbacks[c][style] < 0 ){
+                m_fallbacks[c][style] = selectFace(allFaces, 0, (style & FaceBold) != 0, (style & FaceItalic) != 0);
+            }
+        }
+    }
+}
+
+// 在支持coverage的候选中选择风格最接近的字体，相同时取靠前的。
+int SystemFontIndex::ImplCls::selectFace(const std::vector<size_t> &candidates, uint32_t coverage, bool bold, bool italic) const{
+    int best = -1;
+    int bestScore = -1;
+    for ( auto i : candidates ){
+        const Face &face = m_faces[i];
+        if ( (face.Flags & coverage) != coverage ) continue;
+        int score = (((face.Flags & FaceBold) != 0) == bold ? 2 : 0) + (((face.Flags & FaceItalic) != 0) == italic ? 1 : 0);
+        if ( score > bestScore ){
+            best = (int)i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// ======== SystemFontIndex::ImplCls::FindFont() ========
+std::tuple<std::string, bool, bool> SystemFontIndex::ImplCls::FindFont(const std::string &name, bool bold, bool italic, const std::string &charset){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ensureLoaded();
+
+    uint32_t coverage = getCharsetCoverage(charset);
+    // 去掉子集字体名的"ABCDEF+"前缀。
+    std::string fontName = name;
+    if ( fontName.length() > 7 && fontName[6] == '+' &&
+            std::all_of(fontName.begin(), fontName.begin() + 6, [](char c){return c >= 'A' && c <= 'Z';}) ){
+        fontName = fontName.substr(7);
+    }
+    auto it = m_nameIndex.find(normalizeName(fontName));
+    if ( it != m_nameIndex.end() ){
+        int index = selectFace(it->second, coverage, bold, italic);
+        if ( index >= 0 ){
+            return std::make_tuple(m_faces[index].Path, false, true);
+        }
+    }
+
+    int c = coverage == FaceHan ? 1 : coverage == FaceKana ? 2 : coverage == FaceHangul ? 3 : 0;
+    int index = m_fallbacks[c][(bold ? FaceBold : 0) | (italic ? FaceItalic : 0)];
+    if ( index >= 0 ){
+        return std::make_tuple(m_faces[index].Path, true, true);
+    }
+    return std::make_tuple(std::string(), false, false);
+}
+
+bool SystemFontIndex::ImplCls::Rebuild(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    scan();
+    bool ok = saveCache();
+    buildIndex();
+    m_loaded = true;
+    return ok;
+}
+
+size_t SystemFontIndex::ImplCls::GetNumFaces(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ensureLoaded();
+    return m_faces.size();
+}
+
+// **************** class SystemFontIndex ****************
+
+SystemFontIndex::SystemFontIndex(const std::vector<std::string> &fontDirs, const std::string &cacheFile) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(fontDirs, cacheFile))){
+}
+
+SystemFontIndex::~SystemFontIndex(){
+}
+
+SystemFontIndex& SystemFontIndex::GlobalInstance(){
+    static SystemFontIndex globalInstance(DefaultFontDirs(), DefaultCacheFile());
+    return globalInstance;
+}
+
+std::vector<std::string> SystemFontIndex::DefaultFontDirs(){
+    std::vector<std::string> fontDirs;
+#if defined(__APPLE__)
+    fontDirs.push_back("/System/Library/Fonts");
+    fontDirs.push_back("/Library/Fonts");
+#else
+    fontDirs.push_back("/usr/share/fonts");
+    fontDirs.push_back("/usr/local/share/fonts");
+#endif
+    const char *home = getenv("HOME");
+    if ( home != nullptr && home[0] != '\0' ){
+#if defined(__APPLE__)
+        fontDirs.push_back(std::string(home) + "/Library/Fonts");
+#else
+        fontDirs.push_back(std::string(home) + "/.fonts");
+        fontDirs.push_back(std::string(home) + "/.local/share/fonts");
+#endif
+    }
+    return fontDirs;
+}
+
+std::string SystemFontIndex::DefaultCacheFile(){
+    const char *indexFile = getenv("OFD_FONT_INDEX");
+    if ( indexFile != nullptr && indexFile[0] != '\0' ){
+        return indexFile;
+    }
+    const char *cacheHome = getenv("XDG_CACHE_HOME");
+    if ( cacheHome != nullptr && cacheHome[0] == '/' ){
+        return std::string(cacheHome) + "/libofd/fontindex";
+    }
+    const char *home = getenv("HOME");
+    if ( home != nullptr && home[0] == '/' ){
+        return std::string(home) + "/.cache/libofd/fontindex";
+    }
+    return "/tmp/libofd-fontindex-" + std::to_string(getuid());
+}
+
+std::tuple<std::string, bool, bool> SystemFontIndex::FindFont(const std::string &name, bool bold, bool italic,
+        const std::string &charset) const{
+    return m_impl->FindFont(name, bold, italic, charset);
+}
+
+bool SystemFontIndex::Rebuild(){
+    return m_impl->Rebuild();
+}
+
+size_t SystemFontIndex::GetNumFaces() const{
+    return m_impl->GetNumFaces();
+}
@@ -0,0 +1,382 @@
+#include <assert.h>
+#include <math.h>
+#include <list>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include "ofd/TileCache.h"
+#include "ofd/CairoRender.h"
+#include "ofd/Page.h"
+#include "ofd/SurfacePool.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 缩放比例量化为整数作为键。
+static inline int64_t getScaleKey(double scaling){
+    return (int64_t)llround(scaling * 10000.0);
+}
+
+// **************** class TileCache::ImplCls ****************
+
+class TileCache::ImplCls {
+public:
+    ImplCls(double resolutionX, double resolutionY, int tileSize, size_t maxBytes);
+    ~ImplCls();
+
+    size_t DrawViewport(cairo_t *cr, PagePtr page, VisibleParams visibleParams, int viewWidth, int viewHeight, size_t maxRenderTiles, const DrawControl &drawControl);
+    void InvalidatePage(PagePtr page);
+    void Clear();
+    void SetMaxBytes(size_t maxBytes);
+
+private:
+    // 页面以weak_ptr的控制块区分。缓存项持有weak_ptr时控制块不会释放，
+    // 页面释放后新建的页面即使地址相同也不会命中旧的块。
+    // 绘制质量不同的块内容不同，Quality也是键的一部分。
+    typedef struct TileKey{
+        std::weak_ptr<Page> PageRef;
+        RenderQuality Quality;
+        int64_t Scale;
+        int X;
+        int Y;
+
+        TileKey(const PagePtr &page, RenderQuality quality, int64_t scale, int x, int y) :
+            PageRef(page), Quality(quality), Scale(scale), X(x), Y(y){
+        }
+
+        // 同一页面的块中排在最前的键。
+        static TileKey First(const PagePtr &page){
+            return TileKey(page, RenderQuality::Normal, std::numeric_limits<int64_t>::min(),
+                    std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+        }
+
+        bool IsSamePage(const PagePtr &page) const {
+            return !PageRef.owner_before(page) && !page.owner_before(PageRef);
+        }
+
+        bool operator <(const TileKey &other) const {
+            if ( PageRef.owner_before(other.PageRef) ) return true;
+            if ( other.PageRef.owner_before(PageRef) ) return false;
+            return std::tie(Quality, Scale, Y, X) < std::tie(other.Quality, other.Scale, other.Y, other.X);
+        }
+    } TileKey_t;
+    typedef std::list<TileKey> KeyList;
+
+    typedef struct Entry{
+        cairo_surface_t *Surface;
+        size_t Bytes;
+        KeyList::iterator LRUPos;
+    } Entry_t;
+    typedef std::map<TileKey, Entry> EntryMap;
+
+    cairo_surface_t *lookup(const TileKey &key, bool touch);
+    cairo_surface_t *insert(const TileKey &key, cairo_surface_t *surface);
+    void evict();
+    void erase(EntryMap::iterator it);
+
+    cairo_surface_t *renderTile(PagePtr page, double scaling, int tileX, int tileY, const DrawControl &drawControl);
+    int64_t findFallbackScale(const PagePtr &page, RenderQuality quality, int64_t scaleKey) const;
+    void drawFallbackTile(cairo_t *cr, const PagePtr &page, RenderQuality quality, double scaling, int64_t fallbackScaleKey,
+            int tileX, int tileY, double offsetX, double offsetY);
+
+public:
+    DrawState& GetDrawState(){return m_render->GetDrawState();};
+
+    double m_resolutionX;
+    double m_resolutionY;
+    int m_tileSize;
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+
+private:
+    std::unique_ptr<CairoRender> m_render; // 按块大小绘制页面的Render
+    EntryMap m_entries;
+    KeyList m_lru;
+
+}; // class TileCache::ImplCls
+
+TileCache::ImplCls::ImplCls(double resolutionX, double resolutionY, int tileSize, size_t maxBytes) :
+    m_resolutionX(resolutionX), m_resolutionY(resolutionY),
+    m_tileSize(tileSize), m_maxBytes(maxBytes), m_usedBytes(0){
+
+    m_render = std::unique_ptr<CairoRender>(new CairoRender(tileSize, tileSize, resolutionX, resolutionY));
+}
+
+TileCache::ImplCls::~ImplCls(){
+    Clear();
+}
+
+// ======== TileCache::ImplCls::DrawViewport() ========
+size_t TileCache::ImplCls::DrawViewport(cairo_t *cr, PagePtr page, VisibleParams visibleParams, int viewWidth, int viewHeight, size_t maxRenderTiles, const DrawControl &drawControl){
+    if ( cr == nullptr || page == nullptr ) return 0;
+
+    double pixelX, pixelY, scaling;
+    std::tie(pixelX, pixelY, scaling) = visibleParams;
+    if ( scaling <= 0.0 ) return 0;
+
+    double kx = m_resolutionX / 72.0;
+    double ky = m_resolutionY / 72.0;
+
+    // 视口原点在页面设备空间中的位置。
+    double offsetX = kx * pixelX;
+    double offsetY = ky * pixelY;
+
+    // 页面在设备空间中的大小。
+    double pageWidth = std::max(page->Area.ApplicationBox.Width, page->Area.PhysicalBox.Width) * kx * scaling;
+    double pageHeight = std::max(page->Area.ApplicationBox.Height, page->Area.PhysicalBox.Height) * ky * scaling;
+
+    int T = m_tileSize;
+    int tileX0 = std::max(0, (int)floor(offsetX / T));
+    int tileY0 = std::max(0, (int)floor(offsetY / T));
+    int tileX1 = std::min((int)ceil(pageWidth / T) - 1, (int)floor((offsetX + viewWidth - 1) / T));
+    int tileY1 = std::min((int)ceil(pageHeight / T) - 1, (int)floor((offsetY + viewHeight - 1) / T));
+
+    int64_t scaleKey = getScaleKey(scaling);
+    RenderQuality quality = m_render->GetRenderQuality();
+    int64_t fallbackScaleKey = -1;
+    bool fallbackSearched = false;
+
+    size_t numRendered = 0;
+    size_t numMissing = 0;
+
+    cairo_save(cr);
+    for ( int ty = tileY0 ; ty <= tileY1 ; ty++ ){
+        for ( int tx = tileX0 ; tx <= tileX1 ; tx++ ){
+            double destX = tx * T - offsetX;
+            double destY = ty * T - offsetY;
+
+            TileKey key(page, quality, scaleKey, tx, ty);
+            cairo_surface_t *tile = lookup(key, true);
+            if ( tile == nullptr && numRendered < maxRenderTiles && !drawControl.IsAborted() ){
+                tile = renderTile(page, scaling, tx, ty, drawControl);
+                numRendered++;
+                if ( tile != nullptr ){
+                    tile = insert(key, tile);
+                }
+            }
+
+            if ( tile != nullptr ){
+                cairo_set_source_surface(cr, tile, destX, destY);
+                cairo_rectangle(cr, destX, destY, T, T);
+                cairo_fill(cr);
+                cairo_surface_destroy(tile);
+            } else {
+                // 暂以其它缩放比例下的缓存块代替。
+                if ( !fallbackSearched ){
+                    fallbackScaleKey = findFallbackScale(page, quality, scaleKey);
+                    fallbackSearched = true;
+                }
+                if ( fallbackScaleKey > 0 ){
+                    drawFallbackTile(cr, page, quality, scaling, fallbackScaleKey, tx, ty, offsetX, offsetY);
+                }
+                numMissing++;
+            }
+        }
+    }
+    cairo_restore(cr);
+
+    return numMissing;
+}
+
+// ======== TileCache::ImplCls::renderTile() ========
+cairo_surface_t *TileCache::ImplCls::renderTile(PagePtr page, double scaling, int tileX, int tileY, const DrawControl &drawControl){
+    cairo_t *renderCr = m_render->GetCairoContext();
+    cairo_surface_t *renderSurface = m_render->GetCairoSurface();
+    if ( renderCr == nullptr || renderSurface == nullptr ) return nullptr;
+
+    // DrawPage()对空页面不会重绘背景，先清除上一块的内容。
+    cairo_save(renderCr);
+    cairo_identity_matrix(renderCr);
+    cairo_set_source_rgb(renderCr, 1.0, 1.0, 1.0);
+    cairo_paint(renderCr);
+    cairo_restore(renderCr);
+
+    double pixelX = tileX * m_tileSize * 72.0 / m_resolutionX;
+    double pixelY = tileY * m_tileSize * 72.0 / m_resolutionY;
+    m_render->SaveState();
+    bool completed = m_render->DrawPage(page, std::make_tuple(pixelX, pixelY, scaling), drawControl);
+    m_render->RestoreState();
+    if ( !completed ) return nullptr;
+    cairo_surface_flush(renderSurface);
+
+    // 淘汰的块归还表面池，新块优先复用。
+    cairo_surface_t *tile = SurfacePool::GlobalInstance().Acquire(CAIRO_FORMAT_RGB24, m_tileSize, m_tileSize);
+    if ( cairo_surface_status(tile) != CAIRO_STATUS_SUCCESS ){
+        cairo_surface_destroy(tile);
+        return nullptr;
+    }
+    cairo_t *tileCr = cairo_create(tile);
+    cairo_set_operator(tileCr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(tileCr, renderSurface, 0, 0);
+    cairo_paint(tileCr);
+    cairo_destroy(tileCr);
+
+    return tile;
+}
+
+// 在缓存中找出同一绘制质量下与scaleKey最接近（按比例）的其它缩放比例，没有则返回-1。
+int64_t TileCache::ImplCls::findFallbackScale(const PagePtr &page, RenderQuality quality, int64_t scaleKey) const{
+    int64_t bestScaleKey = -1;
+    double bestDistance = std::numeric_limits<double>::max();
+
+    for ( auto it = m_entries.lower_bound(TileKey::First(page)) ; it != m_entries.end() && it->first.IsSamePage(page) ; ++it ){
+        if ( it->first.Quality != quality ) continue;
+        int64_t s = it->first.Scale;
+        if ( s <= 0 || s == scaleKey ) continue;
+        double distance = fabs(log((double)s / (double)scaleKey));
+        if ( distance < bestDistance ){
+            bestDistance = distance;
+            bestScaleKey = s;
+        }
+    }
+    return bestScaleKey;
+}
+
+// 将fallbackScaleKey缩放比例下覆盖块(tileX, tileY)的缓存块拉伸绘制到该块位置。
+void TileCache::ImplCls::drawFallbackTile(cairo_t *cr, const PagePtr &page, RenderQuality quality, double scaling, int64_t fallbackScaleKey,
+        int tileX, int tileY, double offsetX, double offsetY){
+    int T = m_tileSize;
+    double ratio = scaling / ((double)fallbackScaleKey / 10000.0);
+
+    int x0 = (int)floor(tileX * T / ratio / T);
+    int y0 = (int)floor(tileY * T / ratio / T);
+    int x1 = (int)floor(((tileX + 1) * T / ratio - 1e-6) / T);
+    int y1 = (int)floor(((tileY + 1) * T / ratio - 1e-6) / T);
+
+    double destX = tileX * T - offsetX;
+    double destY = tileY * T - offsetY;
+
+    for ( int y = y0 ; y <= y1 ; y++ ){
+        for ( int x = x0 ; x <= x1 ; x++ ){
+            cairo_surface_t *tile = lookup(TileKey(page, quality, fallbackScaleKey, x, y), false);
+            if ( tile == nullptr ) continue;
+
+            cairo_save(cr);
+            cairo_rectangle(cr, destX, destY, T, T);
+            cairo_clip(cr);
+            cairo_translate(cr, -offsetX, -offsetY);
+            cairo_scale(cr, ratio, ratio);
+            cairo_set_source_surface(cr, tile, x * T, y * T);
+            cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+            cairo_rectangle(cr, x * T, y * T, T, T);
+            cairo_fill(cr);
+            cairo_restore(cr);
+
+            cairo_surface_destroy(tile);
+        }
+    }
+}
+
+// 命中时返回增加了引用计数的表面。
+cairo_surface_t *TileCache::ImplCls::lookup(const TileKey &key, bool touch){
+    auto it = m_entries.find(key);
+    if ( it == m_entries.end() ) return nullptr;
+    if ( touch ){
+        m_lru.splice(m_lru.begin(), m_lru, it->second.LRUPos);
+    }
+    return cairo_surface_reference(it->second.Surface);
+}
+
+// 接管surface的引用，返回增加了引用计数的表面。
+cairo_surface_t *TileCache::ImplCls::insert(const TileKey &key, cairo_surface_t *surface){
+    auto it = m_entries.find(key);
+    if ( it != m_entries.end() ){
+        erase(it);
+    }
+
+    m_lru.push_front(key);
+    Entry entry;
+    entry.Surface = surface;
+    entry.Bytes = (size_t)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+    entry.LRUPos = m_lru.begin();
+    m_entries.insert(EntryMap::value_type(key, entry));
+    m_usedBytes += entry.Bytes;
+
+    evict();
+
+    return cairo_surface_reference(surface);
+}
+
+void TileCache::ImplCls::evict(){
+    // 至少保留最近使用的一项。
+    while ( m_usedBytes > m_maxBytes && m_lru.size() > 1 ){
+        auto it = m_entries.find(m_lru.back());
+        assert(it != m_entries.end());
+        erase(it);
+    }
+}
+
+void TileCache::ImplCls::erase(EntryMap::iterator it){
+    m_usedBytes -= it->second.Bytes;
+    m_lru.erase(it->second.LRUPos);
+    SurfacePool::GlobalInstance().Release(it->second.Surface);
+    m_entries.erase(it);
+}
+
+void TileCache::ImplCls::InvalidatePage(PagePtr page){
+    auto it = m_entries.lower_bound(TileKey::First(page));
+    while ( it != m_entries.end() && it->first.IsSamePage(page) ){
+        auto cur = it++;
+        erase(cur);
+    }
+}
+
+void TileCache::ImplCls::Clear(){
+    for ( auto &kv : m_entries ){
+        SurfacePool::GlobalInstance().Release(kv.second.Surface);
+    }
+    m_entries.clear();
+    m_lru.clear();
+    m_usedBytes = 0;
+}
+
+void TileCache::ImplCls::SetMaxBytes(size_t maxBytes){
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+// **************** class TileCache ****************
+
+TileCache::TileCache(double resolutionX, double resolutionY, int tileSize, size_t maxBytes) :
+    m_impl(std::unique_ptr<ImplCls>(new ImplCls(resolutionX, resolutionY, tileSize, maxBytes))){
+}
+
+TileCache::~TileCache(){
+}
+
+size_t TileCache::DrawViewport(cairo_t *cr, PagePtr page, VisibleParams visibleParams,
+        int viewWidth, int viewHeight, size_t maxRenderTiles, const DrawControl &drawControl){
+    return m_impl->DrawViewport(cr, page, visibleParams, viewWidth, viewHeight, maxRenderTiles, drawControl);
+}
+
+void TileCache::InvalidatePage(PagePtr page){
+    m_impl->InvalidatePage(page);
+}
+
+void TileCache::Clear(){
+    m_impl->Clear();
+}
+
+const DrawState& TileCache::GetDrawState() const{
+    return m_impl->GetDrawState();
+}
+
+DrawState& TileCache::GetDrawState(){
+    return m_impl->GetDrawState();
+}
+
+int TileCache::GetTileSize() const{
+    return m_impl->m_tileSize;
+}
+
+size_t TileCache::GetMaxBytes() const{
+    return m_impl->m_maxBytes;
+}
+
+void TileCache::SetMaxBytes(size_t maxBytes){
+    m_impl->SetMaxBytes(maxBytes);
+}
+
+size_t TileCache::GetUsedBytes() const{
+    return m_impl->m_usedBytes;
+}
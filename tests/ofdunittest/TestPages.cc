@@ -0,0 +1,33 @@
+#include "TestPages.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/Layer.h"
+#include "ofd/Path.h"
+#include "ofd/PathObject.h"
+
+using namespace ofd;
+
+PagePtr ofd::CreateColorBarsPage(DocumentPtr document, const std::vector<ColorPtr> &colors){
+    PagePtr page = document->AddNewPage();
+    page->Area.PhysicalBox = ST_Box(0.0, 0.0, BarWidth * colors.size(), BarHeight);
+    page->Area.ApplicationBox = page->Area.PhysicalBox;
+    LayerPtr layer = page->AddNewLayer(LayerType::BODY);
+
+    for ( size_t i = 0 ; i < colors.size() ; i++ ){
+        double x0 = BarWidth * i;
+        double x1 = x0 + BarWidth;
+        PathPtr path = std::make_shared<Path>();
+        path->MoveTo(Point_t(x0, 0.0));
+        path->LineTo(Point_t(x1, 0.0));
+        path->LineTo(Point_t(x1, BarHeight));
+        path->LineTo(Point_t(x0, BarHeight));
+        path->ClosePath();
+
+        PathObjectPtr pathObject = std::make_shared<PathObject>(layer);
+        pathObject->SetPath(path);
+        pathObject->SetFillColor(colors[i]);
+        layer->AddObject(pathObject);
+    }
+
+    return page;
+}
@@ -0,0 +1,19 @@
+#ifndef __OFD_TESTPAGES_H__
+#define __OFD_TESTPAGES_H__
+
+#include <vector>
+#include "ofd/Common.h"
+#include "ofd/Color.h"
+
+namespace ofd{
+
+    // 色条测试页：页面高BarHeight毫米，colors中每种颜色填充一个宽BarWidth毫米的矩形，
+    // 从左至右排列。第i个色条的中心位于((i + 0.5) * BarWidth, BarHeight / 2)。
+    static const double BarWidth = 20.0;
+    static const double BarHeight = 20.0;
+
+    PagePtr CreateColorBarsPage(DocumentPtr document, const std::vector<ColorPtr> &colors);
+
+}; // namespace ofd
+
+#endif // __OFD_TESTPAGES_H__
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "utils/logger.h"
+
+// 不依赖外部文件的单元测试，由ctest运行，任一测试失败时返回非0。
+// 测试函数在各test_*.cc中定义，失败时以LOG(ERROR)输出原因。
+
+bool test_gray_render_colors();
+bool test_vector_render_colors();
+bool test_color_convert_simd();
+
+typedef struct UnitTest{
+    std::string Name;
+    std::function<bool()> Func;
+} UnitTest_t;
+
+int main(int argc, char *argv[]){
+    Logger::Initialize(0);
+
+    std::vector<UnitTest> unitTests = {
+        {"gray_render_colors", test_gray_render_colors},
+        {"vector_render_colors", test_vector_render_colors},
+        {"color_convert_simd", test_color_convert_simd},
+    };
+
+    int numFailed = 0;
+    for ( auto &unitTest : unitTests ){
+        bool ok = unitTest.Func();
+        std::cout << (ok ? "[PASS] " : "[FAIL] ") << unitTest.Name << std::endl;
+        if ( !ok ) numFailed++;
+    }
+    std::cout << unitTests.size() - numFailed << "/" << unitTests.size() << " tests passed." << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
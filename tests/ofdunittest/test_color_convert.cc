@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "ofd/ColorConvert.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+typedef void (*ConvertFunc)(const uint8_t *src, uint32_t *dst, size_t n);
+
+// 分别以标量和SIMD实现转换同一组随机像素，结果应完全一致。
+// 像素数取非4的倍数，覆盖SIMD循环之后的标量尾部。
+static bool compareSIMDAndScalar(const char *name, ConvertFunc convert, int numComps){
+    const size_t n = 1027;
+    std::vector<uint8_t> src(n * numComps);
+    for ( auto &v : src ){
+        v = (uint8_t)(rand() & 0xff);
+    }
+    std::vector<uint32_t> scalarPixels(n), simdPixels(n);
+
+    bool simd = IsColorConvertSIMDEnabled();
+    SetColorConvertSIMD(false);
+    convert(src.data(), scalarPixels.data(), n);
+    SetColorConvertSIMD(true);
+    convert(src.data(), simdPixels.data(), n);
+    SetColorConvertSIMD(simd);
+
+    for ( size_t i = 0 ; i < n ; i++ ){
+        if ( scalarPixels[i] != simdPixels[i] ){
+            LOG(ERROR) << name << " SIMD result differs from scalar at " << i << ": "
+                << std::hex << simdPixels[i] << " != " << scalarPixels[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+static void premultiply(const uint8_t *src, uint32_t *dst, size_t n){
+    memcpy(dst, src, n * sizeof(uint32_t));
+    PremultiplyARGB32(dst, n);
+}
+
+// 转换结果应与绘制表面的通道顺序一致：纯红的R在最低字节。
+bool test_color_convert_simd(){
+    srand(20170613);
+    bool ok = compareSIMDAndScalar("Gray", ConvertGrayToARGB32, 1) &&
+        compareSIMDAndScalar("CMYK", ConvertCMYKToARGB32, 4) &&
+        compareSIMDAndScalar("Premultiply", premultiply, 4);
+    if ( !ok ) return false;
+
+    const uint8_t rgb[3] = {255, 0, 0};
+    const uint8_t cmyk[4] = {0, 255, 255, 0};
+    uint32_t red = packSurfacePixel(0xff, 255, 0, 0);
+    bool simdEnabled = IsColorConvertSIMDEnabled();
+    for ( bool simd : {false, true} ){
+        SetColorConvertSIMD(simd);
+        std::vector<uint32_t> pixels(8);
+        ConvertRGBToARGB32(rgb, &pixels[0], 1);
+        std::vector<uint8_t> cmykRow;
+        for ( int i = 0 ; i < 4 ; i++ ){
+            cmykRow.insert(cmykRow.end(), cmyk, cmyk + 4);
+        }
+        ConvertCMYKToARGB32(cmykRow.data(), &pixels[1], 4);
+        for ( size_t i = 0 ; i < 5 ; i++ ){
+            if ( pixels[i] != red ){
+                LOG(ERROR) << "Pure red converted to " << std::hex << pixels[i] << ", expected " << red
+                    << (simd ? " (SIMD)" : " (scalar)");
+                ok = false;
+            }
+        }
+    }
+    SetColorConvertSIMD(simdEnabled);
+    return ok;
+}
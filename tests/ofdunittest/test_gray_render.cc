@@ -0,0 +1,38 @@
+#include <stdlib.h>
+#include "TestPages.h"
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/GrayRender.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 纯红、纯蓝色条的灰度应为0.3*255和0.11*255，R、B通道读反时两者互换。
+bool test_gray_render_colors(){
+    PackagePtr package = std::make_shared<Package>();
+    DocumentPtr document = package->AddNewDocument();
+    PagePtr page = CreateColorBarsPage(document, {Color::Instance(255, 0, 0), Color::Instance(0, 0, 255)});
+
+    // 72 DPI、缩放比例1时设备像素与页面坐标一致。
+    int pixelWidth = (int)(BarWidth * 2);
+    int pixelHeight = (int)BarHeight;
+    GrayRender grayRender(pixelWidth, pixelHeight, 72.0, 72.0, GrayFormat::Gray8);
+    if ( !grayRender.DrawPage(page, std::make_tuple(0.0, 0.0, 1.0)) ){
+        LOG(ERROR) << "GrayRender::DrawPage() failed.";
+        return false;
+    }
+
+    cairo_surface_t *surface = grayRender.GetCairoSurface();
+    cairo_surface_flush(surface);
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    int y = (int)(BarHeight / 2);
+    int redGray = data[(size_t)y * stride + (int)(BarWidth * 0.5)];
+    int blueGray = data[(size_t)y * stride + (int)(BarWidth * 1.5)];
+
+    bool ok = abs(redGray - 77) <= 2 && abs(blueGray - 28) <= 2;
+    if ( !ok ){
+        LOG(ERROR) << "Unexpected gray levels. red=" << redGray << " (expected 77) blue=" << blueGray << " (expected 28)";
+    }
+    return ok;
+}
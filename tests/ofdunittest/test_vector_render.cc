@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <string>
+#include <zlib.h>
+#include "TestPages.h"
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/CairoVectorRender.h"
+#include "utils/logger.h"
+
+using namespace ofd;
+
+// 解压PDF中全部以FlateDecode压缩的流，拼接返回。
+static std::string inflatePDFStreams(const std::string &pdfData){
+    std::string contents;
+    size_t pos = 0;
+    while ( (pos = pdfData.find("stream", pos)) != std::string::npos ){
+        size_t begin = pos + 6;
+        if ( pos >= 3 && pdfData.compare(pos - 3, 3, "end") == 0 ){
+            pos = begin;
+            continue;
+        }
+        if ( begin < pdfData.size() && pdfData[begin] == '\r' ) begin++;
+        if ( begin < pdfData.size() && pdfData[begin] == '\n' ) begin++;
+        size_t end = pdfData.find("endstream", begin);
+        if ( end == std::string::npos ) break;
+        pos = end + 9;
+
+        z_stream zs = {};
+        if ( inflateInit(&zs) != Z_OK ) continue;
+        zs.next_in = (Bytef*)pdfData.data() + begin;
+        zs.avail_in = (uInt)(end - begin);
+        char buf[4096];
+        int ret = Z_OK;
+        while ( ret == Z_OK ){
+            zs.next_out = (Bytef*)buf;
+            zs.avail_out = sizeof(buf);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            contents.append(buf, sizeof(buf) - zs.avail_out);
+        }
+        inflateEnd(&zs);
+        contents += "\n";
+    }
+    return contents;
+}
+
+// 矢量输出按颜色值原样写出：纯红色条在PDF内容流中应为"1 0 0 rg"，R、B互换时为"0 0 1 rg"。
+bool test_vector_render_colors(){
+    PackagePtr package = std::make_shared<Package>();
+    DocumentPtr document = package->AddNewDocument();
+    PagePtr page = CreateColorBarsPage(document, {Color::Instance(255, 0, 0)});
+
+    std::string pdfFileName = "/tmp/ofdunittest_vector_render.pdf";
+    {
+        CairoVectorRender vectorRender(RenderType::PDF, pdfFileName);
+        vectorRender.DrawPage(page, std::make_tuple(0.0, 0.0, 72.0 / 25.4));
+        if ( !vectorRender.Finish() ){
+            LOG(ERROR) << "CairoVectorRender::Finish() failed.";
+            return false;
+        }
+    }
+
+    std::string pdfData;
+    FILE *pdfFile = fopen(pdfFileName.c_str(), "rb");
+    if ( pdfFile == nullptr ){
+        LOG(ERROR) << "Open " << pdfFileName << " failed.";
+        return false;
+    }
+    char buf[4096];
+    size_t n;
+    while ( (n = fread(buf, 1, sizeof(buf), pdfFile)) > 0 ){
+        pdfData.append(buf, n);
+    }
+    fclose(pdfFile);
+    remove(pdfFileName.c_str());
+
+    std::string contents = pdfData + inflatePDFStreams(pdfData);
+    bool hasRed = contents.find("1 0 0 rg") != std::string::npos;
+    bool hasBlue = contents.find("0 0 1 rg") != std::string::npos;
+    if ( !hasRed || hasBlue ){
+        LOG(ERROR) << "Unexpected fill color in PDF output. red=" << hasRed << " blue=" << hasBlue;
+        return false;
+    }
+    return true;
+}
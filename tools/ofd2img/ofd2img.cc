@@ -0,0 +1,390 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <assert.h>
+#include <sys/resource.h>
+#include <gflags/gflags.h>
+#include <cairo/cairo.h>
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/CairoRender.h"
+#include "ofd/FontEngine.h"
+#include "ofd/GrayRender.h"
+#include "ofd/ImageEncoder.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+// OFD页面批量光栅化。
+// 多个工作线程并发绘制页面，每个线程使用独立的CairoRender。
+// 页面解析（读取包内文件、打开模板页）访问文档共享状态，串行执行；
+// 绘制和编码并发执行。输出到目录时各线程直接写文件，
+// 输出到标准输出（--output=-）时按页序拼接写出，统计信息改写到标准错误。
+// 灰度和黑白输出使用GrayRender按条带绘制，不分配整页ARGB32表面。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_string(pages, "", "Page ranges, 1-based, e.g. 1-3,5,8-. Empty means all pages.");
+DEFINE_double(dpi, 150.0, "Output resolution in dots per inch.");
+DEFINE_string(format, "png", "Output format: png, jpeg, tiff or ppm.");
+DEFINE_string(color, "rgb", "Output color mode: rgb, rgba, gray or mono.");
+DEFINE_int32(png_level, 3, "PNG/TIFF deflate level, 0-9.");
+DEFINE_string(png_filter, "up", "PNG row filter: none, sub, up, average, paeth or adaptive.");
+DEFINE_int32(jpeg_quality, 85, "JPEG quality, 1-100.");
+DEFINE_int32(encode_threads, 1, "Threads used to compress one PNG page, 0 means number of CPU cores.");
+DEFINE_int32(threads, 0, "Number of worker threads, 0 means number of CPU cores.");
+DEFINE_string(output, ".", "Output directory, or - for stdout.");
+DEFINE_string(quality, "normal", "Render quality: draft or normal.");
+DEFINE_bool(dither, false, "Use Floyd-Steinberg dithering for mono output.");
+DEFINE_int32(mono_threshold, 128, "Gray level at or above which a mono pixel is white, 1-255.");
+DEFINE_int32(band_height, GrayRender::DefaultBandHeight, "Rows rendered per band for gray and mono output.");
+
+// 进程的内存峰值（字节）。
+static size_t getPeakMemory(){
+    struct rusage usage;
+    if ( getrusage(RUSAGE_SELF, &usage) != 0 ) return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// 解析"1-3,5,8-"形式的页码范围，返回从0开始的页序号。
+static bool parsePageRanges(const std::string &ranges, size_t totalPages, std::vector<size_t> &pageIndexes){
+    if ( ranges.empty() ){
+        for ( size_t i = 0 ; i < totalPages ; i++ ){
+            pageIndexes.push_back(i);
+        }
+        return true;
+    }
+
+    std::stringstream ss(ranges);
+    std::string item;
+    while ( std::getline(ss, item, ',') ){
+        if ( item.empty() ) continue;
+        size_t first = 1, last = totalPages;
+        size_t dash = item.find('-');
+        try {
+            if ( dash == std::string::npos ){
+                first = last = std::stoul(item);
+            } else {
+                if ( dash > 0 ) first = std::stoul(item.substr(0, dash));
+                if ( dash + 1 < item.size() ) last = std::stoul(item.substr(dash + 1));
+            }
+        } catch ( std::exception & ){
+            LOG(ERROR) << "Invalid page range: " << item;
+            return false;
+        }
+        if ( first < 1 || first > last ){
+            LOG(ERROR) << "Invalid page range: " << item;
+            return false;
+        }
+        for ( size_t n = first ; n <= last && n <= totalPages ; n++ ){
+            pageIndexes.push_back(n - 1);
+        }
+    }
+    return true;
+}
+
+typedef struct PageResult{
+    bool Ok;
+    int Width;
+    int Height;
+    double OpenMs;
+    double RenderMs;
+    double EncodeMs;
+    std::string Data; // 输出到标准输出时的编码结果
+} PageResult_t;
+
+// **************** class BatchRasterizer ****************
+
+class BatchRasterizer {
+public:
+    BatchRasterizer(DocumentPtr document, const std::vector<size_t> &pageIndexes, const EncodeParams &encodeParams);
+
+    void Run(size_t numThreads);
+    size_t GetNumFailed() const {return m_numFailed;};
+
+private:
+    // 每个工作线程持有一组Render，逐页复用表面和缓存。
+    typedef struct WorkerRenders{
+        std::unique_ptr<CairoRender> Cairo;
+        std::unique_ptr<GrayRender> Gray;
+    } WorkerRenders_t;
+
+    void workerLoop();
+    PageResult renderPage(size_t pageIndex, WorkerRenders &renders);
+    void finishPage(size_t seq, PageResult &result);
+    void reportPage(size_t pageIndex, const PageResult &result);
+
+    DocumentPtr m_document;
+    const std::vector<size_t> &m_pageIndexes;
+    ImageEncoderPtr m_encoder;
+    ImageColorMode m_colorMode;
+    bool m_toStdout;
+    std::ostream &m_report;
+
+    std::atomic<size_t> m_nextJob;
+    std::mutex m_parseMutex;
+
+    // 按页序输出
+    std::mutex m_outputMutex;
+    std::map<size_t, PageResult> m_pending;
+    size_t m_nextOutput;
+    size_t m_numFailed;
+
+}; // class BatchRasterizer
+
+BatchRasterizer::BatchRasterizer(DocumentPtr document, const std::vector<size_t> &pageIndexes, const EncodeParams &encodeParams) :
+    m_document(document), m_pageIndexes(pageIndexes),
+    m_encoder(ImageEncoderFactory::CreateEncoder(encodeParams)), m_colorMode(encodeParams.ColorMode),
+    m_toStdout(FLAGS_output == "-"), m_report(m_toStdout ? std::cerr : std::cout),
+    m_nextJob(0), m_nextOutput(0), m_numFailed(0){
+}
+
+void BatchRasterizer::Run(size_t numThreads){
+    std::vector<std::thread> workers;
+    for ( size_t i = 0 ; i < numThreads ; i++ ){
+        workers.push_back(std::thread(&BatchRasterizer::workerLoop, this));
+    }
+    for ( auto &worker : workers ){
+        worker.join();
+    }
+}
+
+void BatchRasterizer::workerLoop(){
+    WorkerRenders renders;
+    while ( true ){
+        size_t seq = m_nextJob++;
+        if ( seq >= m_pageIndexes.size() ) break;
+        PageResult result = renderPage(m_pageIndexes[seq], renders);
+        finishPage(seq, result);
+    }
+}
+
+PageResult BatchRasterizer::renderPage(size_t pageIndex, WorkerRenders &renders){
+    PageResult result;
+    result.Ok = false;
+    result.Width = result.Height = 0;
+    result.OpenMs = result.RenderMs = result.EncodeMs = 0.0;
+
+    // -------- 解析页面 --------
+    auto t0 = std::chrono::steady_clock::now();
+    PagePtr page;
+    {
+        std::lock_guard<std::mutex> lock(m_parseMutex);
+        page = m_document->GetPage(pageIndex);
+        if ( page == nullptr || !page->Open() ){
+            LOG(ERROR) << "page->Open() failed. pageIndex=" << pageIndex;
+            return result;
+        }
+    }
+
+    // -------- 绘制 --------
+    // 页面单位为毫米，设备像素 = 毫米 / 25.4 * dpi = 页面坐标 * scaling * resolution / 72。
+    auto t1 = std::chrono::steady_clock::now();
+    double resolution = FLAGS_dpi;
+    double scaling = 72.0 / 25.4;
+    ST_Box pageBox = page->Area.ApplicationBox;
+    if ( pageBox.Width <= 0.0 || pageBox.Height <= 0.0 ){
+        pageBox = page->Area.PhysicalBox;
+    }
+    result.Width = (int)ceil(pageBox.Width * scaling * resolution / 72.0);
+    result.Height = (int)ceil(pageBox.Height * scaling * resolution / 72.0);
+    if ( result.Width <= 0 || result.Height <= 0 ){
+        LOG(ERROR) << "Invalid page size. pageIndex=" << pageIndex;
+        return result;
+    }
+
+    RenderQuality quality = FLAGS_quality == "draft" ? RenderQuality::Draft : RenderQuality::Normal;
+    cairo_surface_t *surface = nullptr;
+    if ( m_colorMode == ImageColorMode::Gray || m_colorMode == ImageColorMode::Mono ){
+        // GrayRender逐行覆盖整个目标表面，页面尺寸不变时直接复用。
+        std::unique_ptr<GrayRender> &grayRender = renders.Gray;
+        if ( grayRender == nullptr ||
+                cairo_image_surface_get_width(grayRender->GetCairoSurface()) != result.Width ||
+                cairo_image_surface_get_height(grayRender->GetCairoSurface()) != result.Height ){
+            GrayFormat grayFormat = m_colorMode == ImageColorMode::Gray ? GrayFormat::Gray8 : GrayFormat::Mono1;
+            grayRender = utils::make_unique<GrayRender>(result.Width, result.Height, resolution, resolution, grayFormat, FLAGS_band_height);
+        }
+        grayRender->SetRenderQuality(quality);
+        grayRender->SetMonoMethod(FLAGS_dither ? MonoMethod::Dither : MonoMethod::Threshold);
+        grayRender->SetMonoThreshold((uint8_t)std::min(std::max(FLAGS_mono_threshold, 1), 255));
+        grayRender->DrawPage(page, std::make_tuple(0.0, 0.0, scaling));
+        surface = grayRender->GetCairoSurface();
+    } else {
+        // Rebuild()在尺寸不变时只重置上下文并清为白色，保留表面和图层缓存。
+        std::unique_ptr<CairoRender> &cairoRender = renders.Cairo;
+        if ( cairoRender == nullptr ){
+            cairoRender = utils::make_unique<CairoRender>(result.Width, result.Height, resolution, resolution);
+        } else {
+            cairoRender->Rebuild(result.Width, result.Height, resolution, resolution);
+        }
+        cairoRender->SetRenderQuality(quality);
+        cairoRender->SaveState();
+        cairoRender->DrawPage(page, std::make_tuple(0.0, 0.0, scaling));
+        cairoRender->RestoreState();
+        surface = cairoRender->GetCairoSurface();
+    }
+
+    // -------- 编码 --------
+    auto t2 = std::chrono::steady_clock::now();
+    if ( !m_encoder->EncodeToBuffer(surface, result.Data) ){
+        LOG(ERROR) << "Encode page failed. pageIndex=" << pageIndex;
+        return result;
+    }
+    if ( !m_toStdout ){
+        std::string filename = FLAGS_output + "/Page_" + std::to_string(pageIndex + 1) + "." + FLAGS_format;
+        FILE *file = fopen(filename.c_str(), "wb");
+        if ( file == nullptr ){
+            LOG(ERROR) << "Open output file failed. filename=" << filename;
+            return result;
+        }
+        bool written = fwrite(result.Data.data(), 1, result.Data.size(), file) == result.Data.size();
+        fclose(file);
+        result.Data.clear();
+        if ( !written ){
+            LOG(ERROR) << "Write output file failed. filename=" << filename;
+            return result;
+        }
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    result.OpenMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.RenderMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    result.EncodeMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    result.Ok = true;
+
+    return result;
+}
+
+// 完成的页面按页序写出和报告，先完成的后续页面暂存。
+void BatchRasterizer::finishPage(size_t seq, PageResult &result){
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    m_pending[seq] = std::move(result);
+
+    while ( !m_pending.empty() && m_pending.begin()->first == m_nextOutput ){
+        PageResult &pageResult = m_pending.begin()->second;
+        if ( pageResult.Ok && m_toStdout ){
+            fwrite(pageResult.Data.data(), 1, pageResult.Data.size(), stdout);
+            fflush(stdout);
+        }
+        if ( !pageResult.Ok ) m_numFailed++;
+        reportPage(m_pageIndexes[m_nextOutput], pageResult);
+        m_pending.erase(m_pending.begin());
+        m_nextOutput++;
+    }
+}
+
+void BatchRasterizer::reportPage(size_t pageIndex, const PageResult &result){
+    m_report << std::fixed << std::setprecision(3)
+        << "page=" << (pageIndex + 1)
+        << " ok=" << (result.Ok ? 1 : 0)
+        << " size=" << result.Width << "x" << result.Height
+        << " open_ms=" << result.OpenMs
+        << " render_ms=" << result.RenderMs
+        << " encode_ms=" << result.EncodeMs
+        << " peak_mb=" << getPeakMemory() / (1024.0 * 1024.0)
+        << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofd2img [--pages=1-3,5] [--dpi=150] [--format=png|jpeg|tiff|ppm] [--color=rgb|rgba|gray|mono] [--dither] [--threads=N] [--output=dir|-] <ofdfile>");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    if ( argc < 2 ){
+        LOG(WARNING) << "Usage: ofd2img [options] <ofdfile>";
+        exit(-1);
+    }
+    std::string filename = argv[1];
+
+    // 工作线程启动前初始化FreeType。
+    if ( !FontEngine::Initialize() ){
+        return -1;
+    }
+
+    EncodeParams encodeParams;
+    if ( !ImageFormatFromString(FLAGS_format, encodeParams.Format) ){
+        LOG(ERROR) << "Unknown output format: " << FLAGS_format;
+        return -1;
+    }
+    if ( !ImageColorModeFromString(FLAGS_color, encodeParams.ColorMode) ){
+        LOG(ERROR) << "Unknown color mode: " << FLAGS_color;
+        return -1;
+    }
+    static const char *pngFilters[] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+    size_t filterIndex = 0;
+    while ( filterIndex < 6 && FLAGS_png_filter != pngFilters[filterIndex] ) filterIndex++;
+    if ( filterIndex == 6 ){
+        LOG(ERROR) << "Unknown PNG filter: " << FLAGS_png_filter;
+        return -1;
+    }
+    encodeParams.Filter = (PNGFilter)filterIndex;
+    encodeParams.PNGLevel = FLAGS_png_level;
+    encodeParams.JPEGQuality = FLAGS_jpeg_quality;
+    encodeParams.Threads = FLAGS_encode_threads > 0 ? FLAGS_encode_threads : 0;
+    encodeParams.ResolutionX = FLAGS_dpi;
+    encodeParams.ResolutionY = FLAGS_dpi;
+    if ( FLAGS_dpi <= 0.0 ){
+        LOG(ERROR) << "Invalid dpi: " << FLAGS_dpi;
+        return -1;
+    }
+
+    ofd::PackagePtr package = std::make_shared<ofd::Package>();
+    if ( !package->Open(filename) ){
+        LOG(ERROR) << "OFDPackage::Open() failed. filename:" << filename;
+        return -1;
+    }
+    DocumentPtr document = package->GetDefaultDocument();
+    assert(document != nullptr);
+    if ( !document->Open() ){
+        LOG(ERROR) << "Open OFD Document failed. filename: " << filename;
+        return -1;
+    }
+
+    std::vector<size_t> pageIndexes;
+    if ( !parsePageRanges(FLAGS_pages, document->GetNumPages(), pageIndexes) ){
+        return -1;
+    }
+    if ( FLAGS_output != "-" ){
+        utils::MkdirIfNotExist(FLAGS_output);
+    }
+
+    size_t numThreads = FLAGS_threads > 0 ? FLAGS_threads : std::thread::hardware_concurrency();
+    numThreads = std::max((size_t)1, std::min(numThreads, pageIndexes.size()));
+
+    auto startTime = std::chrono::steady_clock::now();
+    BatchRasterizer rasterizer(document, pageIndexes, encodeParams);
+    rasterizer.Run(numThreads);
+    auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::ostream &report = FLAGS_output == "-" ? std::cerr : std::cout;
+    report << std::fixed << std::setprecision(3)
+        << "pages=" << pageIndexes.size()
+        << " failed=" << rasterizer.GetNumFailed()
+        << " threads=" << numThreads
+        << " dpi=" << FLAGS_dpi
+        << " seconds=" << seconds
+        << " pages/s=" << (seconds > 0.0 ? pageIndexes.size() / seconds : 0.0)
+        << " peak_mb=" << getPeakMemory() / (1024.0 * 1024.0)
+        << std::endl;
+
+    package->Close();
+
+    return rasterizer.GetNumFailed() > 0 ? 1 : 0;
+}
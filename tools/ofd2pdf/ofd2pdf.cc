@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <assert.h>
+#include <gflags/gflags.h>
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/CairoVectorRender.h"
+#include "utils/logger.h"
+
+// OFD转换为PDF、SVG、PS矢量文件。
+// 逐页打开、绘制并写出，不对页面做光栅化。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_string(format, "pdf", "Output format: pdf, svg or ps.");
+DEFINE_int32(pages, 0, "Max number of pages to convert, 0 means all pages.");
+
+int main(int argc, char *argv[]){
+
+    TIMED_FUNC(timerMain);
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofd2pdf [--format=pdf|svg|ps] [--pages=N] <ofdfile> [outputfile]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    if ( argc < 2 ){
+        LOG(WARNING) << "Usage: ofd2pdf [options] <ofdfile> [outputfile]";
+        exit(-1);
+    }
+    std::string filename = argv[1];
+
+    RenderType renderType = RenderType::PDF;
+    if ( FLAGS_format == "pdf" ){
+        renderType = RenderType::PDF;
+    } else if ( FLAGS_format == "svg" ){
+        renderType = RenderType::SVG;
+    } else if ( FLAGS_format == "ps" ){
+        renderType = RenderType::PS;
+    } else {
+        LOG(ERROR) << "Unknown output format: " << FLAGS_format;
+        return -1;
+    }
+
+    std::string outputFilename = filename + "." + FLAGS_format;
+    if ( argc > 2 ){
+        outputFilename = argv[2];
+    }
+
+    ofd::PackagePtr package = std::make_shared<ofd::Package>();
+    if ( !package->Open(filename) ){
+        LOG(ERROR) << "OFDPackage::Open() failed. filename:" << filename;
+        return -1;
+    }
+    DocumentPtr document = package->GetDefaultDocument();
+    assert(document != nullptr);
+    if ( !document->Open() ){
+        LOG(ERROR) << "Open OFD Document failed. filename: " << filename;
+        return -1;
+    }
+
+    size_t totalPages = document->GetNumPages();
+    if ( FLAGS_pages > 0 && (size_t)FLAGS_pages < totalPages ){
+        totalPages = FLAGS_pages;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    RenderPtr render = RenderFactory::CreateRenderInstance(renderType, outputFilename);
+    CairoVectorRenderPtr vectorRender = std::dynamic_pointer_cast<CairoVectorRender>(render);
+    assert(vectorRender != nullptr);
+
+    // 页面单位为毫米，输出页面单位为点，页面大小 = 毫米 * 72 / 25.4。
+    double scaling = 72.0 / 25.4;
+    for ( size_t i = 0 ; i < totalPages ; i++ ){
+        PagePtr page = document->GetPage(i);
+        if ( !page->Open() ){
+            LOG(ERROR) << "page->Open() failed. pageIndex=" << i;
+            continue;
+        }
+        vectorRender->DrawPage(page, std::make_tuple(0.0, 0.0, scaling));
+    }
+    bool ok = vectorRender->Finish();
+
+    auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "format=" << FLAGS_format
+        << " pages=" << vectorRender->GetNumPages()
+        << " seconds=" << seconds
+        << " output=" << outputFilename
+        << std::endl;
+
+    package->Close();
+
+    return ok ? 0 : -1;
+}
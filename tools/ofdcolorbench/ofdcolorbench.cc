@@ -0,0 +1,130 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <gflags/gflags.h>
+#include "ofd/Color.h"
+#include "ofd/ColorConvert.h"
+#include "utils/logger.h"
+
+// 颜色空间转换基准测试。
+// 随机生成灰度、RGB、CMYK和调色板索引像素，分别用逐像素Color::GetRGBA()、
+// 批量标量实现和批量SIMD实现转换为ARGB32，统计每百万像素耗时及与逐像素结果的最大差。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_int32(pixels, 1024 * 1024, "Pixels per conversion.");
+DEFINE_int32(repeat, 20, "Number of conversions for each mode.");
+
+static uint32_t packColor(ColorPtr color){
+    double r, g, b, a;
+    std::tie(r, g, b, a) = color->GetRGBA();
+    return packSurfacePixel(0xff, (uint32_t)(r * 255.0 + 0.5), (uint32_t)(g * 255.0 + 0.5), (uint32_t)(b * 255.0 + 0.5));
+}
+
+static double timeMs(const std::function<void()> &convert){
+    auto startTime = std::chrono::steady_clock::now();
+    for ( int i = 0 ; i < FLAGS_repeat ; i++ ){
+        convert();
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count() / FLAGS_repeat;
+}
+
+static int maxDiff(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b){
+    int diff = 0;
+    for ( size_t i = 0 ; i < a.size() && i < b.size() ; i++ ){
+        for ( int shift = 0 ; shift < 32 ; shift += 8 ){
+            diff = std::max(diff, abs((int)((a[i] >> shift) & 0xff) - (int)((b[i] >> shift) & 0xff)));
+        }
+    }
+    return diff;
+}
+
+static void runBench(const std::string &name, ColorSpacePtr colorSpace, const std::vector<uint8_t> &src, int nBits){
+    size_t n = FLAGS_pixels;
+    ColorConverterPtr converter = ColorConverter::GetInstance(colorSpace);
+    int numComps = converter->GetNumComps();
+    std::vector<uint32_t> colorPixels(n), scalarPixels(n), simdPixels(n);
+
+    double colorMs = timeMs([&](){
+        for ( size_t i = 0 ; i < n ; i++ ){
+            ColorPtr color;
+            if ( nBits > 0 ){
+                color = Color::Instance(colorSpace, src[i]);
+            } else if ( numComps == 1 ){
+                color = Color::Instance(ColorValue(src[i]), colorSpace);
+            } else if ( numComps == 4 ){
+                const uint8_t *p = &src[i * 4];
+                color = Color::Instance(p[0], p[1], p[2], p[3], colorSpace);
+            } else {
+                const uint8_t *p = &src[i * 3];
+                color = Color::Instance(p[0], p[1], p[2], colorSpace);
+            }
+            colorPixels[i] = packColor(color);
+        }
+    });
+
+    auto convert = [&](std::vector<uint32_t> &dst){
+        if ( nBits > 0 ){
+            converter->ConvertIndexedRow(src.data(), nBits, dst.data(), n);
+        } else {
+            converter->ConvertRow(src.data(), dst.data(), n);
+        }
+    };
+    bool simd = IsColorConvertSIMDEnabled();
+    SetColorConvertSIMD(false);
+    double scalarMs = timeMs([&](){convert(scalarPixels);});
+    SetColorConvertSIMD(simd);
+    double simdMs = timeMs([&](){convert(simdPixels);});
+
+    double mega = (double)n / 1000000.0;
+    std::cout << std::fixed << std::setprecision(3)
+        << name
+        << " color_ms/mpx=" << colorMs / mega
+        << " scalar_ms/mpx=" << scalarMs / mega
+        << " simd_ms/mpx=" << simdMs / mega
+        << " simd=" << (IsColorConvertSIMDEnabled() ? "on" : "off")
+        << " max_diff_scalar=" << maxDiff(colorPixels, scalarPixels)
+        << " max_diff_simd=" << maxDiff(colorPixels, simdPixels)
+        << std::endl;
+}
+
+int main(int argc, char *argv[]){
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofdcolorbench [--pixels=1048576] [--repeat=20]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    size_t n = FLAGS_pixels;
+    srand(20170613);
+    std::vector<uint8_t> src(n * 4);
+    for ( auto &v : src ){
+        v = (uint8_t)(rand() & 0xff);
+    }
+
+    ColorSpacePtr gray = std::make_shared<ColorSpace>();
+    gray->Type = ColorSpaceType::GRAY;
+    ColorSpacePtr rgb = std::make_shared<ColorSpace>();
+    rgb->Type = ColorSpaceType::RGB;
+    ColorSpacePtr cmyk = std::make_shared<ColorSpace>();
+    cmyk->Type = ColorSpaceType::CMYK;
+
+    ColorSpacePtr indexed = std::make_shared<ColorSpace>();
+    indexed->Type = ColorSpaceType::CMYK;
+    for ( uint32_t i = 0 ; i < 256 ; i++ ){
+        indexed->Palette.push_back(Color::Instance(i, 255 - i, (i * 7) & 0xff, i / 2, indexed));
+    }
+
+    runBench("gray", gray, src, 0);
+    runBench("rgb", rgb, src, 0);
+    runBench("cmyk", cmyk, src, 0);
+    runBench("indexed8", indexed, src, 8);
+
+    return 0;
+}
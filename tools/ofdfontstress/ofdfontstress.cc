@@ -0,0 +1,230 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+#include <gflags/gflags.h>
+#include <cairo/cairo.h>
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/CairoRender.h"
+#include "ofd/FontCache.h"
+#include "ofd/FontEngine.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+// 字体子系统并发压力测试。
+// 先单线程绘制各页作为基准，再由多个线程反复绘制同一文档，比较每页像素的哈希。
+// 默认每个线程每轮独立打开文档，字体随文档反复创建和释放，
+// 覆盖FontCache、FreeType字体创建释放和cairo字形缓存的并发路径；
+// --shared_document时所有线程共用一个文档，只有页面解析串行执行。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_int32(threads, 8, "Number of rendering threads.");
+DEFINE_int32(iterations, 4, "Times each thread renders the document.");
+DEFINE_int32(max_pages, 8, "Render at most this many pages, 0 means all pages.");
+DEFINE_double(dpi, 96.0, "Output resolution in dots per inch.");
+DEFINE_bool(shared_document, false, "All threads render pages of one opened document.");
+
+static DocumentPtr openDocument(const std::string &filename, PackagePtr &package){
+    package = std::make_shared<ofd::Package>();
+    if ( !package->Open(filename) ){
+        LOG(ERROR) << "OFDPackage::Open() failed. filename:" << filename;
+        return nullptr;
+    }
+    DocumentPtr document = package->GetDefaultDocument();
+    if ( document == nullptr || !document->Open() ){
+        LOG(ERROR) << "Open OFD Document failed. filename: " << filename;
+        return nullptr;
+    }
+    return document;
+}
+
+// **************** class FontStress ****************
+
+class FontStress {
+public:
+    FontStress(const std::string &filename);
+
+    bool Prepare();
+    void Run(size_t numThreads);
+
+    size_t GetNumPages() const {return m_baseHashes.size();};
+    size_t GetNumRendered() const {return m_numRendered;};
+    size_t GetNumMismatched() const {return m_numMismatched;};
+    size_t GetNumFailed() const {return m_numFailed;};
+
+private:
+    void workerLoop(size_t threadIndex);
+    bool renderPage(DocumentPtr document, size_t pageIndex, uint64_t &hash);
+
+    std::string m_filename;
+    PackagePtr m_package;
+    DocumentPtr m_document;
+    std::vector<uint64_t> m_baseHashes;
+
+    std::mutex m_parseMutex;
+    std::atomic<size_t> m_numRendered;
+    std::atomic<size_t> m_numMismatched;
+    std::atomic<size_t> m_numFailed;
+
+}; // class FontStress
+
+FontStress::FontStress(const std::string &filename) :
+    m_filename(filename), m_numRendered(0), m_numMismatched(0), m_numFailed(0){
+}
+
+// 单线程绘制基准哈希。
+bool FontStress::Prepare(){
+    m_document = openDocument(m_filename, m_package);
+    if ( m_document == nullptr ) return false;
+
+    size_t numPages = m_document->GetNumPages();
+    if ( FLAGS_max_pages > 0 ){
+        numPages = std::min(numPages, (size_t)FLAGS_max_pages);
+    }
+    for ( size_t i = 0 ; i < numPages ; i++ ){
+        uint64_t hash = 0;
+        if ( !renderPage(m_document, i, hash) ) return false;
+        m_baseHashes.push_back(hash);
+    }
+    if ( !FLAGS_shared_document ){
+        m_document = nullptr;
+        m_package->Close();
+        m_package = nullptr;
+    }
+    return true;
+}
+
+void FontStress::Run(size_t numThreads){
+    std::vector<std::thread> workers;
+    for ( size_t i = 0 ; i < numThreads ; i++ ){
+        workers.push_back(std::thread(&FontStress::workerLoop, this, i));
+    }
+    for ( auto &worker : workers ){
+        worker.join();
+    }
+    if ( m_package != nullptr ){
+        m_package->Close();
+    }
+}
+
+void FontStress::workerLoop(size_t threadIndex){
+    size_t numPages = m_baseHashes.size();
+    for ( int iteration = 0 ; iteration < FLAGS_iterations ; iteration++ ){
+        PackagePtr package;
+        DocumentPtr document = m_document;
+        if ( !FLAGS_shared_document ){
+            document = openDocument(m_filename, package);
+            if ( document == nullptr ){
+                m_numFailed++;
+                continue;
+            }
+        }
+        // 各线程从不同页开始，同一字体在不同线程中同时使用。
+        for ( size_t n = 0 ; n < numPages ; n++ ){
+            size_t pageIndex = (threadIndex + n) % numPages;
+            uint64_t hash = 0;
+            if ( !renderPage(document, pageIndex, hash) ){
+                m_numFailed++;
+            } else if ( hash != m_baseHashes[pageIndex] ){
+                LOG(ERROR) << "Page " << (pageIndex + 1) << " differs from the single-threaded rendering. thread=" << threadIndex;
+                m_numMismatched++;
+            }
+            m_numRendered++;
+        }
+        if ( package != nullptr ){
+            package->Close();
+        }
+    }
+}
+
+bool FontStress::renderPage(DocumentPtr document, size_t pageIndex, uint64_t &hash){
+    PagePtr page;
+    {
+        std::lock_guard<std::mutex> lock(m_parseMutex);
+        page = document->GetPage(pageIndex);
+        if ( page == nullptr || !page->Open() ){
+            LOG(ERROR) << "page->Open() failed. pageIndex=" << pageIndex;
+            return false;
+        }
+    }
+
+    double scaling = 72.0 / 25.4;
+    ST_Box pageBox = page->Area.ApplicationBox;
+    if ( pageBox.Width <= 0.0 || pageBox.Height <= 0.0 ){
+        pageBox = page->Area.PhysicalBox;
+    }
+    int width = (int)ceil(pageBox.Width * scaling * FLAGS_dpi / 72.0);
+    int height = (int)ceil(pageBox.Height * scaling * FLAGS_dpi / 72.0);
+    if ( width <= 0 || height <= 0 ){
+        LOG(ERROR) << "Invalid page size. pageIndex=" << pageIndex;
+        return false;
+    }
+
+    CairoRender cairoRender(width, height, FLAGS_dpi, FLAGS_dpi);
+    cairoRender.SaveState();
+    cairoRender.DrawPage(page, std::make_tuple(0.0, 0.0, scaling));
+    cairoRender.RestoreState();
+
+    cairo_surface_t *surface = cairoRender.GetCairoSurface();
+    cairo_surface_flush(surface);
+    const uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    // 行尾填充字节内容未定义，逐行计算。
+    hash = 0;
+    for ( int y = 0 ; y < height ; y++ ){
+        hash = hash * 1099511628211ULL ^ utils::HashData(data + (size_t)y * stride, (size_t)width * 4);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]){
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofdfontstress [--threads=8] [--iterations=4] [--max_pages=8] [--dpi=96] [--shared_document] <ofdfile>");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    if ( argc < 2 ){
+        LOG(WARNING) << "Usage: ofdfontstress [options] <ofdfile>";
+        exit(-1);
+    }
+    if ( !FontEngine::Initialize() ){
+        return -1;
+    }
+
+    FontStress stress(argv[1]);
+    if ( !stress.Prepare() ){
+        return -1;
+    }
+
+    size_t numThreads = std::max(1, FLAGS_threads);
+    auto startTime = std::chrono::steady_clock::now();
+    stress.Run(numThreads);
+    auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    uint64_t hits = 0, misses = 0;
+    std::tie(hits, misses) = FontCache::GlobalInstance().GetHitsMisses();
+    std::cout << std::fixed << std::setprecision(3)
+        << "pages=" << stress.GetNumPages()
+        << " threads=" << numThreads
+        << " rendered=" << stress.GetNumRendered()
+        << " mismatched=" << stress.GetNumMismatched()
+        << " failed=" << stress.GetNumFailed()
+        << " font_hits=" << hits
+        << " font_misses=" << misses
+        << " seconds=" << seconds
+        << std::endl;
+
+    return stress.GetNumMismatched() > 0 || stress.GetNumFailed() > 0 ? 1 : 0;
+}
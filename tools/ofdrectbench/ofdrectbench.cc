@@ -0,0 +1,180 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <gflags/gflags.h>
+#include <cairo/cairo.h>
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/Layer.h"
+#include "ofd/PathObject.h"
+#include "ofd/Path.h"
+#include "ofd/Color.h"
+#include "ofd/CairoRender.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+// 轴对齐矩形快速填充基准测试。
+// 在内存中生成表格类页面（单元格底色、表格线、半透明高亮），
+// 分别开启和关闭DrawState::FastRectFill绘制，统计每页耗时及两者的最大像素差。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_int32(rows, 60, "Table rows.");
+DEFINE_int32(cols, 12, "Table columns.");
+DEFINE_double(dpi, 150.0, "Render resolution.");
+DEFINE_int32(repeat, 20, "Number of renders for each mode.");
+DEFINE_string(output, "", "Write the two renders as PNG files into this directory.");
+
+static const double PageWidth = 210.0;
+static const double PageHeight = 297.0;
+
+static PathObjectPtr newRectObject(LayerPtr layer, double x0, double y0, double x1, double y1, ColorPtr fillColor){
+    PathPtr path = std::make_shared<Path>();
+    path->MoveTo(Point_t(x0, y0));
+    path->LineTo(Point_t(x1, y0));
+    path->LineTo(Point_t(x1, y1));
+    path->LineTo(Point_t(x0, y1));
+    path->ClosePath();
+
+    PathObjectPtr pathObject = std::make_shared<PathObject>(layer);
+    pathObject->SetPath(path);
+    pathObject->SetFillColor(fillColor);
+    return pathObject;
+}
+
+static PathObjectPtr newLineObject(LayerPtr layer, double x0, double y0, double x1, double y1, double lineWidth, ColorPtr strokeColor){
+    PathPtr path = std::make_shared<Path>();
+    path->MoveTo(Point_t(x0, y0));
+    path->LineTo(Point_t(x1, y1));
+
+    PathObjectPtr pathObject = std::make_shared<PathObject>(layer);
+    pathObject->SetPath(path);
+    pathObject->SetStrokeColor(strokeColor);
+    pathObject->LineWidth = lineWidth;
+    return pathObject;
+}
+
+static PagePtr createTablePage(DocumentPtr document, int rows, int cols){
+    PagePtr page = document->AddNewPage();
+    page->Area.PhysicalBox = ST_Box(0.0, 0.0, PageWidth, PageHeight);
+    page->Area.ApplicationBox = page->Area.PhysicalBox;
+    LayerPtr layer = page->AddNewLayer(LayerType::BODY);
+
+    double left = 10.3, top = 12.7;
+    double cellWidth = (PageWidth - 2 * left) / cols;
+    double cellHeight = (PageHeight - 2 * top) / rows;
+
+    // -------- 单元格底色 --------
+    for ( int r = 0 ; r < rows ; r++ ){
+        for ( int c = 0 ; c < cols ; c++ ){
+            uint32_t gray = ((r + c) % 2 == 0) ? 240 : 220;
+            double x = left + c * cellWidth;
+            double y = top + r * cellHeight;
+            layer->AddObject(newRectObject(layer, x, y, x + cellWidth, y + cellHeight,
+                        Color::Instance(gray, gray, 255)));
+        }
+    }
+
+    // -------- 半透明高亮行 --------
+    for ( int r = 0 ; r < rows ; r += 5 ){
+        double y = top + r * cellHeight;
+        layer->AddObject(newRectObject(layer, left, y, PageWidth - left, y + cellHeight,
+                    Color::Instance(255, 200, 0, ColorSpace::DefaultInstance, 96)));
+    }
+
+    // -------- 表格线 --------
+    ColorPtr black = Color::Instance(0, 0, 0);
+    for ( int r = 0 ; r <= rows ; r++ ){
+        double y = top + r * cellHeight;
+        layer->AddObject(newLineObject(layer, left, y, PageWidth - left, y, 0.25, black));
+    }
+    for ( int c = 0 ; c <= cols ; c++ ){
+        double x = left + c * cellWidth;
+        layer->AddObject(newLineObject(layer, x, top, x, PageHeight - top, 0.25, black));
+    }
+
+    return page;
+}
+
+// 返回每页毫秒数，pixels返回最后一次绘制的像素。
+static double renderPage(PagePtr page, bool fastRectFill, std::vector<uint8_t> &pixels, const std::string &pngFile){
+    double resolution = FLAGS_dpi;
+    double pixelWidth = ceil(PageWidth * resolution / 72.0);
+    double pixelHeight = ceil(PageHeight * resolution / 72.0);
+    std::unique_ptr<CairoRender> cairoRender = utils::make_unique<CairoRender>(pixelWidth, pixelHeight, resolution, resolution);
+    cairoRender->GetDrawState().FastRectFill = fastRectFill;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for ( int i = 0 ; i < FLAGS_repeat ; i++ ){
+        cairoRender->SaveState();
+        cairoRender->DrawPage(page, std::make_tuple(0.0, 0.0, 1.0));
+        cairoRender->RestoreState();
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+    cairo_surface_t *surface = cairoRender->GetCairoSurface();
+    cairo_surface_flush(surface);
+    size_t bytes = (size_t)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+    pixels.resize(bytes);
+    memcpy(pixels.data(), cairo_image_surface_get_data(surface), bytes);
+
+    if ( !pngFile.empty() ){
+        cairoRender->WriteToPNG(pngFile);
+    }
+
+    return FLAGS_repeat > 0 ? ms / FLAGS_repeat : 0.0;
+}
+
+int main(int argc, char *argv[]){
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofdrectbench [--rows=60] [--cols=12] [--dpi=150] [--repeat=20] [--output=dir]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    ofd::PackagePtr package = std::make_shared<ofd::Package>();
+    DocumentPtr document = package->AddNewDocument();
+    PagePtr page = createTablePage(document, FLAGS_rows, FLAGS_cols);
+
+    std::string fastPNG, cairoPNG;
+    if ( !FLAGS_output.empty() ){
+        utils::MkdirIfNotExist(FLAGS_output);
+        fastPNG = FLAGS_output + "/RectFast.png";
+        cairoPNG = FLAGS_output + "/RectCairo.png";
+    }
+
+    std::vector<uint8_t> fastPixels, cairoPixels;
+    double cairoMs = renderPage(page, false, cairoPixels, cairoPNG);
+    double fastMs = renderPage(page, true, fastPixels, fastPNG);
+
+    int maxDiff = 0;
+    size_t numDiffPixels = 0;
+    for ( size_t i = 0 ; i + 3 < fastPixels.size() && i + 3 < cairoPixels.size() ; i += 4 ){
+        int pixelDiff = 0;
+        for ( size_t k = 0 ; k < 4 ; k++ ){
+            pixelDiff = std::max(pixelDiff, abs((int)fastPixels[i + k] - (int)cairoPixels[i + k]));
+        }
+        if ( pixelDiff > 0 ) numDiffPixels++;
+        maxDiff = std::max(maxDiff, pixelDiff);
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "objects=" << page->GetBodyLayer()->GetNumObjects()
+        << " dpi=" << FLAGS_dpi
+        << " cairo_ms/page=" << cairoMs
+        << " fast_ms/page=" << fastMs
+        << " speedup=" << (fastMs > 0.0 ? cairoMs / fastMs : 0.0)
+        << " max_diff=" << maxDiff
+        << " diff_pixels=" << numDiffPixels
+        << std::endl;
+
+    return 0;
+}
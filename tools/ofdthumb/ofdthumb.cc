@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <assert.h>
+#include <gflags/gflags.h>
+#include <cairo/cairo.h>
+#include "ofd/Package.h"
+#include "ofd/Document.h"
+#include "ofd/Page.h"
+#include "ofd/CairoRender.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+// 缩略图绘制基准测试。
+// 将文档每一页绘制为size x size像素以内的缩略图，统计每秒缩略图数。
+
+using namespace ofd;
+
+DEFINE_int32(v, 0, "Logger level.");
+DEFINE_int32(size, 160, "Thumbnail box size in pixels.");
+DEFINE_string(quality, "draft", "Render quality: draft or normal.");
+DEFINE_int32(pages, 0, "Max number of pages to render, 0 means all pages.");
+DEFINE_int32(repeat, 1, "Number of passes over the pages.");
+DEFINE_string(output, "", "Write thumbnails as PNG files into this directory.");
+
+int main(int argc, char *argv[]){
+
+    TIMED_FUNC(timerMain);
+
+    gflags::SetVersionString("1.0.0");
+    gflags::SetUsageMessage("Usage: ofdthumb [--size=160] [--quality=draft|normal] [--pages=N] [--repeat=N] [--output=dir] <ofdfile>");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    Logger::Initialize(FLAGS_v);
+
+    if ( argc < 2 ){
+        LOG(WARNING) << "Usage: ofdthumb [options] <ofdfile>";
+        exit(-1);
+    }
+    std::string filename = argv[1];
+
+    ofd::PackagePtr package = std::make_shared<ofd::Package>();
+    if ( !package->Open(filename) ){
+        LOG(ERROR) << "OFDPackage::Open() failed. filename:" << filename;
+        return -1;
+    }
+    DocumentPtr document = package->GetDefaultDocument();
+    assert(document != nullptr);
+    if ( !document->Open() ){
+        LOG(ERROR) << "Open OFD Document failed. filename: " << filename;
+        return -1;
+    }
+
+    size_t totalPages = document->GetNumPages();
+    if ( FLAGS_pages > 0 && (size_t)FLAGS_pages < totalPages ){
+        totalPages = FLAGS_pages;
+    }
+    if ( !FLAGS_output.empty() ){
+        utils::MkdirIfNotExist(FLAGS_output);
+    }
+
+    double resolution = 72.0;
+    double boxSize = FLAGS_size;
+    std::unique_ptr<CairoRender> cairoRender = utils::make_unique<CairoRender>(boxSize, boxSize, resolution, resolution);
+    if ( FLAGS_quality == "draft" ){
+        cairoRender->SetRenderQuality(RenderQuality::Draft);
+    } else {
+        cairoRender->SetRenderQuality(RenderQuality::Normal);
+    }
+
+    size_t numThumbnails = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for ( int pass = 0 ; pass < FLAGS_repeat ; pass++ ){
+        for ( size_t i = 0 ; i < totalPages ; i++ ){
+            PagePtr page = document->GetPage(i);
+            if ( !page->Open() ){
+                LOG(ERROR) << "page->Open() failed. pageIndex=" << i;
+                continue;
+            }
+            double scaling = page->GetFitScaling(boxSize, boxSize, resolution, resolution);
+
+            cairoRender->SaveState();
+            cairoRender->DrawPage(page, std::make_tuple(0.0, 0.0, scaling));
+            cairoRender->RestoreState();
+            numThumbnails++;
+
+            if ( pass == 0 && !FLAGS_output.empty() ){
+                cairoRender->WriteToPNG(FLAGS_output + "/Thumb_" + std::to_string(i) + ".png");
+            }
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(endTime - startTime).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "quality=" << FLAGS_quality
+        << " size=" << FLAGS_size
+        << " thumbnails=" << numThumbnails
+        << " seconds=" << seconds
+        << " thumbnails/s=" << (seconds > 0.0 ? numThumbnails / seconds : 0.0)
+        << std::endl;
+
+    package->Close();
+
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include "utils/logger.h"
 #include "utils/utils.h"
 #include "ofd/CairoRender.h"
+#include "ofd/TileCache.h"
 
 using namespace ofd;
 double g_resolutionX = 144.0;
@@ -16,6 +17,10 @@ double ZOOM_STEP = 0.1;
 double ZOOM_BASE = exp(1.0);
 double X_STEP = 10;
 double Y_STEP = 10;
+// 每帧最多绘制的分块数，其余分块先以近似结果显示，后续帧补绘。
+size_t TILES_PER_FRAME = 4;
+// 每帧绘制分块的时间上限（毫秒），超时的分块留待后续帧绘制，翻页时不必等待旧页绘制完成。
+int FRAME_RENDER_MS = 40;
 
 // -------- create_image_surface() --------
 SDL_Surface *create_image_surface(int width, int height, int bpp){
@@ -345,7 +350,7 @@ public:
     DocumentPtr m_document;
     size_t m_pageIndex;
 
-    std::unique_ptr<ofd::CairoRender> m_cairoRender;
+    std::unique_ptr<ofd::TileCache> m_tileCache;
 
 }; // class MySDLApp
 
@@ -355,7 +360,7 @@ MySDLApp::MySDLApp(const std::string &title, double screenWidth, double screenHe
     SDLApp(title, screenWidth, screenHeight, screenBPP),
     m_document(document), m_pageIndex(0){
 
-    m_cairoRender = utils::make_unique<ofd::CairoRender>(m_screenWidth, m_screenHeight, g_resolutionX, g_resolutionY);
+    m_tileCache = utils::make_unique<ofd::TileCache>(g_resolutionX, g_resolutionY);
 }
 
 // ======== MySDLApp::~MySDLApp() ========
@@ -400,12 +405,9 @@ void MySDLApp::OnEvent(SDL_Event event, bool &done){
         switch ( event.window.event ){
             case SDL_WINDOWEVENT_SIZE_CHANGED:
                 {
+                    // 分块与窗口大小无关，无需重建。
                     m_screenWidth = event.window.data1;
                     m_screenHeight = event.window.data2;
-
-                    if ( m_cairoRender != nullptr ){
-                        m_cairoRender->Rebuild(m_screenWidth, m_screenHeight, g_resolutionX, g_resolutionY);
-                    }
                 } break;
         }; break;
     };
@@ -414,7 +416,7 @@ void MySDLApp::OnEvent(SDL_Event event, bool &done){
 // ======== MySDLApp::OnRender() ========
 void MySDLApp::OnRender(cairo_surface_t *surface){
     //if ( m_document != nullptr ){
-    if ( m_document != nullptr && m_cairoRender != nullptr ){
+    if ( m_document != nullptr && m_tileCache != nullptr ){
         size_t totalPages = m_document->GetNumPages();
         if ( totalPages > 0 ){
             PagePtr page = m_document->GetPage(m_pageIndex);
@@ -443,16 +445,16 @@ void MySDLApp::OnRender(cairo_surface_t *surface){
 
                 //LOG(DEBUG) << "delta: " << delta << " factor: " << factor << " scaling=" << scaling << " offset=(" << pixelX << "," << pixelY << ")";
 
-                m_cairoRender->SaveState();
-                //if ( pixelX != m_origPixelX || pixelY != m_origPixelY || scaling != m_origScaling ){
-                    ofd::VisibleParams visibleParams = std::make_tuple(pixelX, pixelY, scaling);
-                    m_cairoRender->DrawPage(page, visibleParams);
-                    m_origPixelX = pixelY;
-                    m_origPixelY = pixelY;
-                    m_origScaling = scaling;
-                //}
-                m_cairoRender->Paint(surface);
-                m_cairoRender->RestoreState();
+                // 由分块缓存合成可见区域，只绘制新露出或缩放后缺失的分块。
+                ofd::VisibleParams visibleParams = std::make_tuple(pixelX, pixelY, scaling);
+                ofd::DrawControl drawControl;
+                drawControl.SetTimeout(std::chrono::milliseconds(FRAME_RENDER_MS));
+                cairo_t *cr = cairo_create(surface);
+                m_tileCache->DrawViewport(cr, page, visibleParams, m_screenWidth, m_screenHeight, TILES_PER_FRAME, drawControl);
+                cairo_destroy(cr);
+                m_origPixelX = pixelX;
+                m_origPixelY = pixelY;
+                m_origScaling = scaling;
             } else {
                 LOG(ERROR) << "page->Open() failed. pageIndex=" << m_pageIndex;
             }
@@ -31,6 +31,7 @@
 #endif
 
 #include "FontOutputDev.h"
+#include "ofd/SystemFontIndex.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 #include "utils/ffw.h"
@@ -890,13 +891,24 @@ void FontOutputDev::installExternalFont(GfxFont * font, FontInfo & info){
         LOG(ERROR) << "Warning: workaround for font names in bad encodings.";
     }
 
-    GfxFontLoc * localfontloc = font->locateFont(m_xref, nullptr);
+    // 先查系统字体索引，只有同名字体不存在时才由poppler定位替代字体。
+    std::string fontPath;
+    bool substitute = false;
+    bool found = false;
+    std::tie(fontPath, substitute, found) = ofd::SystemFontIndex::GlobalInstance().FindFont(fontname, font->isBold(), font->isItalic());
+    if ( !found || substitute ){
+        GfxFontLoc * localfontloc = font->locateFont(m_xref, nullptr);
+        if ( localfontloc != nullptr ){
+            fontPath = std::string(localfontloc->path->getCString());
+            found = true;
+            delete localfontloc;
+        }
+    }
 
     if(m_param.embedExternalFont) {
-        if(localfontloc != nullptr) {
-            embedFont(std::string(localfontloc->path->getCString()), font, info);
+        if(found) {
+            embedFont(fontPath, font, info);
             //export_remote_font(info, m_param.fontFormat, font);
-            delete localfontloc;
             return;
         } else {
             LOG(ERROR) << "Cannot embed external font: f" << std::hex << info.id << std::dec << ' ' << fontname ;
@@ -905,10 +917,9 @@ void FontOutputDev::installExternalFont(GfxFont * font, FontInfo & info){
     }
 
     // still try to get an idea of read ascent/descent
-    if(localfontloc != nullptr) {
+    if(found) {
         // fill in ascent/descent only, do not embed
-        embedFont(std::string(localfontloc->path->getCString()), font, info, true);
-        delete localfontloc;
+        embedFont(fontPath, font, info, true);
     } else {
         info.ascent = font->getAscent();
         info.descent = font->getDescent();
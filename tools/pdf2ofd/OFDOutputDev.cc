@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <assert.h>
+#include <string.h>
 
 #include <GlobalParams.h>
 
@@ -11,6 +12,7 @@
 #include "ofd/Page.h"
 #include "ofd/Font.h"
 #include "ofd/DrawState.h"
+#include "ofd/SurfacePool.h"
 #include "utils/logger.h"
 
 
@@ -317,6 +319,8 @@ void OFDOutputDev::ProcessDoc(PDFDocPtr pdfDoc){
     if ( pdfDoc == nullptr ) return;
     m_pdfDoc = pdfDoc;
     m_xref = pdfDoc->getXRef();
+    // 对象引用只在同一PDF文件内有效。
+    m_imagesByRef.clear();
 
     preProcess(pdfDoc);
 
@@ -344,7 +348,12 @@ void OFDOutputDev::ProcessDoc(PDFDocPtr pdfDoc){
         double output_w, output_h;
         getOutputSize(pg_w, pg_h, &output_w, &output_h);
 
-        m_cairoRender = std::make_shared<ofd::CairoRender>(output_w, output_h, m_resolutionX, m_resolutionY);
+        // 各页复用同一个CairoRender，尺寸相同时只重置上下文。
+        if ( m_cairoRender == nullptr ){
+            m_cairoRender = std::make_shared<ofd::CairoRender>(output_w, output_h, m_resolutionX, m_resolutionY);
+        } else {
+            m_cairoRender->Rebuild(output_w, output_h, m_resolutionX, m_resolutionY);
+        }
         const DrawState &drawState = m_cairoRender->GetDrawState();
         //// FIXME debug 涠变色缺陷调试
         if ( drawState.Debug.Enabled && drawState.Debug.PageDrawing != (size_t)pg ) continue;
@@ -482,7 +491,13 @@ void OFDOutputDev::beforePage(double w, double h) {
         cairo_surface_set_fallback_resolution(m_outputSurface, m_resolutionX, m_resolutionY);
 
     } else {
-        m_outputSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceil(w), ceil(h));
+        // 页面图像表面借自表面池，afterPage()中归还，清为透明与新建表面一致。
+        m_outputSurface = ofd::SurfacePool::GlobalInstance().Acquire(CAIRO_FORMAT_ARGB32, ceil(w), ceil(h));
+        if ( cairo_surface_status(m_outputSurface) == CAIRO_STATUS_SUCCESS ){
+            memset(cairo_image_surface_get_data(m_outputSurface), 0,
+                    (size_t)cairo_image_surface_get_stride(m_outputSurface) * cairo_image_surface_get_height(m_outputSurface));
+            cairo_surface_mark_dirty(m_outputSurface);
+        }
 
         //int imageWidth = w;//794;
         //int imageHeight = h;//1122;
@@ -503,19 +518,18 @@ void OFDOutputDev::afterPage(const std::string &imageFileName){
     } else {
         // TODO
         writeCairoSurfaceImage(m_outputSurface, imageFileName);
-        cairo_surface_finish(m_outputSurface);
         cairo_status_t status = cairo_surface_status(m_outputSurface);
         if (status){
             LOG(ERROR) << "cairo error: " << cairo_status_to_string(status);
         }
-        cairo_surface_destroy(m_outputSurface);
+        ofd::SurfacePool::GlobalInstance().Release(m_outputSurface);
+        m_outputSurface = nullptr;
 
 
         if ( m_cairoRender != nullptr ){
             uint64_t pageID = m_currentOFDPage->ID;
             std::string png_filename = std::string("output/pdf2ofd/Page") + std::to_string(pageID) + ".png";
             m_cairoRender->WriteToPNG(png_filename);
-            m_cairoRender = nullptr;
 
             //cairo_surface_destroy(m_imageSurface);
             //m_imageSurface = nullptr;
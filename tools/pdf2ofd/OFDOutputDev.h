@@ -2,6 +2,8 @@
 #define __OFDOUTPUTDEV_H__
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <cairo/cairo-ft.h>
 #include <OutputDev.h>
 #include "TextOutputDev.h"
@@ -372,6 +374,25 @@ private:
     void renderPage(int pg, double page_w, double page_h, double output_w, double output_h); 
 
     ofd::ObjectPtr CreateNewImageObject(GfxState *state, ofd::ImagePtr image);
+    // 灰度、RGB的DCT图像原样保存为JPEG文件，不解码再压缩为PNG。
+    bool saveDCTImageData(Stream *str, GfxImageColorMap *colorMap, int *maskColors, const std::string &filename);
+    // 黑白图像保持每像素1位，CCITT G4原样封装为TIFF，其余写为1位PNG。
+    bool saveBilevelImageData(Stream *str, int widthA, int heightA, GfxImageColorMap *colorMap, int *maskColors, ofd::ImagePtr image);
+
+    // 按内容查找已保存图像时比较的数据，哈希相同时逐字节确认，不依赖哈希唯一。
+    // 像素数据不常驻内存，确认时与已写出的数据文件比较。
+    typedef struct ImageContent{
+        int Width;
+        int Height;
+        std::string Signature; // 颜色映射特征
+        std::string DataFile;  // SaveImageStream()写出的解码后数据
+        ofd::ImagePtr Image;
+    } ImageContent_t;
+
+    // 已保存到DocumentRes的图像，按PDF对象引用和内容哈希索引，
+    // 同一图像重复绘制时引用同一Image资源。
+    std::unordered_map<long long, ofd::ImagePtr> m_imagesByRef;
+    std::unordered_multimap<uint64_t, ImageContent> m_imagesByHash;
 
     std::shared_ptr<ofd::FontOutputDev> m_fontOutputDev; 
     utils::StringFormatter str_fmt;
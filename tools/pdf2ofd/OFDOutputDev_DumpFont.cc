@@ -7,6 +7,7 @@
 #include <CharCodeToUnicode.h>
 #include <fofi/FoFiTrueType.h>
 #include "OFDOutputDev.h"
+#include "ofd/SystemFontIndex.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 #include "utils/ffw.h"
@@ -752,12 +753,23 @@ void OFDOutputDev::install_external_font(GfxFont *font, FontInfo & info) {
         LOG(ERROR) << "Warning: workaround for font names in bad encodings.";
     }
 
-    GfxFontLoc * localfontloc = font->locateFont(m_xref, nullptr);
+    // 先查系统字体索引，只有同名字体不存在时才由poppler定位替代字体。
+    string fontPath;
+    bool substitute = false;
+    bool found = false;
+    std::tie(fontPath, substitute, found) = ofd::SystemFontIndex::GlobalInstance().FindFont(fontname, font->isBold(), font->isItalic());
+    if ( !found || substitute ){
+        GfxFontLoc * localfontloc = font->locateFont(m_xref, nullptr);
+        if ( localfontloc != nullptr ){
+            fontPath = string(localfontloc->path->getCString());
+            found = true;
+            delete localfontloc;
+        }
+    }
 
     if(embed_external_font) {
-        if(localfontloc != nullptr) {
-            embed_font(string(localfontloc->path->getCString()), font, info);
-            delete localfontloc;
+        if(found) {
+            embed_font(fontPath, font, info);
             return;
         } else {
             LOG(ERROR) << "Cannot embed external font: f" << hex << info.id << dec << ' ' << fontname;
@@ -766,10 +778,9 @@ void OFDOutputDev::install_external_font(GfxFont *font, FontInfo & info) {
     }
 
     // still try to get an idea of read ascent/descent
-    if(localfontloc != nullptr) {
+    if(found) {
         // fill in ascent/descent only, do not embed
-        embed_font(string(localfontloc->path->getCString()), font, info, true);
-        delete localfontloc;
+        embed_font(fontPath, font, info, true);
     } else {
         info.ascent = font->getAscent();
         info.descent = font->getDescent();
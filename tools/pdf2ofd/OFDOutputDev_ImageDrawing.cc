@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <vector>
 #include <splash/SplashBitmap.h>
 #include <JBIG2Stream.h>
 #include "OFDOutputDev.h"
@@ -8,6 +10,9 @@
 #include "ofd/Image.h"
 #include "ofd/CairoRender.h"
 #include "utils/logger.h"
+#include "utils/utils.h"
+
+long long hash_ref(const Ref * id);
 
 
 //static inline int splashRound(SplashCoord x) {
@@ -345,6 +350,303 @@ ofd::ObjectPtr OFDOutputDev::CreateNewImageObject(GfxState *state, ofd::ImagePtr
     return object;
 }
 
+// 只处理解码后颜色与JPEG文件自身一致的情形：灰度或RGB、恒等的Decode、
+// 无颜色键掩码、未用ColorTransform改变YCbCr转换。
+bool OFDOutputDev::saveDCTImageData(Stream *str, GfxImageColorMap *colorMap, int *maskColors, const std::string &filename){
+    if ( str->getKind() != strDCT || maskColors != nullptr ) return false;
+    if ( !colorMapHasIdentityDecodeMap(colorMap) ) return false;
+
+    GfxColorSpace *colorSpace = colorMap->getColorSpace();
+    switch ( colorSpace->getMode() ){
+        case csDeviceGray:
+        case csCalGray:
+        case csDeviceRGB:
+        case csCalRGB:
+            break;
+        case csICCBased:
+            if ( colorSpace->getNComps() != 1 && colorSpace->getNComps() != 3 ) return false;
+            break;
+        default:
+            return false;
+    }
+
+    Object obj;
+    str->getDict()->lookup("ColorTransform", &obj);
+    bool hasColorTransform = !obj.isNull();
+    obj.free();
+    if ( hasColorTransform ) return false;
+
+    char *strBuffer = nullptr;
+    int len = 0;
+    if ( !getStreamData(str->getNextStream(), &strBuffer, &len) ) return false;
+
+    std::ofstream jpgFile;
+    jpgFile.open(filename.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    bool ok = jpgFile.is_open();
+    if ( ok ){
+        jpgFile.write(strBuffer, len);
+        jpgFile.close();
+        ok = !jpgFile.fail();
+    }
+    gfree(strBuffer);
+
+    if ( !ok ){
+        LOG(WARNING) << "Write JPEG image file " << filename << " failed.";
+    }
+    return ok;
+}
+
+// cairo的A1格式按32位字存放，位序与平台字节序一致。
+static inline void setMonoPixel(uint8_t *row, int x){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+#else
+    row[x >> 3] |= (uint8_t)(1 << (x & 7));
+#endif
+}
+
+// 每像素1位、两个值分别为纯黑和纯白时返回黑色的像素值，否则返回-1。
+static int getBilevelBlackBit(GfxImageColorMap *colorMap, int *maskColors){
+    if ( maskColors != nullptr || colorMap->getNumPixelComps() != 1 || colorMap->getBits() != 1 ) return -1;
+
+    GfxGray gray[2];
+    for ( int i = 0 ; i < 2 ; i++ ){
+        Guchar pix = (Guchar)i;
+        colorMap->getGray(&pix, &gray[i]);
+        if ( gray[i] != 0 && gray[i] != gfxColorComp1 ) return -1;
+    }
+    if ( gray[0] == gray[1] ) return -1;
+    return gray[0] == 0 ? 0 : 1;
+}
+
+typedef struct CCITTParams{
+    int K;
+    bool EncodedByteAlign;
+    int Columns;
+    int Rows;
+    bool BlackIs1;
+
+    CCITTParams() :
+        K(0), EncodedByteAlign(false), Columns(1728), Rows(0), BlackIs1(false){
+    }
+} CCITTParams_t;
+
+static void readCCITTParams(Dict *dict, CCITTParams &params){
+    Object obj;
+    dict->lookup("K", &obj);
+    if ( obj.isInt() ) params.K = obj.getInt();
+    obj.free();
+    dict->lookup("EncodedByteAlign", &obj);
+    if ( obj.isBool() ) params.EncodedByteAlign = obj.getBool();
+    obj.free();
+    dict->lookup("Columns", &obj);
+    if ( obj.isInt() ) params.Columns = obj.getInt();
+    obj.free();
+    dict->lookup("Rows", &obj);
+    if ( obj.isInt() ) params.Rows = obj.getInt();
+    obj.free();
+    dict->lookup("BlackIs1", &obj);
+    if ( obj.isBool() ) params.BlackIs1 = obj.getBool();
+    obj.free();
+}
+
+// CCITTFaxDecode是最外层的滤镜，滤镜为数组时取DecodeParms数组的最后一项。
+static CCITTParams getCCITTParams(Stream *str){
+    CCITTParams params;
+    Object decodeParms;
+    str->getDict()->lookup("DecodeParms", &decodeParms);
+    if ( decodeParms.isNull() ){
+        decodeParms.free();
+        str->getDict()->lookup("DP", &decodeParms);
+    }
+    if ( decodeParms.isDict() ){
+        readCCITTParams(decodeParms.getDict(), params);
+    } else if ( decodeParms.isArray() && decodeParms.arrayGetLength() > 0 ){
+        Object last;
+        decodeParms.arrayGet(decodeParms.arrayGetLength() - 1, &last);
+        if ( last.isDict() ){
+            readCCITTParams(last.getDict(), params);
+        }
+        last.free();
+    }
+    decodeParms.free();
+    return params;
+}
+
+// 1位A4扫描件（300 DPI）展开为RGBA约35MB，保持1位只有约1MB。
+// 纯G4数据（K < 0，无字节对齐）原样封装为TIFF；OFD阅读器没有JBIG2解码，
+// JBIG2及其它滤镜的黑白图像由poppler解码后写为1位PNG。
+bool OFDOutputDev::saveBilevelImageData(Stream *str, int widthA, int heightA, GfxImageColorMap *colorMap, int *maskColors, ofd::ImagePtr image){
+    int blackBit = getBilevelBlackBit(colorMap, maskColors);
+    if ( blackBit < 0 ) return false;
+
+    if ( str->getKind() == strCCITTFax ){
+        CCITTParams params = getCCITTParams(str);
+        char *strBuffer = nullptr;
+        int len = 0;
+        if ( params.K < 0 && !params.EncodedByteAlign && params.Columns == widthA &&
+                (params.Rows == 0 || params.Rows == heightA) &&
+                getStreamData(str->getNextStream(), &strBuffer, &len) ){
+            // poppler解码时黑色游程输出为BlackIs1，与显示为黑色的像素值不同时黑白互换。
+            bool invert = (params.BlackIs1 ? 1 : 0) != blackBit;
+            std::string tifFileName = "/tmp/" + ofd::generateImageFileName(image->ID, ofd::ImageFormat::TIFF);
+            bool ok = false;
+            FILE *file = fopen(tifFileName.c_str(), "wb");
+            if ( file != nullptr ){
+                ok = ofd::WriteCCITTG4TIFF((const uint8_t*)strBuffer, len, widthA, heightA, invert,
+                        [file](const uint8_t *data, size_t length){
+                            return fwrite(data, 1, length, file) == length;
+                        });
+                if ( fclose(file) != 0 ) ok = false;
+            }
+            gfree(strBuffer);
+            if ( ok ){
+                image->Format = ofd::ImageFormat::TIFF;
+                return true;
+            }
+            LOG(WARNING) << "Write TIFF image file " << tifFileName << " failed.";
+        }
+    }
+
+    // A1表面1为白色，由编码器写为1位灰度PNG。
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A1, widthA, heightA);
+    if ( cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS ){
+        cairo_surface_destroy(surface);
+        return false;
+    }
+    uint8_t *data = cairo_image_surface_get_data(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+    memset(data, 0, (size_t)stride * heightA);
+
+    ImageStream imgStr(str, widthA, 1, 1);
+    imgStr.reset();
+    for ( int y = 0 ; y < heightA ; y++ ){
+        Guchar *line = imgStr.getLine();
+        if ( line == nullptr ) break;
+        uint8_t *row = data + (size_t)y * stride;
+        for ( int x = 0 ; x < widthA ; x++ ){
+            if ( line[x] != blackBit ){
+                setMonoPixel(row, x);
+            }
+        }
+    }
+    imgStr.close();
+    cairo_surface_mark_dirty(surface);
+
+    ofd::EncodeParams params;
+    params.Format = ofd::ImageFormat::PNG;
+    params.ColorMode = ofd::ImageColorMode::Mono;
+    std::string pngFileName = "/tmp/" + ofd::generateImageFileName(image->ID, ofd::ImageFormat::PNG);
+    bool ok = ofd::ImageEncoderFactory::CreateEncoder(params)->EncodeToFile(surface, pngFileName);
+    cairo_surface_destroy(surface);
+
+    return ok;
+}
+
+// 颜色映射的特征，相同数据在特征相同时绘制结果相同。
+// 只处理设备、ICC和以它们为基的索引颜色空间，其余返回false。
+static bool getColorMapSignature(GfxImageColorMap *colorMap, int *maskColors, std::string &signature){
+    GfxColorSpace *colorSpace = colorMap->getColorSpace();
+    GfxColorSpace *baseColorSpace = colorSpace;
+    GfxIndexedColorSpace *indexedColorSpace = nullptr;
+    if ( colorSpace->getMode() == csIndexed ){
+        indexedColorSpace = (GfxIndexedColorSpace*)colorSpace;
+        baseColorSpace = indexedColorSpace->getBase();
+    }
+    GfxColorSpaceMode baseMode = baseColorSpace->getMode();
+    switch ( baseMode ){
+        case csDeviceGray:
+        case csDeviceRGB:
+        case csDeviceCMYK:
+            break;
+        case csICCBased:
+            baseMode = ((GfxICCBasedColorSpace*)baseColorSpace)->getAlt()->getMode();
+            break;
+        default:
+            return false;
+    }
+
+    int nComps = colorMap->getNumPixelComps();
+    std::vector<double> values;
+    values.push_back(colorSpace->getMode());
+    values.push_back(baseMode);
+    values.push_back(baseColorSpace->getNComps());
+    values.push_back(nComps);
+    values.push_back(colorMap->getBits());
+    for ( int i = 0 ; i < nComps ; i++ ){
+        values.push_back(colorMap->getDecodeLow(i));
+        values.push_back(colorMap->getDecodeHigh(i));
+    }
+    if ( maskColors != nullptr ){
+        for ( int i = 0 ; i < 2 * nComps ; i++ ){
+            values.push_back(maskColors[i]);
+        }
+    }
+    signature.assign((const char*)values.data(), values.size() * sizeof(double));
+    if ( indexedColorSpace != nullptr ){
+        signature.append((const char*)indexedColorSpace->getLookup(),
+                (size_t)(indexedColorSpace->getIndexHigh() + 1) * baseColorSpace->getNComps());
+    }
+    return true;
+}
+
+// 按行读取解码后的数据计算哈希，尺寸和颜色映射特征一并计入。
+static bool hashImageStream(Stream *str, int widthA, int heightA, GfxImageColorMap *colorMap, int *maskColors,
+        uint64_t &hash, std::string &signature){
+    if ( !getColorMapSignature(colorMap, maskColors, signature) ) return false;
+
+    ofd::ImageDataHead imageDataHead(widthA, heightA, colorMap->getNumPixelComps(), colorMap->getBits());
+    int lineSize = imageDataHead.GetLineSize();
+    if ( lineSize <= 0 ) return false;
+
+    uint64_t parts[2];
+    parts[0] = utils::HashData(&imageDataHead, sizeof(imageDataHead));
+    parts[1] = utils::HashData(signature.data(), signature.size());
+    hash = utils::HashData(parts, sizeof(parts));
+
+    std::vector<uint8_t> line(lineSize);
+    str->reset();
+    for ( int y = 0 ; y < heightA ; y++ ){
+        int readChars = str->doGetChars(lineSize, line.data());
+        if ( readChars < lineSize ){
+            memset(line.data() + std::max(readChars, 0), 0, lineSize - std::max(readChars, 0));
+        }
+        parts[0] = hash;
+        parts[1] = utils::HashData(line.data(), lineSize);
+        hash = utils::HashData(parts, sizeof(parts));
+    }
+    str->close();
+    return true;
+}
+
+// 哈希相同时将数据流与已保存图像的数据文件（SaveImageStream()写出）逐行比较，
+// 内存中不保留已保存图像的数据。
+static bool isSameImageData(const std::string &dataFile, Stream *str, int widthA, int heightA, int nComps, int nBits){
+    std::ifstream datFile(dataFile.c_str(), std::ios::binary | std::ios::in);
+    if ( !datFile.is_open() ) return false;
+
+    ofd::ImageDataHead imageDataHead(widthA, heightA, nComps, nBits);
+    ofd::ImageDataHead savedHead;
+    if ( !datFile.read((char*)&savedHead, sizeof(savedHead)) ||
+            memcmp(&savedHead, &imageDataHead, sizeof(imageDataHead)) != 0 ){
+        return false;
+    }
+
+    int lineSize = imageDataHead.GetLineSize();
+    std::vector<uint8_t> line(lineSize);
+    std::vector<char> savedLine(lineSize);
+    bool same = true;
+    str->reset();
+    for ( int y = 0 ; y < heightA && same ; y++ ){
+        int readChars = str->doGetChars(lineSize, line.data());
+        if ( readChars <= 0 ) continue;
+        same = (bool)datFile.read(savedLine.data(), readChars) &&
+            memcmp(savedLine.data(), line.data(), readChars) == 0;
+    }
+    str->close();
+    return same && datFile.peek() == std::char_traits<char>::eof();
+}
+
 void OFDOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
 			       int widthA, int heightA,
 			       GfxImageColorMap *colorMap,
@@ -352,19 +654,59 @@ void OFDOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
 			       int *maskColors, GBool inlineImg) {
 
 
+    // -------- 查找已保存的相同图像 --------
+    // 先按PDF对象引用，再按解码后数据的哈希。内联图像的数据流不能重复读取，不计算哈希。
+    ofd::ImagePtr image = nullptr;
+    long long refKey = 0;
+    bool hasRef = ref != nullptr && ref->isRef();
+    if ( hasRef ){
+        Ref imageRef = ref->getRef();
+        refKey = hash_ref(&imageRef);
+        auto iter = m_imagesByRef.find(refKey);
+        if ( iter != m_imagesByRef.end() ){
+            image = iter->second;
+        }
+    }
+    uint64_t imageHash = 0;
+    ImageContent content;
+    bool hashed = false;
+    if ( image == nullptr && !inlineImg ){
+        hashed = hashImageStream(str, widthA, heightA, colorMap, maskColors, imageHash, content.Signature);
+        if ( hashed ){
+            auto range = m_imagesByHash.equal_range(imageHash);
+            for ( auto iter = range.first ; iter != range.second ; iter++ ){
+                const ImageContent &saved = iter->second;
+                if ( saved.Width == widthA && saved.Height == heightA &&
+                        saved.Signature == content.Signature &&
+                        isSameImageData(saved.DataFile, str, widthA, heightA, colorMap->getNumPixelComps(), colorMap->getBits()) ){
+                    image = saved.Image;
+                    break;
+                }
+            }
+            if ( image != nullptr && hasRef ){
+                m_imagesByRef[refKey] = image;
+            }
+        }
+    }
+    bool newImage = image == nullptr;
+
     //// -------- Write image stream to zip file. --------
-    ofd::ImagePtr image = std::make_shared<ofd::Image>();
+    if ( newImage ){
+        image = std::make_shared<ofd::Image>();
+    }
     uint64_t imageID = image->ID;
 
-    __attribute__((unused)) std::string jpgFileName = "/tmp/Image_" + std::to_string(imageID) + ".jpg";
-    __attribute__((unused)) std::string pngFileName = "/tmp/Image_" + std::to_string(imageID) + ".png";
+    std::string jpgFileName = "/tmp/Image_" + std::to_string(imageID) + ".jpg";
+    std::string pngFileName = "/tmp/Image_" + std::to_string(imageID) + ".png";
 
 
     __attribute__((unused)) std::string imageDataFile = "/tmp/Image_" + std::to_string(imageID) + ".dat";
 
-    int nComps = colorMap->getNumPixelComps();
-    int nBits = colorMap->getBits();
-    SaveImageStream(imageDataFile, str, widthA, heightA, nComps, nBits);
+    if ( newImage ){
+        int nComps = colorMap->getNumPixelComps();
+        int nBits = colorMap->getBits();
+        SaveImageStream(imageDataFile, str, widthA, heightA, nComps, nBits);
+    }
 
     //std::ofstream imgFile(strImageFileName, std::ios::binary | std::ios::out);
     //int row = 0;
@@ -398,11 +740,30 @@ void OFDOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
         return;
 
     //writeCairoSurfaceImage(imageSurface, jpgFileName);
-    cairo_surface_write_to_png(imageSurface, pngFileName.c_str());
+    if ( newImage ){
+        if ( saveBilevelImageData(str, widthA, heightA, colorMap, maskColors, image) ){
+            // 保持每像素1位，Format已按保存的文件设置。
+        } else if ( !inlineImg && saveDCTImageData(str, colorMap, maskColors, jpgFileName) ){
+            image->Format = ofd::ImageFormat::JPEG;
+        } else {
+            cairo_surface_write_to_png(imageSurface, pngFileName.c_str());
+        }
+
+        ofd::Document::CommonData &commonData = m_document->GetCommonData();
+        assert(commonData.DocumentRes != nullptr );
+        commonData.DocumentRes->AddImage(image);
 
-    ofd::Document::CommonData &commonData = m_document->GetCommonData();
-    assert(commonData.DocumentRes != nullptr );
-    commonData.DocumentRes->AddImage(image);
+        if ( hasRef ){
+            m_imagesByRef[refKey] = image;
+        }
+        if ( hashed ){
+            content.Width = widthA;
+            content.Height = heightA;
+            content.DataFile = imageDataFile;
+            content.Image = image;
+            m_imagesByHash.insert(std::make_pair(imageHash, std::move(content)));
+        }
+    }
 
     // Add image object into current page.
     ofd::ObjectPtr imageObject = CreateNewImageObject(state, image);
@@ -260,6 +260,8 @@ void OFDOutputDev::drawChar(GfxState *state, double x, double y,
 
     if ( m_currentFont != nullptr ) {
         m_cairoGlyphs[m_glyphsCount].index = m_currentFont->GetGlyph (code, u, uLen);
+        // 没有对应Unicode的字符按字形编号保留在字体子集中。
+        m_currentFont->AddUsedGlyph(m_cairoGlyphs[m_glyphsCount].index);
         m_cairoGlyphs[m_glyphsCount].x = x - originX;
         m_cairoGlyphs[m_glyphsCount].y = y - originY;
         m_glyphsCount++;
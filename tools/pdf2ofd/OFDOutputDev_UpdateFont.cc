@@ -282,8 +282,10 @@ void OFDOutputDev::updateFont(GfxState *state){
                     int *codeToGID = nullptr;
                     size_t codeToGIDLen = 0;
                     std::tie(codeToGID, codeToGIDLen) = getCodeToGID(gfxFont, dumpFontData, dumpFontDataSize);
-                    ofdFont->m_codeToGID = codeToGID;
-                    ofdFont->m_codeToGIDLen = codeToGIDLen;
+                    if ( codeToGID != nullptr ){
+                        ofdFont->SetCodeToGID(ofd::CodeToGIDMap::FromArray(codeToGID, codeToGIDLen));
+                        gfree(codeToGID);
+                    }
 
                     //ofdFont->m_fontData = dumpFontData;
                     //ofdFont->m_fontDataSize = dumpFontDataSize;
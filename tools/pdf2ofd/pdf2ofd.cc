@@ -14,6 +14,7 @@
 #include "OFDOutputDev.h"
 #include "FontOutputDev.h"
 #include "ofd/Package.h"
+#include "ofd/Document.h"
 #include "utils/logger.h"
 
 std::shared_ptr<PDFDoc> OpenPDFFile(const std::string &pdfFilename, const std::string &ownerPassword, const std::string &userPassword){
@@ -57,6 +58,7 @@ std::shared_ptr<PDFDoc> OpenPDFFile(const std::string &pdfFilename, const std::s
 DEFINE_int32(v, 0, "Logger level.");
 DEFINE_string(owner_password, "", "The owner password of PDF file.");
 DEFINE_string(user_password, "", "The user password of PDF file.");
+DEFINE_int32(template_min_objects, 8, "Min number of repeated objects factored into a template page, 0 disables.");
 
 
 int main(int argc, char *argv[]){
@@ -100,6 +102,15 @@ int main(int argc, char *argv[]){
         ofdOut->ProcessDoc(pdfDoc);
         ofdOut = nullptr;
 
+        // 多页重复的页面内容提取为模板页。
+        if ( FLAGS_template_min_objects > 0 ){
+            ofd::DocumentPtr document = package->GetDefaultDocument();
+            if ( document != nullptr ){
+                size_t numTemplates = document->FactorTemplatePages(FLAGS_template_min_objects);
+                LOG(INFO) << numTemplates << " template pages factored.";
+            }
+        }
+
         package->Save(packageName);
 
 
@@ -57,6 +57,16 @@ namespace utils{
         return ok;
     }
 
+    uint64_t HashData(const void *data, size_t dataSize){
+        const uint8_t *p = (const uint8_t*)data;
+        uint64_t hash = 14695981039346656037ULL;
+        for ( size_t i = 0 ; i < dataSize ; i++ ){
+            hash ^= p[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
     bool FileExist(const std::string &fileName) {
         if ( access(fileName.c_str(), F_OK) == 0 ){
             return true;
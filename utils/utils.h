@@ -38,6 +38,9 @@ namespace utils{
     std::tuple<char*, size_t, bool> ReadFileData(const std::string &filename);
     bool WriteFileData(const std::string &filename, const char *data, size_t dataSize); 
 
+    // 64位FNV-1a哈希，用于按内容识别字体、图像等数据。
+    uint64_t HashData(const void *data, size_t dataSize);
+
     static inline bool equal(double x, double y) { return fabs(x-y) <= EPS; }
 
     // IO